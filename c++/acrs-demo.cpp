@@ -18,44 +18,134 @@
  */
 
 #include <list>
+#include <vector>
+#include <iterator>
 #include <sstream>
 #include <cstdio>
 
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <arpa/inet.h>
 #include <assert.h>
 
 #include "acrs.hpp"
+#include "acrsarena.hpp"
+#include "acrsmem.hpp"
+#include "acrsdiff.hpp"
+#include "acrsverify.hpp"
 #include "route.hpp"
 #include "route4.hpp"
 #include "route6.hpp"
 #include "addr.hpp"
+#include "cidrparse.hpp"
+#include "routewriter.hpp"
+#include "routetable.hpp"
+#include "routelookup.hpp"
+#include "mrtreader.hpp"
 
-#define OPTIONS "lh46m:"
+#define OPTIONS "lshVM46m:e:j:n:f:b:o:r:a:d:D:q:A:"
 
-template <class T> bool getList(T & rt_list, int numrts, char * p_rts[],
-                                int ipstr_len, int addr_family);
+/* Size of each read() when routes come from a pipe or terminal */
+#define READ_BUF_SIZE (1024 * 1024)
+
+/* Route lists keep their nodes in an Acrs::Arena, chosen with -A */
+typedef std::list<IP::Route4, Acrs::ArenaAllocator<IP::Route4> > RouteList4;
+typedef std::list<IP::Route6, Acrs::ArenaAllocator<IP::Route6> > RouteList6;
+
+/* Settings taken from the command line */
+typedef struct demoOptions
+{
+    bool logging;
+    bool stats;
+    bool verify;                /* -V, check the summary against the input */
+    const char * p_file;        /* -f, text prefixes */
+    const char * p_table;       /* -b, binary route table */
+    const char * p_mrt;         /* -r, MRT RIB dump */
+    const char * p_out;         /* -o, binary route table output */
+    const char * p_diff;        /* -d or -D, routes to compare against */
+    bool diff_space;            /* -D, compare by address space */
+    const char * p_query;       /* -q, addresses to look up */
+    int metric_style;
+    int engine;
+    int threads;
+    int mrt_metric;
+    size_t max_routes;          /* -n, 0 for no budget */
+    int backing;                /* -A, or -1 to not report allocations */
+    int family;                 /* 4 or 6, from -4, -6 or the -b table */
+    Acrs::MemProfile * p_memory;    /* -M, or NULL to not profile */
+} demoOptions;
+
+template <class T> bool getList(T & rt_list, int numrts, char * p_rts[]);
+template <class T> bool readList(T & rt_list, const char * p_path);
+template <class T> bool readMrt(T & rt_list, const char * p_path,
+                                IP::MrtReader::MetricSource source);
 template <class T> int runSummary(T & rt_list, int numrts, char * p_rts[],
-                                  bool logging, int metric_style,
-                                  int ipstr_len, int addr_family);
-bool getRoute(char * p_prefix, char * ipstr, int * plen_int, int * metric_int,
-              int ipstr_len, int addr_family);
-bool validateRoute(const char * p_prefix);
+                                  const IP::RouteTable * p_table,
+                                  const demoOptions & opts);
+template <class P> int runTable(IP::RouteTable & table,
+                                const demoOptions & opts);
+template <class I> bool writeResults(I first, I last,
+                                     const demoOptions & opts);
+template <class T> bool writeDiff(const T & rt_list,
+                                  const demoOptions & opts);
+template <class I> bool writeLookups(I first, I last,
+                                     const demoOptions & opts);
+template <class I> bool checkSummary(Acrs::Verifier & verifier,
+                                     I first, I last);
+template <class R, class I, class T> void runDiff(Acrs::RouteDiff<R> & diff,
+                                                   I first, I last,
+                                                   const T & rt_list,
+                                                   const demoOptions & opts);
+void setupSummary(Acrs::Acrs & summary, Acrs::Stats & stats,
+                  const demoOptions & opts);
+void setupVerifier(Acrs::Verifier & verifier, const demoOptions & opts);
+void reportBudget(Acrs::Acrs & summary, size_t routes,
+                  const demoOptions & opts);
+void reportArena(const Acrs::Arena & arena, const demoOptions & opts);
+void memPhase(const demoOptions & opts, const char * p_name);
+void addTable(RouteList4 & rt_list, const IP::RouteTable & table);
+void addTable(RouteList6 & rt_list, const IP::RouteTable & table);
+bool diffTable(Acrs::RouteDiff<IP::Route4> & diff,
+               const IP::RouteTable & table,
+               const RouteList4 & rt_list,
+               const demoOptions & opts);
+bool diffTable(Acrs::RouteDiff<IP::Route6> & diff,
+               const IP::RouteTable & table,
+               const RouteList6 & rt_list,
+               const demoOptions & opts);
+bool isTableFile(const char * p_path);
+bool readFile(const char * p_path, std::string & text);
+bool isSpace(char c);
+bool addRoute(RouteList4 & rt_list, const char * p_prefix,
+              size_t len, IP::ParseError & err);
+bool addRoute(RouteList6 & rt_list, const char * p_prefix,
+              size_t len, IP::ParseError & err);
+bool addMrt(RouteList4 & rt_list, IP::MrtReader & reader);
+bool addMrt(RouteList6 & rt_list, IP::MrtReader & reader);
 int findMetricStyle(const char * metric);
 std::string getMetricStyleString(int spaces);
+int findEngine(const char * engine);
+std::string getEngineString(int spaces);
+int findMrtMetric(const char * mrt_metric);
+std::string getMrtMetricString(int spaces);
+int findBacking(const char * backing);
+std::string getBackingString(int spaces);
 void usage();
 
 #define METRIC_STYLES \
-    STYLE(METRIC_STYLE_NONE, none, \
+    STYLE(METRIC_STYLE_NONE, none, IP::RouteWriter::METRIC_NONE, \
           "Do not print a metric") \
-    STYLE(METRIC_STYLE_FULL, full, \
+    STYLE(METRIC_STYLE_FULL, full, IP::RouteWriter::METRIC_FULL, \
           "Print metric X as '... in X' (default)") \
-    STYLE(METRIC_STYLE_BRIEF, brief, \
+    STYLE(METRIC_STYLE_BRIEF, brief, IP::RouteWriter::METRIC_BRIEF, \
           "Print metric X as '...mX'")
 
-#define STYLE(longname, shortname, desc) longname,
+#define STYLE(longname, shortname, value, desc) longname,
 enum
 {
     METRIC_STYLES
@@ -67,39 +157,255 @@ typedef struct metricType
 {
     std::string name;
     std::string desc;
+    IP::RouteWriter::Style style;
 } metricType;
 
-#define STYLE(longname, shortname, desc) { # shortname, desc },
+#define STYLE(longname, shortname, value, desc) { # shortname, desc, value },
 static metricType METRIC_TYPES[] =
 {
     METRIC_STYLES
 };
 #undef STYLE
 
+#define ENGINES \
+    ENGINE(Acrs::Acrs::ENGINE_PASS, pass, \
+           "Sort and merge pass by pass (default)") \
+    ENGINE(Acrs::Acrs::ENGINE_TRIE, trie, \
+           "Merge in a single traversal of a prefix trie") \
+    ENGINE(Acrs::Acrs::ENGINE_ORTC, ortc, \
+           "Compress to the fewest routes that forward the same by " \
+           "longest match")
+
+typedef struct engineType
+{
+    std::string name;
+    std::string desc;
+    Acrs::Acrs::Engine engine;
+} engineType;
+
+#define ENGINE(value, shortname, desc) { # shortname, desc, value },
+static engineType ENGINE_TYPES[] =
+{
+    ENGINES
+};
+#undef ENGINE
+
+#define NUM_ENGINES (sizeof(ENGINE_TYPES) / sizeof(ENGINE_TYPES[0]))
+
+#define MRT_METRICS \
+    MRT_METRIC(IP::MrtReader::METRIC_NONE, none, \
+               "Give every prefix metric 0 (default)") \
+    MRT_METRIC(IP::MrtReader::METRIC_MED, med, \
+               "Use the MULTI_EXIT_DISC attribute") \
+    MRT_METRIC(IP::MrtReader::METRIC_AS_PATH, aspath, \
+               "Use the number of ASes in the AS_PATH")
+
+typedef struct mrtMetricType
+{
+    std::string name;
+    std::string desc;
+    IP::MrtReader::MetricSource source;
+} mrtMetricType;
+
+#define MRT_METRIC(value, shortname, desc) { # shortname, desc, value },
+static mrtMetricType MRT_METRIC_TYPES[] =
+{
+    MRT_METRICS
+};
+#undef MRT_METRIC
+
+#define NUM_MRT_METRICS \
+    (sizeof(MRT_METRIC_TYPES) / sizeof(MRT_METRIC_TYPES[0]))
+
+#define BACKINGS \
+    BACKING(Acrs::Arena::BACK_HEAP, heap, \
+            "Allocate each route from the heap (default)") \
+    BACKING(Acrs::Arena::BACK_ARENA, arena, \
+            "Carve routes from large blocks, freed all at once") \
+    BACKING(Acrs::Arena::BACK_HUGE, huge, \
+            "As arena, with blocks of huge pages where available")
+
+typedef struct backingType
+{
+    std::string name;
+    std::string desc;
+    Acrs::Arena::Backing backing;
+} backingType;
+
+#define BACKING(value, shortname, desc) { # shortname, desc, value },
+static backingType BACKING_TYPES[] =
+{
+    BACKINGS
+};
+#undef BACKING
+
+#define NUM_BACKINGS (sizeof(BACKING_TYPES) / sizeof(BACKING_TYPES[0]))
+
+/* The lookup table and address type for each kind of route, and how
+ * to parse an address of its family
+ */
+template <class R> struct LookupFor;
+
+template <> struct LookupFor<IP::Route4>
+{
+    typedef IP::RouteLookup4 Lookup;
+    typedef in_addr_t Addr;
+
+    static bool parse(const char * p_text, size_t len, Addr & addr,
+                      IP::ParseError & err)
+    {
+        return IP::parseAddr4(p_text, len, addr, err);
+    };
+};
+
+template <> struct LookupFor<IP::Route6>
+{
+    typedef IP::RouteLookup6 Lookup;
+    typedef in6_addr Addr;
+
+    static bool parse(const char * p_text, size_t len, Addr & addr,
+                      IP::ParseError & err)
+    {
+        return IP::parseAddr6(p_text, len, addr, err);
+    };
+};
+
+template <> struct LookupFor<IP::Route4Packed> : LookupFor<IP::Route4> {};
+template <> struct LookupFor<IP::Route6Packed> : LookupFor<IP::Route6> {};
+
 int main(int argc, char * argv[])
 {
     extern int optind;
     char c;
-    bool logging = false;
     bool ipv4 = false;
     bool ipv6 = false;
-    int metric_style = METRIC_STYLE_FULL;
+    demoOptions opts;
+    Acrs::MemProfile memory;
+
+    opts.logging = false;
+    opts.stats = false;
+    opts.verify = false;
+    opts.p_file = 0;
+    opts.p_table = 0;
+    opts.p_mrt = 0;
+    opts.p_out = 0;
+    opts.p_diff = 0;
+    opts.diff_space = false;
+    opts.p_query = 0;
+    opts.metric_style = METRIC_STYLE_FULL;
+    opts.engine = 0;
+    opts.threads = 1;
+    opts.mrt_metric = 0;
+    opts.max_routes = 0;
+    opts.backing = -1;
+    opts.family = 4;
+    opts.p_memory = NULL;
 
     while ((c = getopt(argc, argv, OPTIONS)) != -1)
     {
         switch (c)
         {
         case 'm':
-            metric_style = findMetricStyle(optarg);
-            if (metric_style == METRIC_STYLE_INVALID)
+            opts.metric_style = findMetricStyle(optarg);
+            if (opts.metric_style == METRIC_STYLE_INVALID)
             {
                 fprintf(stderr, "Invalid metric style: %s\n"
                                 "%s", optarg, getMetricStyleString(2).c_str());
                 return 2;
             }
             break;
+        case 'e':
+            opts.engine = findEngine(optarg);
+            if (opts.engine == NUM_ENGINES)
+            {
+                fprintf(stderr, "Invalid engine: %s\n"
+                                "%s", optarg, getEngineString(2).c_str());
+                return 2;
+            }
+            break;
+        case 'A':
+            opts.backing = findBacking(optarg);
+            if (opts.backing == NUM_BACKINGS)
+            {
+                fprintf(stderr, "Invalid allocator: %s\n"
+                                "%s", optarg, getBackingString(2).c_str());
+                return 2;
+            }
+            break;
+        case 'a':
+            opts.mrt_metric = findMrtMetric(optarg);
+            if (opts.mrt_metric == NUM_MRT_METRICS)
+            {
+                fprintf(stderr, "Invalid MRT metric: %s\n"
+                                "%s", optarg, getMrtMetricString(2).c_str());
+                return 2;
+            }
+            break;
+        case 'j':
+            {
+                char * p_end;
+                long value = strtol(optarg, &p_end, 10);
+
+                if (*optarg == '\0' || *p_end != '\0' || value < 1 ||
+                    value > 1024)
+                {
+                    fprintf(stderr, "Invalid number of threads: %s\n",
+                            optarg);
+                    return 2;
+                }
+
+                opts.threads = value;
+            }
+            break;
+        case 'n':
+            {
+                char * p_end;
+                long long value = strtoll(optarg, &p_end, 10);
+
+                if (*optarg == '\0' || *p_end != '\0' || value < 1)
+                {
+                    fprintf(stderr, "Invalid number of routes: %s\n",
+                            optarg);
+                    return 2;
+                }
+
+                opts.max_routes = value;
+            }
+            break;
         case 'l':
-            logging = true;
+            opts.logging = true;
+            break;
+        case 's':
+            opts.stats = true;
+            break;
+        case 'V':
+            opts.verify = true;
+            break;
+        case 'M':
+            opts.p_memory = &memory;
+            break;
+        case 'f':
+            opts.p_file = optarg;
+            break;
+        case 'b':
+            opts.p_table = optarg;
+            break;
+        case 'r':
+            opts.p_mrt = optarg;
+            break;
+        case 'o':
+            opts.p_out = optarg;
+            break;
+        case 'd':
+            opts.p_diff = optarg;
+            opts.diff_space = false;
+            break;
+        case 'D':
+            opts.p_diff = optarg;
+            opts.diff_space = true;
+            break;
+        case 'q':
+            opts.p_query = optarg;
             break;
         case '4':
             if (ipv6 == true)
@@ -133,38 +439,99 @@ int main(int argc, char * argv[])
         }
     }
 
+    IP::RouteTable table;
+
+    if (opts.p_table != 0)
+    {
+        memPhase(opts, "load");
+
+        if (table.load(opts.p_table) == false)
+        {
+            fprintf(stderr, "Error: Could not load %s: %s\n", opts.p_table,
+                    table.getError());
+            return 2;
+        }
+
+        /* The table decides the family unless one was given */
+        if ((ipv4 == true && table.getFamily() != 4) ||
+            (ipv6 == true && table.getFamily() != 6))
+        {
+            fprintf(stderr, "Error: %s holds IPv%d routes.\n", opts.p_table,
+                    table.getFamily());
+            return 2;
+        }
+
+        ipv4 = (table.getFamily() == 4);
+        ipv6 = (table.getFamily() == 6);
+    }
+
     /* Default to using IPv4 if not specified on the command line */
     if (ipv4 == false && ipv6 == false)
     {
         ipv4 = true;
     }
 
-    if (argc - optind == 0)
+    opts.family = ipv6 ? 6 : 4;
+
+    if (argc - optind == 0 && opts.p_file == 0 && opts.p_table == 0 &&
+        opts.p_mrt == 0)
     {
         usage();
-        fprintf(stderr, "Error: One or more prefixes required.\n");
+        fprintf(stderr, "Error: One or more prefixes (or -f, -b or -r "
+                        "FILE) required.\n");
+        return 2;
+    }
+
+    if ((opts.p_out != 0) + (opts.p_diff != 0) + (opts.p_query != 0) > 1)
+    {
+        fprintf(stderr, "Error: Only one of -o, -d, -D and -q can be "
+                        "used.\n");
+        return 2;
+    }
+
+    if (opts.max_routes != 0 &&
+        ENGINE_TYPES[opts.engine].engine == Acrs::Acrs::ENGINE_ORTC)
+    {
+        fprintf(stderr, "Error: -n cannot be used with the ortc engine.\n");
         return 2;
     }
 
+    /* A table given alone is summarized where it is mapped */
+    bool table_only = (opts.p_table != 0 && argc - optind == 0 &&
+                       opts.p_file == 0 && opts.p_mrt == 0 &&
+                       opts.p_diff == 0);
     int retval;
 
-    if (ipv4)
+    Acrs::Arena arena((opts.backing < 0) ? Acrs::Arena::BACK_HEAP :
+                      BACKING_TYPES[opts.backing].backing);
+
+    if (ipv4 && table_only)
+    {
+        retval = runTable<IP::Route4Packed>(table, opts);
+    }
+    else if (ipv6 && table_only)
+    {
+        retval = runTable<IP::Route6Packed>(table, opts);
+    }
+    else if (ipv4)
     {
-        std::list<IP::Route4> rt_list;
-        retval = runSummary(rt_list, argc - optind, &argv[optind], logging,
-                            metric_style, INET_ADDRSTRLEN, AF_INET);
+        RouteList4 rt_list((Acrs::ArenaAllocator<IP::Route4>(&arena)));
+        retval = runSummary(rt_list, argc - optind, &argv[optind],
+                            opts.p_table ? &table : 0, opts);
     }
     else if (ipv6)
     {
-        std::list<IP::Route6> rt_list;
-        retval = runSummary(rt_list, argc - optind, &argv[optind], logging,
-                            metric_style, INET6_ADDRSTRLEN, AF_INET6);
+        RouteList6 rt_list((Acrs::ArenaAllocator<IP::Route6>(&arena)));
+        retval = runSummary(rt_list, argc - optind, &argv[optind],
+                            opts.p_table ? &table : 0, opts);
     }
     else
     {
         assert(false);
     }
 
+    reportArena(arena, opts);
+
     if (retval == 1)
     {
         /* Return 0 if anything was summarized */
@@ -182,252 +549,979 @@ int main(int argc, char * argv[])
     }
 }
 
+void setupSummary(Acrs::Acrs & summary, Acrs::Stats & stats,
+                  const demoOptions & opts)
+{
+    summary.setLogging(opts.logging);
+    summary.setEngine(ENGINE_TYPES[opts.engine].engine);
+    summary.setThreads(opts.threads);
+    summary.setMaxRoutes(opts.max_routes);
+
+    if (opts.stats == true)
+    {
+        summary.setStats(&stats);
+    }
+}
+
+/* Check by longest match what the ortc engine keeps, and let a summary
+ * to a budget route extra space as long as nothing gets a worse metric
+ */
+void setupVerifier(Acrs::Verifier & verifier, const demoOptions & opts)
+{
+    if (ENGINE_TYPES[opts.engine].engine == Acrs::Acrs::ENGINE_ORTC)
+    {
+        verifier.setMatch(Acrs::Verifier::MATCH_LONGEST);
+    }
+
+    if (opts.max_routes != 0)
+    {
+        verifier.setCompare(Acrs::Verifier::COMPARE_NO_WORSE);
+    }
+}
+
+/* Say how many allocations the route lists made, for comparing -A */
+void reportArena(const Acrs::Arena & arena, const demoOptions & opts)
+{
+    if (opts.backing < 0)
+    {
+        return;
+    }
+
+    const Acrs::ArenaCounts & counts = arena.getCounts();
+
+    fprintf(stderr, "Route allocations (%s): %zu made, %zu freed, %zu "
+                    "reused, %zu from the system holding %zu bytes.\n",
+            BACKING_TYPES[opts.backing].name.c_str(), counts.allocations,
+            counts.frees, counts.reused, counts.system, counts.system_bytes);
+}
+
+/* Start the named phase of the memory profile, if there is one */
+void memPhase(const demoOptions & opts, const char * p_name)
+{
+    if (opts.p_memory != NULL)
+    {
+        opts.p_memory->start(p_name);
+    }
+}
+
+/* Say how close a summary with a budget came, and what it cost */
+void reportBudget(Acrs::Acrs & summary, size_t routes,
+                  const demoOptions & opts)
+{
+    if (opts.max_routes == 0)
+    {
+        return;
+    }
+
+    if (routes > opts.max_routes)
+    {
+        fprintf(stderr, "Warning: Could not summarize below %zu routes.\n",
+                routes);
+    }
+
+    fprintf(stderr, "Summarized to %zu routes, adding %.0f addresses of "
+                    "extra space.\n", routes, summary.getExtraSpace());
+}
+
 template <class T> int runSummary(T & rt_list, int numrts, char * p_rts[],
-                                  bool logging, int metric_style,
-                                  int ipstr_len, int addr_family)
+                                  const IP::RouteTable * p_table,
+                                  const demoOptions & opts)
 {
     Acrs::Acrs summary;
-    summary.setLogging(logging);
+    Acrs::Stats summary_stats;
+    setupSummary(summary, summary_stats, opts);
+    memPhase(opts, "parse");
 
     /* Fill a list with routes based on user input */
-    if (getList(rt_list, numrts, p_rts, ipstr_len, addr_family) == false)
+    if (getList(rt_list, numrts, p_rts) == false)
     {
         fprintf(stderr, "Error: One or more invalid routes entered.\n");
         return 2;
     }
 
+    if (opts.p_file != 0 && readList(rt_list, opts.p_file) == false)
+    {
+        return 2;
+    }
+
+    if (opts.p_mrt != 0 &&
+        readMrt(rt_list, opts.p_mrt,
+                MRT_METRIC_TYPES[opts.mrt_metric].source) == false)
+    {
+        return 2;
+    }
+
+    if (p_table != 0)
+    {
+        addTable(rt_list, *p_table);
+    }
+
+    size_t input_routes = rt_list.size();
+    Acrs::Verifier verifier;
+
+    if (opts.verify == true)
+    {
+        memPhase(opts, "verify_input");
+        setupVerifier(verifier, opts);
+        verifier.setInput(rt_list.begin(), rt_list.end());
+    }
+
     /* Summarize the route list */
+    memPhase(opts, "summarize");
     int summarized = summary.summarize(rt_list);
+    reportBudget(summary, rt_list.size(), opts);
 
-    /* Print the results */
-    switch (metric_style)
+    if (opts.stats == true)
     {
-    case METRIC_STYLE_NONE:
-        for (typename T::iterator iter = rt_list.begin();
-             iter != rt_list.end();
-             iter++)
+        summary_stats.writeJson(std::cerr);
+    }
+
+    if (opts.verify == true)
+    {
+        memPhase(opts, "verify");
+
+        if (checkSummary(verifier, rt_list.begin(), rt_list.end()) == false)
         {
-            /* Cast to an IP address if metrics are not desired */
-            std::cout << *(dynamic_cast<IP::Addr*>(&(*iter))) << std::endl;
+            return 2;
         }
+    }
 
-        break;
-    case METRIC_STYLE_FULL:
-        for (typename T::iterator iter = rt_list.begin();
-             iter != rt_list.end();
-             iter++)
+    memPhase(opts, "output");
+
+    if (opts.p_diff != 0)
+    {
+        if (writeDiff(rt_list, opts) == false)
         {
-            std::cout << *iter << std::endl;
+            return 2;
         }
-
-        break;
-    case METRIC_STYLE_BRIEF:
-        for (typename T::iterator iter = rt_list.begin();
-             iter != rt_list.end();
-             iter++)
+    }
+    else if (opts.p_query != 0)
+    {
+        if (writeLookups(rt_list.begin(), rt_list.end(), opts) == false)
         {
-            std::cout << iter->getAddrP()
-                      << "/" << iter->getPlen()
-                      << "m" << iter->getMetric()
-                      << std::endl;
+            return 2;
         }
+    }
+    else if (writeResults(rt_list.begin(), rt_list.end(), opts) == false)
+    {
+        return 2;
+    }
 
-        break;
-    default:
-        assert(false);
+    if (opts.p_memory != NULL)
+    {
+        opts.p_memory->writeJson(std::cerr, input_routes, "parse");
     }
 
     return summarized;
 }
 
-template <class T> bool getList(T & rt_list, int numrts, char * p_rts[],
-                                int ipstr_len, int addr_family)
+/* Summarize the records of a route table in its mapping, with no copy
+ * into a list. P is the table's record type.
+ */
+template <class P> int runTable(IP::RouteTable & table,
+                                const demoOptions & opts)
 {
-    char ipstr[ipstr_len];
-    int plen_int;
-    int metric_int;
-    char * p_prefix;
+    Acrs::Acrs summary;
+    Acrs::Stats summary_stats;
+    setupSummary(summary, summary_stats, opts);
 
-    for (int i = 0; i < numrts; i++)
+    P * p_routes;
+    size_t count;
+
+    if (table.getRoutes(p_routes, count) == false)
+    {
+        fprintf(stderr, "Error: The route table holds IPv%d routes.\n",
+                table.getFamily());
+        return 2;
+    }
+
+    Acrs::Verifier verifier;
+
+    if (opts.verify == true)
     {
-        p_prefix = p_rts[i];
+        memPhase(opts, "verify_input");
+        setupVerifier(verifier, opts);
+        verifier.setInput(p_routes, p_routes + count);
+    }
+
+    memPhase(opts, "summarize");
+    P * p_end = summary.summarize(p_routes, p_routes + count);
+    int summarized = (p_end != p_routes + count);
+    reportBudget(summary, p_end - p_routes, opts);
+
+    if (opts.stats == true)
+    {
+        summary_stats.writeJson(std::cerr);
+    }
+
+    if (opts.verify == true)
+    {
+        memPhase(opts, "verify");
 
-        if (getRoute(p_prefix, ipstr, &plen_int, &metric_int, sizeof(ipstr),
-                     addr_family) == false)
+        if (checkSummary(verifier, p_routes, p_end) == false)
         {
-            return false;
+            return 2;
         }
+    }
 
-        typename T::value_type newrt(ipstr, plen_int, IP::PLEN, metric_int);
-        if (newrt.isValid() == false)
+    memPhase(opts, "output");
+
+    if (opts.p_query != 0)
+    {
+        if (writeLookups(p_routes, p_end, opts) == false)
         {
-            std::stringstream ss_plen;
-            std::stringstream ss_metric;
+            return 2;
+        }
+    }
+    else if (writeResults(p_routes, p_end, opts) == false)
+    {
+        return 2;
+    }
 
-            /* Get the actual prefix length and metric passed to the
-             * constructor instead of using the old strings, in case
-             * the conversion happened incorrectly or the metric wasn't
-             * specified.
-             */
-            ss_plen << plen_int;
-            ss_metric << metric_int;
+    if (opts.p_memory != NULL)
+    {
+        opts.p_memory->writeJson(std::cerr, count, "load");
+    }
 
-            fprintf(stderr, "Invalid IPv%d route with attributes:\n"
-                    "Address:         %s\n"
-                    "Prefix length:   %s\n"
-                    "Metric:          %s\n",
-                    addr_family == AF_INET ? 4 : 6, ipstr,
-                    ss_plen.str().c_str(), ss_metric.str().c_str());
+    return summarized;
+}
 
-            if (metric_int > IP::Route::MAX_METRIC)
-            {
-                fprintf(stderr, "Note: Maximum metric was "
-                        "compiled as %d\n", IP::Route::MAX_METRIC);
-            }
-            else if (metric_int < IP::Route::MIN_METRIC)
-            {
-                fprintf(stderr, "Note: Minimum metric was "
-                        "compiled as %d\n", IP::Route::MIN_METRIC);
-            }
+/* Check the summary in [first, last) against the input given to
+ * 'verifier', and report the first range of addresses routed differently
+ */
+template <class I> bool checkSummary(Acrs::Verifier & verifier,
+                                     I first, I last)
+{
+    typedef typename std::iterator_traits<I>::value_type R;
 
-            return false;
+    if (verifier.check(first, last) == true)
+    {
+        return true;
+    }
+
+    std::string metrics[2];
+    int values[2] = { verifier.input_metric, verifier.output_metric };
+
+    for (int i = 0; i < 2; i++)
+    {
+        std::ostringstream metric;
+
+        if (values[i] == Acrs::Verifier::NO_METRIC)
+        {
+            metric << "not routed";
         }
         else
         {
-            rt_list.push_back(newrt);
+            metric << "metric " << values[i];
         }
+
+        metrics[i] = metric.str();
     }
 
-    return true;
+    fprintf(stderr, "Error: The summary does not match the input from %s "
+                    "to %s: %s in the input, %s in the summary.\n",
+            Acrs::keyRoute<R>(verifier.start, 0, 0).getAddrP().c_str(),
+            Acrs::keyRoute<R>(verifier.end, 0, 0).getAddrP().c_str(),
+            metrics[0].c_str(), metrics[1].c_str());
+
+    return false;
 }
 
-bool getRoute(char * p_prefix, char * ipstr, int * plen_int, int * metric_int,
-              int ipstr_len, int addr_family)
+/* Print the routes in [first, last), or save them as a route table if
+ * p_out is set ("-" for stdout).
+ */
+template <class I> bool writeResults(I first, I last,
+                                     const demoOptions & opts)
 {
-    char * p_addr;
-    char * p_plen;
-    char * p_metric;
-    char * p_maskmetric;
-    char * p_maskchk;
-    char * p_save = 0;
+    const char * p_out = opts.p_out;
 
-    /* Get IP address */
-    p_addr = strtok_r(p_prefix, "/", &p_save);
-    if (p_addr == 0)
+    if (p_out == 0)
     {
-        std::string addr_example;
+        IP::RouteWriter writer(STDOUT_FILENO,
+                               METRIC_TYPES[opts.metric_style].style);
 
-        switch (addr_family)
+        for (I iter = first; iter != last; iter++)
         {
-        case AF_INET:
-            addr_example = "1.1.1.0/24";
-            break;
-        case AF_INET6:
-            addr_example = "2001:db8::/64";
-            break;
-        default:
-            assert(false);
-            break;
+            writer.write(*iter);
         }
 
-        fprintf(stderr, "Could not find IP address, no slash found in: %s"
-                " (use CIDR notation: %s)\n", p_prefix, addr_example.c_str());
+        if (writer.flush() == false)
+        {
+            fprintf(stderr, "Error: Could not write the results: %s\n",
+                    strerror(errno));
+            return false;
+        }
 
-        return false;
+        return true;
     }
-    strncpy(ipstr, p_addr, ipstr_len);
 
-    /* Check for duplicate slashes */
-    if (p_save && (strchr(p_save, '/') != 0))
-    {
-        fprintf(stderr, "Improperly formatted prefix (extra slash).\n");
-        return false;
-    }
+    IP::RouteTableWriter table;
+    table.setFamily(opts.family);
 
-    /* Get prefix length (and metric, if specified) */
-    p_maskmetric = strtok_r(NULL, "/", &p_save);
-    if (p_maskmetric == 0)
+    for (I iter = first; iter != last; iter++)
     {
-        fprintf(stderr, "Could not find prefix length in: %s\n", p_prefix);
-        return false;
+        table.add(*iter);
     }
 
-    /* If an "m" is used to supply a metric, make sure it is preceded
-     * by a prefix length -- otherwise when strtok tokenizes something like
-     * "/m1", the "1" will be used as a prefix length instead of throwing
-     * an error.
-     */
-    p_maskchk = strchr(p_maskmetric, 'm');
-    if (p_maskchk == p_maskmetric)
+    bool to_stdout = (strcmp(p_out, "-") == 0);
+    int fd = to_stdout ? STDOUT_FILENO :
+                         open(p_out, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+    if (fd < 0)
     {
-        fprintf(stderr, "Missing prefix length.\n");
+        fprintf(stderr, "Error: Could not open %s: %s\n", p_out,
+                strerror(errno));
         return false;
     }
 
-    /*
-     * If "m" is supplied, make sure a metric actually follows.
-     *
-     * The starting address of the potential mask (maskchk) minus
-     * the length of the full mask and metric string (everything after
-     * the slash) minus 1 should NOT be equal to the starting address of
-     * the full mask and metric string. This would mean either an 'm'
-     * was specified and no metric is present, or there are two 'm' chars.
-     */
-    if ((p_maskchk - (strlen(p_maskmetric) - 1)) == p_maskmetric)
+    bool ok = table.write(fd);
+
+    if (ok == false)
     {
-        fprintf(stderr, "An 'm' was supplied, but the metric was "
-                "missing.\n");
-        return false;
+        fprintf(stderr, "Error: Could not write %s: %s\n", p_out,
+                strerror(errno));
     }
 
-    /* Check for a second 'm' and error out if present, which the above
-     * won't catch
-     */
-    if (p_maskchk && (strchr((p_maskchk + 1), 'm') != 0))
+    if (to_stdout == false && close(fd) != 0 && ok == true)
     {
-        fprintf(stderr, "Duplicate 'm' character entered.\n");
-        return false;
+        fprintf(stderr, "Error: Could not write %s: %s\n", p_out,
+                strerror(errno));
+        ok = false;
     }
 
-    p_plen = strtok_r(p_maskmetric, "m", &p_save);
-    p_metric = strtok_r(NULL, "m", &p_save);
+    return ok;
+}
+
+/* Print what changed from the routes in p_diff to the summarized routes
+ * in 'rt_list': removed prefixes marked '-', added ones '+', and those
+ * with a new metric '~', with the new metric.
+ */
+template <class T> bool writeDiff(const T & rt_list,
+                                  const demoOptions & opts)
+{
+    const char * p_path = opts.p_diff;
+    Acrs::RouteDiff<typename T::value_type> diff;
 
-    /* Make sure prefix length is actually actually a number,
-     * otherwise atoi will return 0 (which would convert an invalid length
-     * into a valid one).
+    /* A table is compared where it is mapped. Either way the old routes
+     * are taken as they are, not summarized.
      */
-    for (char * c = p_plen; *c != 0; c++)
+    if (isTableFile(p_path) == true)
     {
-        if (isdigit(*c) == false)
+        IP::RouteTable table;
+
+        if (table.load(p_path) == false)
         {
-            fprintf(stderr, "Invalid prefix length: %s\n", p_plen);
+            fprintf(stderr, "Error: Could not load %s: %s\n", p_path,
+                    table.getError());
             return false;
         }
-    }
-
-    *plen_int = atoi(p_plen);
 
-    /* Metric isn't required. If not given, set to 0 */
-    if (p_metric == 0)
-    {
-        *metric_int = 0;
+        if (diffTable(diff, table, rt_list, opts) == false)
+        {
+            fprintf(stderr, "Error: %s holds IPv%d routes.\n", p_path,
+                    table.getFamily());
+            return false;
+        }
     }
     else
     {
-        /* Make sure metric is a number (as above) */
-        for (char * c = p_metric; *c != 0; c++)
+        T old_list;
+
+        if (readList(old_list, p_path) == false)
         {
-            if (isdigit(*c) == false)
-            {
-                fprintf(stderr, "Invalid metric: %s\n", p_metric);
+            return false;
+        }
+
+        runDiff(diff, old_list.begin(), old_list.end(), rt_list, opts);
+    }
+
+    IP::RouteWriter writer(STDOUT_FILENO,
+                           METRIC_TYPES[opts.metric_style].style);
+
+    writer.setMark('-');
+
+    for (size_t i = 0; i < diff.removed.size(); i++)
+    {
+        writer.write(diff.removed[i]);
+    }
+
+    writer.setMark('+');
+
+    for (size_t i = 0; i < diff.added.size(); i++)
+    {
+        writer.write(diff.added[i]);
+    }
+
+    writer.setMark('~');
+
+    for (size_t i = 0; i < diff.changed.size(); i++)
+    {
+        writer.write(diff.changed[i].second);
+    }
+
+    if (writer.flush() == false)
+    {
+        fprintf(stderr, "Error: Could not write the results: %s\n",
+                strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+/* Compare the old routes in [first, last) with those in 'rt_list' */
+template <class R, class I, class T> void runDiff(Acrs::RouteDiff<R> & diff,
+                                                   I first, I last,
+                                                   const T & rt_list,
+                                                   const demoOptions & opts)
+{
+    if (opts.diff_space == true)
+    {
+        diff.diffSpace(first, last, rt_list.begin(), rt_list.end());
+    }
+    else
+    {
+        diff.diffPrefixes(first, last, rt_list.begin(), rt_list.end());
+    }
+}
+
+/* Compare the routes of a table with those in 'rt_list', if the table is
+ * of the list's family
+ */
+bool diffTable(Acrs::RouteDiff<IP::Route4> & diff,
+               const IP::RouteTable & table,
+               const RouteList4 & rt_list,
+               const demoOptions & opts)
+{
+    IP::Route4Packed * p_routes;
+    size_t count;
+
+    if (table.getRoutes(p_routes, count) == false)
+    {
+        return false;
+    }
+
+    runDiff(diff, p_routes, p_routes + count, rt_list, opts);
+    return true;
+}
+
+bool diffTable(Acrs::RouteDiff<IP::Route6> & diff,
+               const IP::RouteTable & table,
+               const RouteList6 & rt_list,
+               const demoOptions & opts)
+{
+    IP::Route6Packed * p_routes;
+    size_t count;
+
+    if (table.getRoutes(p_routes, count) == false)
+    {
+        return false;
+    }
+
+    runDiff(diff, p_routes, p_routes + count, rt_list, opts);
+    return true;
+}
+
+/* Compile the routes in [first, last) into a lookup table and print the
+ * route each address in p_query is forwarded by, as "ADDRESS ROUTE", or
+ * "ADDRESS none" if no route covers it.
+ */
+template <class I> bool writeLookups(I first, I last,
+                                     const demoOptions & opts)
+{
+    typedef typename std::iterator_traits<I>::value_type Route;
+    typedef typename LookupFor<Route>::Lookup Lookup;
+    typedef typename LookupFor<Route>::Addr Addr;
+
+    /* Where each address is in the text, to print it back as given */
+    struct Word
+    {
+        size_t offset;
+        size_t len;
+    };
+
+    std::string text;
+    std::vector<Word> words;
+    std::vector<Addr> addrs;
+
+    if (readFile(opts.p_query, text) == false)
+    {
+        return false;
+    }
+
+    const char * p_text = text.data();
+    size_t pos = 0;
+
+    while (true)
+    {
+        while (pos < text.size() && isSpace(p_text[pos]) == true)
+        {
+            pos++;
+        }
+
+        Word word;
+        word.offset = pos;
+
+        while (pos < text.size() &&
+               isSpace(p_text[pos]) == false)
+        {
+            pos++;
+        }
+
+        word.len = pos - word.offset;
+
+        if (word.len == 0)
+        {
+            break;
+        }
+
+        Addr addr;
+        IP::ParseError err;
+
+        if (LookupFor<Route>::parse(p_text + word.offset, word.len, addr,
+                                    err) == false)
+        {
+            fprintf(stderr, "Error: Invalid address '%.*s': %s\n",
+                    (int) word.len, p_text + word.offset, err.reason);
+            return false;
+        }
+
+        words.push_back(word);
+        addrs.push_back(addr);
+    }
+
+    Lookup lookup;
+
+    for (I iter = first; iter != last; iter++)
+    {
+        lookup.add(*iter);
+    }
+
+    lookup.build();
+
+    std::vector<uint32_t> found(addrs.size());
+
+    if (addrs.empty() == false)
+    {
+        lookup.lookup(&addrs[0], addrs.size(), &found[0]);
+    }
+
+    IP::RouteWriter writer(STDOUT_FILENO, IP::RouteWriter::METRIC_FULL);
+
+    for (size_t i = 0; i < addrs.size(); i++)
+    {
+        writer.writeText(p_text + words[i].offset, words[i].len);
+
+        if (found[i] == Lookup::NONE)
+        {
+            writer.writeText(" none\n", 6);
+        }
+        else
+        {
+            writer.writeText(" ", 1);
+            writer.write(lookup.getRoute(found[i]));
+        }
+    }
+
+    if (writer.flush() == false)
+    {
+        fprintf(stderr, "Error: Could not write the results: %s\n",
+                strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+/* Whitespace between prefixes or addresses */
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/* Read a whole file, or stdin if p_path is "-" */
+bool readFile(const char * p_path, std::string & text)
+{
+    bool from_stdin = (strcmp(p_path, "-") == 0);
+    int fd = from_stdin ? STDIN_FILENO : open(p_path, O_RDONLY);
+    std::vector<char> buf(READ_BUF_SIZE);
+    ssize_t got;
+
+    if (fd < 0)
+    {
+        fprintf(stderr, "Error: Could not open %s: %s\n", p_path,
+                strerror(errno));
+        return false;
+    }
+
+    while ((got = read(fd, &buf[0], buf.size())) != 0)
+    {
+        if (got < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else if (got < 0)
+        {
+            fprintf(stderr, "Error: Could not read %s: %s\n", p_path,
+                    strerror(errno));
+            break;
+        }
+
+        text.append(&buf[0], got);
+    }
+
+    if (from_stdin == false)
+    {
+        close(fd);
+    }
+
+    return got == 0;
+}
+
+/* True if the file at p_path starts like a route table */
+bool isTableFile(const char * p_path)
+{
+    char magic[sizeof(IP::RouteTable::MAGIC)];
+    int fd = (strcmp(p_path, "-") == 0) ? -1 : open(p_path, O_RDONLY);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    bool is_table = (read(fd, magic, sizeof(magic)) == sizeof(magic) &&
+                     memcmp(magic, IP::RouteTable::MAGIC,
+                            sizeof(magic)) == 0);
+    close(fd);
+
+    return is_table;
+}
+
+template <class T> bool getList(T & rt_list, int numrts, char * p_rts[])
+{
+    bool ok = true;
+
+    for (int i = 0; i < numrts; i++)
+    {
+        IP::ParseError err;
+
+        if (addRoute(rt_list, p_rts[i], strlen(p_rts[i]), err) == false)
+        {
+            fprintf(stderr, "Invalid prefix '%s' at byte %lu: %s\n",
+                    p_rts[i], (unsigned long) err.offset, err.reason);
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+/* Parse one prefix of 'len' bytes and add it to the list. If it can't be
+ * parsed, 'err' says where and why.
+ */
+bool addRoute(RouteList4 & rt_list, const char * p_prefix,
+              size_t len, IP::ParseError & err)
+{
+    IP::Cidr4 cidr;
+
+    if (IP::parseCidr4(p_prefix, len, cidr, err) == false)
+    {
+        return false;
+    }
+
+    rt_list.push_back(IP::Route4(cidr.addr, cidr.plen, IP::PLEN,
+                                 cidr.metric));
+    return true;
+}
+
+bool addRoute(RouteList6 & rt_list, const char * p_prefix,
+              size_t len, IP::ParseError & err)
+{
+    IP::Cidr6 cidr;
+
+    if (IP::parseCidr6(p_prefix, len, cidr, err) == false)
+    {
+        return false;
+    }
+
+    rt_list.push_back(IP::Route6(cidr.addr, cidr.plen, IP::PLEN,
+                                 cidr.metric));
+    return true;
+}
+
+/* Add every prefix of the list's family from an MRT reader */
+bool addMrt(RouteList4 & rt_list, IP::MrtReader & reader)
+{
+    IP::Cidr4 cidr;
+
+    while (reader.next(cidr) == true)
+    {
+        rt_list.push_back(IP::Route4(cidr.addr, cidr.plen, IP::PLEN,
+                                     cidr.metric));
+    }
+
+    return reader.failed() == false;
+}
+
+bool addMrt(RouteList6 & rt_list, IP::MrtReader & reader)
+{
+    IP::Cidr6 cidr;
+
+    while (reader.next(cidr) == true)
+    {
+        rt_list.push_back(IP::Route6(cidr.addr, cidr.plen, IP::PLEN,
+                                     cidr.metric));
+    }
+
+    return reader.failed() == false;
+}
+
+/* Add the unicast RIB prefixes in an MRT dump, or in stdin if p_path is
+ * "-". Reading stops at the first malformed record.
+ */
+template <class T> bool readMrt(T & rt_list, const char * p_path,
+                                IP::MrtReader::MetricSource source)
+{
+    bool from_stdin = (strcmp(p_path, "-") == 0);
+    int fd = from_stdin ? STDIN_FILENO : open(p_path, O_RDONLY);
+
+    if (fd < 0)
+    {
+        fprintf(stderr, "Error: Could not open %s: %s\n", p_path,
+                strerror(errno));
+        return false;
+    }
+
+    IP::MrtReader reader(fd, source);
+    bool ok = addMrt(rt_list, reader);
+
+    if (ok == false)
+    {
+        fprintf(stderr, "Error: %s: byte %llu: %s\n",
+                from_stdin ? "stdin" : p_path,
+                (unsigned long long) reader.getOffset(), reader.getError());
+    }
+
+    if (from_stdin == false)
+    {
+        close(fd);
+    }
+
+    return ok;
+}
+
+/* Add every route in a route table of the list's family */
+void addTable(RouteList4 & rt_list, const IP::RouteTable & table)
+{
+    IP::Route4Packed * p_routes;
+    size_t count;
+
+    if (table.getRoutes(p_routes, count) == true)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            rt_list.push_back(p_routes[i].toRoute());
+        }
+    }
+}
+
+void addTable(RouteList6 & rt_list, const IP::RouteTable & table)
+{
+    IP::Route6Packed * p_routes;
+    size_t count;
+
+    if (table.getRoutes(p_routes, count) == true)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            rt_list.push_back(p_routes[i].toRoute());
+        }
+    }
+}
+
+/* Reads whitespace separated prefixes from a file or stdin. Prefixes are
+ * parsed straight out of the read buffer (or the file's mapping) and
+ * added to the list. A bad prefix is reported with its line and byte
+ * offset, and reading carries on so every bad prefix is reported.
+ */
+template <class T> class RouteReader
+{
+private:
+    T & m_rt_list;
+    const char * m_path;
+    size_t m_line;
+    size_t m_offset;        /* File offset of the start of the buffer */
+    size_t m_errors;
+
+    void addPrefix(const char * p_buf, const char * p_prefix, size_t len)
+    {
+        IP::ParseError err;
+
+        if (addRoute(m_rt_list, p_prefix, len, err) == true)
+        {
+            return;
+        }
+
+        fprintf(stderr, "%s:%lu: byte %lu: %s: '%.*s'\n", m_path,
+                (unsigned long) m_line,
+                (unsigned long) (m_offset + (p_prefix - p_buf) + err.offset),
+                err.reason, (int) len, p_prefix);
+        m_errors++;
+    };
+
+public:
+    /* Add every prefix in [p_buf, p_end). A prefix running into p_end is
+     * left for the next call unless 'at_eof' is true. Returns where
+     * parsing stopped.
+     */
+    const char * parse(const char * p_buf, const char * p_end, bool at_eof)
+    {
+        const char * p = p_buf;
+
+        while (true)
+        {
+            while (p < p_end && isSpace(*p) == true)
+            {
+                if (*p == '\n')
+                {
+                    m_line++;
+                }
+
+                p++;
+            }
+
+            const char * p_prefix = p;
+
+            while (p < p_end && isSpace(*p) == false)
+            {
+                p++;
+            }
+
+            if (p == p_prefix || (p == p_end && at_eof == false))
+            {
+                return p_prefix;
+            }
+
+            addPrefix(p_buf, p_prefix, p - p_prefix);
+        }
+    };
+
+    /* Regular files are mapped and parsed in place */
+    bool readMapped(int fd, size_t size)
+    {
+        const char * p_map = (const char *) mmap(0, size, PROT_READ,
+                                                 MAP_PRIVATE, fd, 0);
+
+        if (p_map == MAP_FAILED)
+        {
+            return readStream(fd);
+        }
+
+        madvise((void *) p_map, size, MADV_SEQUENTIAL);
+        parse(p_map, p_map + size, true);
+        munmap((void *) p_map, size);
+
+        return true;
+    };
+
+    /* Pipes and terminals are read in large blocks. A prefix cut off at
+     * the end of a block is moved to the front before the next read.
+     */
+    bool readStream(int fd)
+    {
+        std::vector<char> buf(READ_BUF_SIZE);
+        size_t held = 0;
+
+        while (true)
+        {
+            ssize_t got = read(fd, &buf[held], READ_BUF_SIZE - held);
+
+            if (got < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                fprintf(stderr, "Error: Could not read %s: %s\n", m_path,
+                        strerror(errno));
+                return false;
+            }
+
+            bool at_eof = (got == 0);
+            const char * p_end = &buf[held] + got;
+            const char * p_rest = parse(&buf[0], p_end, at_eof);
+
+            if (at_eof == true)
+            {
+                return true;
+            }
+
+            held = p_end - p_rest;
+
+            if (held == READ_BUF_SIZE)
+            {
+                fprintf(stderr, "Error: Line %lu of %s is too long\n",
+                        (unsigned long) m_line, m_path);
                 return false;
             }
+
+            m_offset += p_rest - &buf[0];
+            memmove(&buf[0], p_rest, held);
         }
+    };
 
-        *metric_int = atoi(p_metric);
+    size_t errors()
+    {
+        return m_errors;
+    };
+
+    RouteReader(T & rt_list, const char * p_path)
+                :
+                m_rt_list(rt_list), m_path(p_path), m_line(1), m_offset(0),
+                m_errors(0) {};
+};
+
+/* Add the prefixes in a file, or in stdin if p_path is "-" */
+template <class T> bool readList(T & rt_list, const char * p_path)
+{
+    bool from_stdin = (strcmp(p_path, "-") == 0);
+    int fd = from_stdin ? STDIN_FILENO : open(p_path, O_RDONLY);
+
+    if (fd < 0)
+    {
+        fprintf(stderr, "Error: Could not open %s: %s\n", p_path,
+                strerror(errno));
+        return false;
     }
 
-    return true;
+    const char * p_name = from_stdin ? "stdin" : p_path;
+    RouteReader<T> reader(rt_list, p_name);
+    struct stat st;
+    bool ok;
+
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+    {
+        ok = reader.readMapped(fd, st.st_size);
+    }
+    else
+    {
+        ok = reader.readStream(fd);
+    }
+
+    if (from_stdin == false)
+    {
+        close(fd);
+    }
+
+    if (ok == true && reader.errors() > 0)
+    {
+        fprintf(stderr, "Error: %lu invalid prefixes in %s\n",
+                (unsigned long) reader.errors(), p_name);
+        ok = false;
+    }
+
+    return ok;
 }
 
 int findMetricStyle(const char * requested_name)
@@ -464,13 +1558,120 @@ std::string getMetricStyleString(int spaces)
     return s;
 }
 
+int findEngine(const char * requested_name)
+{
+    int i;
+
+    for (i = 0; i != NUM_ENGINES; i++)
+    {
+        const char * valid_name = ENGINE_TYPES[i].name.c_str();
+        if (strcasecmp(requested_name, valid_name) == 0)
+        {
+            break;
+        }
+    }
+
+    /* Return the index of the engine, or NUM_ENGINES if not found */
+    return i;
+}
+
+std::string getEngineString(int spaces)
+{
+    std::string s = "";
+
+    for (int i = 0; i != NUM_ENGINES; i++)
+    {
+        for (int count = 0; count <= spaces; count++)
+        {
+            s += " ";
+        }
+
+        s += ENGINE_TYPES[i].name + ": " + ENGINE_TYPES[i].desc + "\n";
+    }
+
+    return s;
+}
+
+int findMrtMetric(const char * requested_name)
+{
+    int i;
+
+    for (i = 0; i != NUM_MRT_METRICS; i++)
+    {
+        const char * valid_name = MRT_METRIC_TYPES[i].name.c_str();
+        if (strcasecmp(requested_name, valid_name) == 0)
+        {
+            break;
+        }
+    }
+
+    /* Return the index of the source, or NUM_MRT_METRICS if not found */
+    return i;
+}
+
+int findBacking(const char * requested_name)
+{
+    int i;
+
+    for (i = 0; i != NUM_BACKINGS; i++)
+    {
+        const char * valid_name = BACKING_TYPES[i].name.c_str();
+        if (strcasecmp(requested_name, valid_name) == 0)
+        {
+            break;
+        }
+    }
+
+    /* Return the index of the backing, or NUM_BACKINGS if not found */
+    return i;
+}
+
+std::string getBackingString(int spaces)
+{
+    std::string s = "";
+
+    for (int i = 0; i != NUM_BACKINGS; i++)
+    {
+        for (int count = 0; count <= spaces; count++)
+        {
+            s += " ";
+        }
+
+        s += BACKING_TYPES[i].name + ": " + BACKING_TYPES[i].desc + "\n";
+    }
+
+    return s;
+}
+
+std::string getMrtMetricString(int spaces)
+{
+    std::string s = "";
+
+    for (int i = 0; i != NUM_MRT_METRICS; i++)
+    {
+        for (int count = 0; count <= spaces; count++)
+        {
+            s += " ";
+        }
+
+        s += MRT_METRIC_TYPES[i].name + ": " + MRT_METRIC_TYPES[i].desc + "\n";
+    }
+
+    return s;
+}
+
 void usage()
 {
     fprintf(stderr,
             "Automatic classless route summarization (ACRS) demo program\n"
             "Usage:\n"
             "\n"
-            "       ./acrs-demo [-46lh] [-m STYLE] PREFIX [PREFIX ...]\n"
+            "       ./acrs-demo [-46lsVMh] [-m STYLE] [-e ENGINE] [-j THREADS] [-n MAX] [-A ALLOC] PREFIX [PREFIX ...]\n"
+            "       ./acrs-demo [-46lsVMh] [-m STYLE] [-e ENGINE] [-j THREADS] [-n MAX] [-A ALLOC] -f FILE\n"
+            "       ./acrs-demo [-lsVMh] [-e ENGINE] [-j THREADS] [-n MAX] -b TABLE [-o TABLE]\n"
+            "       ./acrs-demo [-46lsVh] [-a ATTR] [-m STYLE] [-e ENGINE] -r DUMP\n"
+            "       ./acrs-demo [-46lsh] [-m STYLE] -d OLD|-D OLD -f FILE\n"
+            "       ./acrs-demo [-46lsh] -q ADDRS -f FILE\n"
             "\n"
             "       PREFIX consists of <NETWORK>/<PREFLEN>[m<METRIC>]\n"
             "\n"
@@ -480,16 +1681,78 @@ void usage()
             "\n"
             "       Example usage:  ./acrs-demo 192.168.0.0/24m1 192.168.1.0/24\n"
             "                       ./acrs-demo -6 2001:db8::/128 2001:db8::1/128\n"
+            "                       ./acrs-demo -f routes.txt\n"
+            "                       ./acrs-demo -f routes.txt -o routes.tbl\n"
+            "                       ./acrs-demo -b routes.tbl\n"
+            "                       ./acrs-demo -f routes.txt -d routes.tbl\n"
             "\n"
             "       Options:\n"
+            "       -f FILE  Reads prefixes from FILE, separated by whitespace or\n"
+            "             newlines, in addition to any given as arguments. Use - to\n"
+            "             read from standard input.\n"
+            "       -b TABLE Reads routes from a binary route table, as written by\n"
+            "             -o. The table sets the address family. Given alone it is\n"
+            "             summarized in place in memory, without copying.\n"
+            "       -o TABLE Writes the results to TABLE as a binary route table\n"
+            "             instead of printing them. Use - for standard output.\n"
+            "       -r DUMP  Reads the IPv4 (or with -6, IPv6) unicast prefixes of an\n"
+            "             MRT TABLE_DUMP_V2 RIB dump. Use - to read from standard\n"
+            "             input, e.g. to decompress with zcat.\n"
+            "       -d OLD   Prints what changed from the routes in OLD, a route\n"
+            "             table or a file of prefixes, to the summarized routes\n"
+            "             instead of the routes themselves: '- PREFIX' for each\n"
+            "             prefix removed, '+ PREFIX' for each added and '~ PREFIX'\n"
+            "             for each with a new metric. OLD is not summarized.\n"
+            "       -D OLD   As -d, but compares the address space routed: what\n"
+            "             is newly routed, no longer routed, or routed with another\n"
+            "             metric, by longest prefix match. Prefixes split or merged\n"
+            "             over the same space are not reported.\n"
+            "       -q ADDRS Looks up each address in ADDRS (- for standard input)\n"
+            "             in the summarized routes, by longest prefix match, and\n"
+            "             prints it with the route it matches, or 'none'.\n"
+            "       -a ATTR  Sets the metric of prefixes read with -r from a BGP\n"
+            "             attribute, taking the best of all peers. Valid attributes:\n"
+            "%s"
             "       -l    Enables logging\n"
+            "       -s    Prints summarization statistics and timings as JSON\n"
+            "             to standard error\n"
+            "       -V    Verifies that the summary routes every address the input\n"
+            "             did, with the same best (lowest) metric, or with the ortc\n"
+            "             engine the metric of the longest match, and exits with\n"
+            "             an error naming the first range that differs if not.\n"
+            "             With -n, extra space may be routed, but nothing the\n"
+            "             input routed may get a worse metric or be unrouted\n"
+            "       -M    Prints a memory profile as JSON to standard error: the\n"
+            "             number and size of allocations made and the resident\n"
+            "             size after reading, summarizing and output, the peak\n"
+            "             resident size, and the bytes taken per route read\n"
             "       -4    Input routes are IPv4 (default)\n"
             "       -6    Input routes are IPv6\n"
             "       -h    Displays this help message\n"
             "       -m STYLE  Modifies the format of the metric message (\"... in 0\")\n"
             "             in summary output. Does not affect logging messages or how routes\n"
             "             are summarized. Valid metric styles:\n"
-            "%s\n"
-            "Other useful information is available on the wiki at: acrs.googlecode.com\n", getMetricStyleString(15).c_str());
+            "%s"
+            "       -e ENGINE Selects the summarization engine. pass and trie give\n"
+            "             the same results, keeping the best metric of every\n"
+            "             address. ortc keeps the metric of each address's longest\n"
+            "             match, taking metrics as next hops. Valid engines:\n"
+            "%s"
+            "       -j THREADS Summarizes on THREADS threads (default 1). Routes are\n"
+            "             split by metric and address block, and the result is the\n"
+            "             same as with one thread.\n"
+            "       -n MAX   Keeps summarizing routes of the same metric into shorter\n"
+            "             prefixes until no more than MAX are left, choosing those\n"
+            "             that add the least extra space: addresses a summary covers\n"
+            "             that no route did. This is lossy; the extra space\n"
+            "             added is printed to standard error.\n"
+            "       -A ALLOC Selects where the route list keeps its routes, and\n"
+            "             prints to standard error how many allocations it made.\n"
+            "             Valid allocators:\n"
+            "%s"
+            "\n"
+            "Other useful information is available on the wiki at: acrs.googlecode.com\n",
+            getMrtMetricString(15).c_str(), getMetricStyleString(15).c_str(),
+            getEngineString(15).c_str(), getBackingString(15).c_str());
     return;
 }
@@ -21,20 +21,41 @@
 
 #include <iostream>
 #include <string>
-#include <sstream>
 #include <algorithm>
+#include <vector>
+#include <unordered_map>
 
 #include <inttypes.h>
 #include <assert.h>
 
+#include "acrskey.hpp"
+#include "acrstrie.hpp"
+#include "acrsbudget.hpp"
+#include "acrsortc.hpp"
+#include "acrssort.hpp"
+#include "acrsrange.hpp"
+#include "acrspool.hpp"
+#include "acrslog.hpp"
+#include "acrsstats.hpp"
+#include "acrsmem.hpp"
+
 namespace Acrs
 {
     class Acrs
     {
-    private:
-        bool m_logging;
-        std::ostream & m_os;
-        int m_main_recurse_count;
+    public:
+        enum Engine
+        {
+            ENGINE_PASS,    /* Re-sort and merge pass by pass (default) */
+            ENGINE_TRIE,    /* Merge bottom-up in a binary prefix trie  */
+            ENGINE_ORTC     /* Smallest table forwarding the same way,
+                             * taking metrics as next hops (see OrtcTrie) */
+        };
+
+        /* The comparators below define the orders the summarizer sorts
+         * by. The summarizer itself sorts with radixSort() on keys built
+         * by makeSortKey(), which gives the same (stable) order.
+         */
 
         /* Compare two routes to determine which should come first.
          *
@@ -117,101 +138,157 @@ namespace Acrs
             }
         };
 
+    private:
+        mutable LogSink m_log;
+        int m_main_recurse_count;
+        Engine m_engine;
+        unsigned int m_threads;
+        Stats * m_stats;
+        size_t m_max_routes;
+        double m_extra_space;
+
+        /* Bump a counter in the stats, if they're being kept */
+        void count(size_t Stats::* counter, size_t n = 1) const
+        {
+            if (m_stats != NULL)
+            {
+                m_stats->*counter += n;
+            }
+        };
+
+        /* Where to add the time for a phase, NULL if not keeping stats */
+        PhaseTime * phaseTime(Stats::Phase phase) const
+        {
+            return (m_stats == NULL) ? NULL : &m_stats->phase[phase];
+        };
+
         /* Summarize and remove overlapping address space.
+         *
+         * In overlapCmp order every route comes after the routes that
+         * contain it, so one sweep with a stack of the open (containing)
+         * routes kept so far finds each route's closest container in
+         * amortized constant time. A route is removed if that container's
+         * metric is no higher than its own, as the container already
+         * carries its traffic at least as well. Removed routes are never
+         * pushed, so they cannot hide a route from a better container.
+         *
          * Return true if any summarization was done, return false otherwise.
          */
-        template <class T> bool summarizeOverlap(T & rt_container)
+        template <class R> bool summarizeOverlap(R & range)
         {
-            bool summarized = false;
+            struct Open
+            {
+                PrefixKey key;
+                uint32_t plen;
+                int metric;
+                typename R::iterator rt;
+            };
 
-            rt_container.sort(
-                  static_cast<bool (*)(const typename T::value_type &,
-                                       const typename T::value_type &)>
-                                      (overlapCmp));
+            bool summarized = false;
+            std::vector<Open> open;
 
-            typename T::iterator cur = rt_container.begin();
-            if (cur == rt_container.end())
-            {
-                return false;
-            }
+            PhaseTimer sort_timer(phaseTime(Stats::PHASE_SORT));
+            range.sort(ORDER_OVERLAP);
+            sort_timer.stop();
 
-            typename T::value_type * prev = &(*cur);
+            PhaseTimer timer(phaseTime(Stats::PHASE_OVERLAP));
 
-            /* prev starts loop at element 0, cur starts at element 1 */
-            for (cur++; cur != rt_container.end(); prev = &(*cur++))
+            for (typename R::iterator cur = range.begin();
+                 cur != range.end();
+                 cur++)
             {
-                /* Lower network ANDed with higher mask must equal higher
-                 * network.
+                PrefixKey key = routeKey(*cur);
+
+                /* Routes that don't contain cur can't contain anything
+                 * after it either.
                  */
-                if ((cur->getNetworkN() & prev->getMaskN()) !=
-                    prev->getNetworkN())
+                while (open.empty() == false &&
+                       open.back().key.contains(open.back().plen, key) == false)
                 {
-                    continue;
+                    open.pop_back();
                 }
 
                 /* Don't summarize if the summary route would have a
                  * higher metric than the more specific route.
                  */
-                if (cur->getMetric() < prev->getMetric())
+                if (open.empty() == true || cur->getMetric() < open.back().metric)
                 {
+                    Open entry;
+                    entry.key = key;
+                    entry.plen = cur->getPlen();
+                    entry.metric = cur->getMetric();
+                    entry.rt = cur;
+
+                    open.push_back(entry);
                     continue;
                 }
 
                 /* Overlapping prefixes, remove the less specific one */
-                log("*   Removing '" + cur->str() +
-                    "', which falls within '" + prev->str() + "'\n");
+                ACRS_LOG(m_log, "*   Removing '" << cur->str() <<
+                         "', which falls within '" << open.back().rt->str() <<
+                         "'\n");
 
-                cur = rt_container.erase(cur);
+                range.drop(cur);
+                count(&Stats::overlaps);
                 summarized = true;
-
-                /* Reduce cur by one so when it gets incremented
-                 * by the for loop it returns to the correct location
-                 */
-                 cur--;
             }
 
+            range.compact();
+
             return summarized;
         };
 
         /* Summarize a route list without caring about overlap.
          * Return true if any summarization was done, return false otherwise.
          */
-        template <class T> bool summarizeMain(T & rt_container)
+        template <class R> bool summarizeMain(R & range)
         {
             bool summarized = false;
 
-            rt_container.sort(
-                  static_cast<bool (*)(const typename T::value_type &,
-                                       const typename T::value_type &)>
-                                      (acrsCmp));
+            PhaseTimer sort_timer(phaseTime(Stats::PHASE_SORT));
+            range.sort(ORDER_ACRS);
+            sort_timer.stop();
+
+            PhaseTimer timer(phaseTime(Stats::PHASE_MERGE));
+            size_t candidates = 0;
+            count(&Stats::passes);
 
             m_main_recurse_count++;
-            std::stringstream rc;
-            rc << m_main_recurse_count;
-            log("*   Pass " + rc.str() + "\n");
+            ACRS_LOG(m_log, "*   Pass " << m_main_recurse_count << "\n");
 
-            typename T::iterator cur = rt_container.begin();
+            typename R::iterator cur = range.begin();
 
-            if (cur == rt_container.end())
+            if (cur == range.end())
             {
                 return false;
             }
 
-            typename T::value_type * prev = &(*cur);
+            typename R::iterator prev = cur;
+            PrefixKey prev_key = routeKey(*prev);
             cur++;
 
-            /* prev starts loop at element 0, cur starts at element 1 */
-            for (; cur != rt_container.end(); prev = &(*cur), cur++)
+            /* prev starts loop at element 0, cur starts at element 1.
+             * Removed routes are only marked until the pass is over, so
+             * prev stays put when cur is removed.
+             */
+            for (; cur != range.end(); cur++)
             {
+                PrefixKey cur_key = routeKey(*cur);
+                candidates++;
+
                 /* Prefix lengths must match */
                 if (prev->getPlen() != cur->getPlen())
                 {
+                    prev = cur;
+                    prev_key = cur_key;
                     continue;
                 }
 
                 /* Metrics must match */
                 if (prev->getMetric() != cur->getMetric())
                 {
+                    prev = cur;
+                    prev_key = cur_key;
                     continue;
                 }
 
@@ -221,6 +298,8 @@ namespace Acrs
                  */
                 if (prev->getPlen() == 0)
                 {
+                    prev = cur;
+                    prev_key = cur_key;
                     continue;
                 }
 
@@ -228,137 +307,941 @@ namespace Acrs
                  * might as well remove them now so we save a little time
                  * during overlap removal.
                  */
-                if (cur->getNetworkN() == prev->getNetworkN())
+                if (cur_key == prev_key)
                 {
-                    log("*     Removed duplicate prefix: '" +
-                        prev->str() + "'\n");
-                    cur = rt_container.erase(cur);
-
-                    /* Reduce cur by one so when it gets incremented by
-                     * the for loop it returns to the correct location
-                     */
-                    cur--;
+                    ACRS_LOG(m_log, "*     Removed duplicate prefix: '" <<
+                             prev->str() << "'\n");
+                    range.drop(cur);
+                    count(&Stats::duplicates);
                     summarized = true;
 
                     continue;
                 }
 
-                /* Store prev in string form now, before its plen is
-                 * decremented. This way it doesn't need to be incremented then
-                 * decremented again if it can be summarized, in order to be
-                 * logged.
-                 */
-                std::string old_prev_str = prev->str();
-
-                /* 1. Temporarily reduce prev's prefix length by one
-                 * 2. Apply original prefix length to the new broadcast address
-                 *    (cur's plen is the original, so it's safe to use
-                 *     that)
-                 * 3. Network addresses must match to summarize
+                /* prev must be the lower half of a prefix one bit shorter,
+                 * and cur the upper half of the same prefix.
                  */
-                prev->setPlen(prev->getPlen() - 1);
+                uint32_t last_bit = prev->getPlen() - 1;
 
-                typename T::value_type possible(prev->getBroadcastN().getAddr(),
-                                                cur->getPlen());
-
-                if (possible.getNetworkN() != cur->getNetworkN())
+                if (prev_key.bit(last_bit) != 0 ||
+                    prev_key.withBit(last_bit, 1) != cur_key)
                 {
-                    /* Set prev's plen back to what it used to be */
-                    prev->setPlen(prev->getPlen() + 1);
+                    prev = cur;
+                    prev_key = cur_key;
                     continue;
                 }
 
-                log("*     Summarized '" + old_prev_str + "' and '" +
-                    cur->str() + "' into '" + prev->str() + "'\n");
+                /* Store prev in string form now, before its plen is
+                 * decremented, in order to be logged.
+                 */
+                std::string old_prev_str;
+
+                if (m_log.enabled() == true)
+                {
+                    old_prev_str = prev->str();
+                }
 
                 /* Summarize the routes by:
-                 *   1) Decrementing prev's plen (already done above)
-                 *   2) Deleting cur
+                 *   1) Decrementing prev's plen (its network is unchanged,
+                 *      as the dropped bit is already 0)
+                 *   2) Removing cur
                  */
-                cur = rt_container.erase(cur);
+                prev->setPlen(last_bit);
+
+                ACRS_LOG(m_log, "*     Summarized '" << old_prev_str <<
+                         "' and '" << cur->str() << "' into '" <<
+                         prev->str() << "'\n");
+
+                range.drop(cur);
+                count(&Stats::merges);
                 summarized = true;
 
-                /* Reduce cur by one so when it gets incremented by
-                 * the for loop it returns to the correct location
+                /* Duplicates of cur sort right after it. Remove them now,
+                 * since prev no longer has cur's prefix length and they
+                 * would otherwise be left behind without a sibling.
                  */
-                cur--;
+                typename R::iterator next = cur;
+
+                for (next++; next != range.end(); next++)
+                {
+                    if (next->getPlen() != cur->getPlen() ||
+                        next->getMetric() != cur->getMetric() ||
+                        routeKey(*next) != cur_key)
+                    {
+                        break;
+                    }
+
+                    ACRS_LOG(m_log, "*     Removed duplicate prefix: '" <<
+                             next->str() << "'\n");
+                    range.drop(next);
+                    count(&Stats::duplicates);
+                    cur = next;
+                }
             }
 
+            range.compact();
+
+            count(&Stats::candidates, candidates);
+            timer.stop();
+
             /* If we summarized at all on this iteration, go over the
              * list again.
              */
             if (summarized == true)
             {
-                summarizeMain(rt_container);
+                summarizeMain(range);
                 return true;
             }
             else
             {
-                log("*     No routes to summarize on this pass.\n");
+                ACRS_LOG(m_log, "*     No routes to summarize on this pass.\n");
                 return false;
             }
         };
 
-        void log(const std::string & msg) const
+        /* Applies the results of a PrefixTrie walk to a route range.
+         * Surviving routes are given their final prefix length in place
+         * and their positions are collected in output order.
+         */
+        template <class R> class TrieListener
         {
-            if (m_logging == false)
+        private:
+            typedef typename R::value_type Route;
+
+            const Acrs & m_acrs;
+            std::vector<typename R::iterator> & m_routes;
+            std::vector<uint32_t> m_kept;
+            size_t m_candidates;
+
+            /* Copy of a route with a different prefix length, for logging */
+            std::string strAt(uint32_t index, uint32_t plen) const
+            {
+                Route rt(*m_routes[index]);
+                rt.setPlen(plen);
+
+                return rt.str();
+            };
+
+        public:
+            void onCandidate()
+            {
+                m_candidates++;
+            };
+
+            void onMerge(uint32_t lower, uint32_t upper, uint32_t plen)
+            {
+                m_acrs.count(&Stats::merges);
+                ACRS_LOG(m_acrs.m_log, "*     Summarized '" <<
+                         strAt(lower, plen + 1) << "' and '" <<
+                         strAt(upper, plen + 1) << "' into '" <<
+                         strAt(lower, plen) << "'\n");
+            };
+
+            void onDuplicate(uint32_t kept, uint32_t /* dropped */,
+                             uint32_t plen)
+            {
+                m_acrs.count(&Stats::duplicates);
+                ACRS_LOG(m_acrs.m_log, "*     Removed duplicate prefix: '" <<
+                         strAt(kept, plen) << "'\n");
+            };
+
+            void onOverlap(uint32_t removed, uint32_t removed_plen,
+                           uint32_t covering, uint32_t covering_plen)
+            {
+                m_acrs.count(&Stats::overlaps);
+                ACRS_LOG(m_acrs.m_log, "*   Removing '" <<
+                         strAt(removed, removed_plen) <<
+                         "', which falls within '" <<
+                         strAt(covering, covering_plen) << "'\n");
+            };
+
+            void onRoute(uint32_t rep, uint32_t plen)
             {
-                return;
+                typename R::iterator iter = m_routes[rep];
+
+                if (iter->getPlen() != plen)
+                {
+                    iter->setPlen(plen);
+                }
+
+                m_kept.push_back(rep);
+            };
+
+            const std::vector<uint32_t> & kept()
+            {
+                return m_kept;
+            };
+
+            size_t candidates()
+            {
+                return m_candidates;
+            };
+
+            TrieListener(const Acrs & acrs,
+                         std::vector<typename R::iterator> & routes)
+                         :
+                         m_acrs(acrs), m_routes(routes), m_candidates(0) {};
+        };
+
+        /* Summarize in a single traversal of a binary prefix trie. The
+         * result is the same as summarizeMain followed by summarizeOverlap,
+         * or summarizeMain alone if 'remove_overlap' is false.
+         * Return true if any summarization was done, return false otherwise.
+         */
+        template <class R> bool summarizeTrie(R & range,
+                                              bool remove_overlap = true)
+        {
+            std::vector<typename R::iterator> routes;
+            PrefixTrie trie;
+            TrieListener<R> listener(*this, routes);
+
+            routes.reserve(range.size());
+
+            for (typename R::iterator iter = range.begin();
+                 iter != range.end();
+                 iter++)
+            {
+                routes.push_back(iter);
             }
 
-            m_os << msg << std::flush;
+            PhaseTimer merge_timer(phaseTime(Stats::PHASE_MERGE));
+            trie.reserve(routes.size());
+
+            for (uint32_t i = 0; i < routes.size(); i++)
+            {
+                trie.insert(routeKey(*routes[i]), routes[i]->getPlen(),
+                            routes[i]->getMetric(), i, listener);
+            }
+
+            trie.mergeSiblings(listener);
+            merge_timer.stop();
+
+            PhaseTimer overlap_timer(phaseTime(Stats::PHASE_OVERLAP));
+            trie.removeOverlap(listener, remove_overlap);
+
+            bool summarized = (listener.kept().size() < routes.size());
+
+            range.select(listener.kept());
+            overlap_timer.stop();
+
+            count(&Stats::passes);
+            count(&Stats::candidates, listener.candidates());
+
+            return summarized;
         };
 
-    public:
-        template <class T> bool summarize(T & rt_container)
+        /* Sibling merging alone, with the selected engine */
+        template <class R> bool summarizeMerges(R & range)
+        {
+            if (m_engine == ENGINE_TRIE)
+            {
+                return summarizeTrie(range, false);
+            }
+
+            return summarizeMain(range);
+        };
+
+        enum
+        {
+            SHARD_BITS_STEP = 8,    /* Shard on 8, 16, 24... leading bits */
+            SHARD_BITS_MAX = 40     /* Leaves room for the metric in the
+                                     * shard key */
+        };
+
+        /* Shard key: the metric and the first 'bits' bits of the network */
+        static uint64_t shardKey(int metric, const PrefixKey & key,
+                                 uint32_t bits)
+        {
+            return ((uint64_t) (uint32_t) metric << SHARD_BITS_MAX) |
+                   (key.hi >> (64 - bits));
+        };
+
+        /* Pick how many leading address bits to shard on. Routes shorter
+         * than that go to the serial fix-up, and the largest shard is the
+         * longest single task, so take the candidate that keeps the bigger
+         * of the two smallest. Stop early once both are small enough to
+         * keep every thread busy.
+         */
+        template <class I> uint32_t chooseShardBits(
+                                    const std::vector<I> & routes,
+                                    const std::vector<PrefixKey> & keys)
+        {
+            size_t count = routes.size();
+            size_t good_enough = count / (2 * m_threads) + 1;
+            uint32_t limit = routes[0]->getMaxPlen() - SHARD_BITS_STEP;
+            uint32_t best_bits = SHARD_BITS_STEP;
+            size_t best_cost = count + 1;
+
+            if (limit > SHARD_BITS_MAX)
+            {
+                limit = SHARD_BITS_MAX;
+            }
+
+            for (uint32_t bits = SHARD_BITS_STEP; bits <= limit;
+                 bits += SHARD_BITS_STEP)
+            {
+                std::unordered_map<uint64_t, size_t> sizes;
+                size_t shorter = 0;
+                size_t largest = 0;
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    if (routes[i]->getPlen() < bits)
+                    {
+                        shorter++;
+                        continue;
+                    }
+
+                    size_t & size = sizes[shardKey(routes[i]->getMetric(),
+                                                   keys[i], bits)];
+                    largest = std::max(largest, ++size);
+                }
+
+                size_t cost = std::max(largest, shorter);
+
+                if (cost < best_cost)
+                {
+                    best_cost = cost;
+                    best_bits = bits;
+                }
+
+                if (cost <= good_enough)
+                {
+                    break;
+                }
+            }
+
+            return best_bits;
+        };
+
+        /* Summarizes one shard on a pool thread */
+        template <class Route> class ShardTask
+        {
+        private:
+            const Acrs & m_acrs;
+            std::vector<std::vector<Route> > & m_shards;
+            const std::vector<size_t> & m_order;
+            std::vector<Stats> * m_stats;    /* One per shard, or NULL */
+
+        public:
+            void operator()(size_t task)
+            {
+                std::vector<Route> & shard = m_shards[m_order[task]];
+                ArrayRange<typename std::vector<Route>::iterator>
+                    range(shard.begin(), shard.end());
+
+                /* Shards are summarized without logging, as the output
+                 * of several threads would interleave.
+                 */
+                Acrs worker(m_acrs.m_log.stream(), false, m_acrs.m_engine);
+
+                if (m_stats != NULL)
+                {
+                    worker.m_stats = &(*m_stats)[task];
+                }
+
+                worker.summarizeMerges(range);
+
+                shard.erase(range.end(), shard.end());
+            };
+
+            ShardTask(const Acrs & acrs,
+                      std::vector<std::vector<Route> > & shards,
+                      const std::vector<size_t> & order,
+                      std::vector<Stats> * stats)
+                      :
+                      m_acrs(acrs), m_shards(shards), m_order(order),
+                      m_stats(stats) {};
+        };
+
+        /* Summarize on several threads.
+         *
+         * Routes with different metrics never merge, and merging inside a
+         * block of addresses with the same first 'bits' bits only produces
+         * prefixes inside that block. So routes at least 'bits' long are
+         * split into shards by (metric, block) and merged independently.
+         * The only merges left are between whole blocks and the shorter
+         * routes, which a serial fix-up pass handles. It sees the shorter
+         * routes plus every shard result that covers its whole block.
+         * Overlap removal then runs once over everything.
+         *
+         * Shards keep their routes in input order and every step applies
+         * the same rules, so the result is the same as summarizing on one
+         * thread.
+         */
+        template <class R> bool summarizeParallel(R & range)
+        {
+            typedef typename R::value_type Route;
+
+            std::vector<typename R::iterator> routes;
+            std::vector<PrefixKey> keys;
+
+            routes.reserve(range.size());
+            keys.reserve(range.size());
+
+            for (typename R::iterator iter = range.begin();
+                 iter != range.end();
+                 iter++)
+            {
+                routes.push_back(iter);
+                keys.push_back(routeKey(*iter));
+            }
+
+            if (routes.empty() == true)
+            {
+                ACRS_LOG(m_log, "* Finished. No summarization performed.\n");
+                return false;
+            }
+
+            /* Sharding and the shards' own merging count as merging */
+            PhaseTimer shard_timer(phaseTime(Stats::PHASE_MERGE));
+            uint32_t bits = chooseShardBits(routes, keys);
+
+            /* Split into shards, in input order */
+            std::unordered_map<uint64_t, size_t> shard_index;
+            std::vector<std::vector<Route> > shards;
+            std::vector<Route> fixup;
+
+            for (size_t i = 0; i < routes.size(); i++)
+            {
+                if (routes[i]->getPlen() < bits)
+                {
+                    fixup.push_back(*routes[i]);
+                    continue;
+                }
+
+                uint64_t key = shardKey(routes[i]->getMetric(), keys[i], bits);
+                std::pair<std::unordered_map<uint64_t, size_t>::iterator,
+                          bool> found =
+                    shard_index.insert(std::make_pair(key, shards.size()));
+
+                if (found.second == true)
+                {
+                    shards.push_back(std::vector<Route>());
+                }
+
+                shards[found.first->second].push_back(*routes[i]);
+            }
+
+            /* Largest shards first, so they start first */
+            std::vector<std::pair<size_t, size_t> > by_size;
+
+            for (size_t i = 0; i < shards.size(); i++)
+            {
+                by_size.push_back(std::make_pair(shards[i].size(), i));
+            }
+
+            std::sort(by_size.rbegin(), by_size.rend());
+
+            std::vector<size_t> order;
+
+            for (size_t i = 0; i < by_size.size(); i++)
+            {
+                order.push_back(by_size[i].second);
+            }
+
+            ACRS_LOG(m_log, "* Parallel summarization: " << shards.size() <<
+                     " shards by metric and first " << bits << " bits, " <<
+                     fixup.size() << " shorter routes, " << m_threads <<
+                     " threads\n");
+
+            /* Workers count into their own stats, added up afterwards */
+            std::vector<Stats> shard_stats;
+
+            if (m_stats != NULL)
+            {
+                shard_stats.resize(shards.size());
+            }
+
+            ShardTask<Route> task(*this, shards, order,
+                                  (m_stats == NULL) ? NULL : &shard_stats);
+            WorkPool pool;
+            pool.run(order.size(), m_threads, task);
+
+            for (size_t i = 0; i < shard_stats.size(); i++)
+            {
+                m_stats->addCounts(shard_stats[i]);
+            }
+
+            shard_timer.stop();
+
+            /* Shard results covering a whole block may merge with their
+             * neighbours or with shorter routes.
+             */
+            std::vector<Route> merged;
+
+            for (size_t i = 0; i < shards.size(); i++)
+            {
+                for (size_t j = 0; j < shards[i].size(); j++)
+                {
+                    if (shards[i][j].getPlen() <= bits)
+                    {
+                        fixup.push_back(shards[i][j]);
+                    }
+                    else
+                    {
+                        merged.push_back(shards[i][j]);
+                    }
+                }
+
+                std::vector<Route>().swap(shards[i]);
+            }
+
+            ACRS_LOG(m_log, "* Boundary fix-up:\n");
+            ArrayRange<typename std::vector<Route>::iterator>
+                fixup_range(fixup.begin(), fixup.end());
+
+            if (summarizeMerges(fixup_range) == false)
+            {
+                ACRS_LOG(m_log,
+                         "*   No routes affected by boundary fix-up.\n");
+            }
+
+            merged.insert(merged.end(), fixup.begin(), fixup_range.end());
+
+            ACRS_LOG(m_log, "* Overlap removal:\n");
+            ArrayRange<typename std::vector<Route>::iterator>
+                merged_range(merged.begin(), merged.end());
+
+            if (summarizeOverlap(merged_range) == false)
+            {
+                ACRS_LOG(m_log, "*   No overlapping routes.\n");
+            }
+
+            bool summarized = (merged_range.size() < routes.size());
+            range.assign(merged.begin(), merged_range.end());
+
+            if (summarized == true)
+            {
+                ACRS_LOG(m_log, "* Finished. List was summarized.\n");
+            }
+            else
+            {
+                ACRS_LOG(m_log, "* Finished. No summarization performed.\n");
+            }
+
+            return summarized;
+        };
+
+        /* Applies the results of a BudgetMerger to a route range */
+        template <class R> class BudgetListener
+        {
+        private:
+            Acrs & m_acrs;
+            R & m_range;
+            std::vector<typename R::iterator> & m_routes;
+
+        public:
+            void onSummary(uint32_t rep, uint32_t plen, double extra)
+            {
+                std::string old_str;
+
+                if (m_acrs.m_log.enabled() == true)
+                {
+                    old_str = m_routes[rep]->str();
+                }
+
+                m_routes[rep]->setPlen(plen);
+                m_acrs.m_extra_space += extra;
+                m_acrs.count(&Stats::budget_summaries);
+
+                ACRS_LOG(m_acrs.m_log, "*     Summarized '" << old_str <<
+                         "' into '" << m_routes[rep]->str() << "', adding " <<
+                         extra << " addresses\n");
+            };
+
+            void onAbsorb(uint32_t dropped, uint32_t rep)
+            {
+                ACRS_LOG(m_acrs.m_log, "*       Removing '" <<
+                         m_routes[dropped]->str() <<
+                         "', which was taken into '" <<
+                         m_routes[rep]->str() << "'\n");
+                m_range.drop(m_routes[dropped]);
+            };
+
+            void onOverlap(uint32_t dropped, uint32_t rep)
+            {
+                ACRS_LOG(m_acrs.m_log, "*       Removing '" <<
+                         m_routes[dropped]->str() <<
+                         "', which falls within '" << m_routes[rep]->str() <<
+                         "'\n");
+                m_range.drop(m_routes[dropped]);
+                m_acrs.count(&Stats::overlaps);
+            };
+
+            BudgetListener(Acrs & acrs, R & range,
+                           std::vector<typename R::iterator> & routes)
+                           :
+                           m_acrs(acrs), m_range(range), m_routes(routes) {};
+        };
+
+        /* Summarize further, past what keeps every address routed as it
+         * was, until no more than m_max_routes routes are left. The
+         * routes must already be summarized exactly. The extra address
+         * space added is counted in m_extra_space.
+         * Return true if any summarization was done, return false otherwise.
+         */
+        template <class R> bool summarizeBudget(R & range)
         {
-            if (getLogging() == true)
+            std::vector<typename R::iterator> routes;
+            BudgetMerger merger;
+            BudgetListener<R> listener(*this, range, routes);
+
+            if (range.size() <= m_max_routes)
             {
-                m_main_recurse_count = 0;
+                return false;
             }
 
-            log("* Main summarization:\n");
-            bool mainsum = summarizeMain(rt_container);
+            ACRS_LOG(m_log, "* Budget summarization to " << m_max_routes <<
+                     " routes:\n");
+
+            PhaseTimer timer(phaseTime(Stats::PHASE_BUDGET));
+            routes.reserve(range.size());
+            merger.reserve(range.size());
+
+            for (typename R::iterator iter = range.begin();
+                 iter != range.end();
+                 iter++)
+            {
+                merger.insert(routeKey(*iter), iter->getPlen(),
+                              iter->getMetric(), routes.size());
+                routes.push_back(iter);
+            }
+
+            size_t left = merger.merge(m_max_routes,
+                                       range.begin()->getMaxPlen(), listener);
+            range.compact();
+            timer.stop();
+
+            if (left > m_max_routes)
+            {
+                ACRS_LOG(m_log, "*   Could not get below " << left <<
+                         " routes.\n");
+            }
+
+            /* Summaries start at or before the routes they took in */
+            PhaseTimer sort_timer(phaseTime(Stats::PHASE_SORT));
+            range.sort(ORDER_OVERLAP);
+            sort_timer.stop();
+
+            return (left < routes.size());
+        };
+
+        /* Replace the routes with the smallest table that routes every
+         * address with the same metric by longest prefix match, treating
+         * metrics as next hops rather than costs. Should the result come
+         * out larger, the routes are left as they were.
+         * Return true if any summarization was done, return false otherwise.
+         */
+        template <class R> bool summarizeOrtc(R & range)
+        {
+            typedef typename R::value_type Route;
+
+            struct Collector
+            {
+                std::vector<Route> routes;
+
+                void onRoute(const PrefixKey & key, uint32_t plen, int metric)
+                {
+                    routes.push_back(keyRoute<Route>(key, plen, metric));
+                };
+            };
+
+            OrtcTrie trie;
+            Collector result;
+
+            /* Inserting in order lays the nodes out depth first, which
+             * keeps the passes over them local. Tables are often given
+             * in order already.
+             */
+            PhaseTimer sort_timer(phaseTime(Stats::PHASE_SORT));
+            PrefixKey last = { 0, 0 };
+
+            for (typename R::iterator iter = range.begin();
+                 iter != range.end();
+                 iter++)
+            {
+                PrefixKey key = routeKey(*iter);
+
+                if (key < last)
+                {
+                    range.sort(ORDER_OVERLAP);
+                    break;
+                }
+
+                last = key;
+            }
+
+            sort_timer.stop();
+
+            PhaseTimer merge_timer(phaseTime(Stats::PHASE_MERGE));
+            trie.reserve(range.size());
+
+            for (typename R::iterator iter = range.begin();
+                 iter != range.end();
+                 iter++)
+            {
+                trie.insert(routeKey(*iter), iter->getPlen(),
+                            iter->getMetric());
+            }
+
+            trie.compress(result);
+            merge_timer.stop();
+
+            count(&Stats::passes);
+
+            ACRS_LOG(m_log, "*   " << range.size() << " routes compressed to " <<
+                     result.routes.size() << "\n");
+
+            if (result.routes.size() > range.size())
+            {
+                return false;
+            }
+
+            bool summarized = (result.routes.size() < range.size());
+            range.assign(result.routes.begin(), result.routes.end());
+
+            return summarized;
+        };
+
+        /* Feed every route's prefix length and metric to 'counter' */
+        template <class R> void countRoutes(R & range,
+                                            void (Stats::* counter)(uint32_t,
+                                                                    int))
+        {
+            for (typename R::iterator iter = range.begin();
+                 iter != range.end();
+                 iter++)
+            {
+                (m_stats->*counter)(iter->getPlen(), iter->getMetric());
+            }
+        };
+
+        /* Summarize with the selected engine and thread count */
+        template <class R> bool summarizeSelected(R & range)
+        {
+            if (m_engine == ENGINE_ORTC)
+            {
+                ACRS_LOG(m_log, "* ORTC compression:\n");
+                return summarizeOrtc(range);
+            }
+
+            if (m_threads > 1)
+            {
+                return summarizeParallel(range);
+            }
+
+            if (m_engine == ENGINE_TRIE)
+            {
+                ACRS_LOG(m_log, "* Trie summarization:\n");
+                bool triesum = summarizeTrie(range);
+
+                if (triesum == true)
+                {
+                    ACRS_LOG(m_log, "* Finished. List was summarized.\n");
+                }
+                else
+                {
+                    ACRS_LOG(m_log,
+                             "* Finished. No summarization performed.\n");
+                }
+
+                return triesum;
+            }
+
+            ACRS_LOG(m_log, "* Main summarization:\n");
+            bool mainsum = summarizeMain(range);
 
             if (mainsum == false)
             {
-                log("*   No routes affected by main summarization.\n");
+                ACRS_LOG(m_log,
+                         "*   No routes affected by main summarization.\n");
             }
 
-            log("* Overlap removal:\n");
-            bool overlapsum = summarizeOverlap(rt_container);
+            ACRS_LOG(m_log, "* Overlap removal:\n");
+            bool overlapsum = summarizeOverlap(range);
 
             if (overlapsum == false)
             {
-                log("*   No overlapping routes.\n");
+                ACRS_LOG(m_log, "*   No overlapping routes.\n");
             }
 
             if ((mainsum || overlapsum) == true)
             {
-                log("* Finished. List was summarized.\n");
+                ACRS_LOG(m_log, "* Finished. List was summarized.\n");
                 return true;
             }
             else
             {
-                log("* Finished. No summarization performed.\n");
+                ACRS_LOG(m_log, "* Finished. No summarization performed.\n");
                 return false;
             }
         };
 
+        template <class R> bool summarizeRange(R & range)
+        {
+            m_main_recurse_count = 0;
+
+            if (m_stats != NULL)
+            {
+                m_stats->clear();
+                countRoutes(range, &Stats::countInput);
+            }
+
+            m_extra_space = 0;
+
+            MemUsage mem_start = (m_stats != NULL) ? MemUsage::now() :
+                                                     MemUsage();
+
+            PhaseTimer total_timer((m_stats == NULL) ? NULL : &m_stats->total);
+            bool summarized = summarizeSelected(range);
+
+            if (m_max_routes != 0 && m_engine != ENGINE_ORTC &&
+                summarizeBudget(range) == true)
+            {
+                summarized = true;
+            }
+
+            total_timer.stop();
+
+            if (m_stats != NULL)
+            {
+                MemUsage mem_end = MemUsage::now();
+
+                m_stats->extra_space = m_extra_space;
+                m_stats->allocations = mem_end.allocations -
+                                       mem_start.allocations;
+                m_stats->allocated_bytes = mem_end.bytes - mem_start.bytes;
+                m_stats->peak_rss = mem_end.peak_rss;
+
+                countRoutes(range, &Stats::countOutput);
+            }
+
+            /* The log must be out before the caller prints anything */
+            m_log.flush();
+
+            return summarized;
+        };
+
+    public:
+        /* Summarize a std::list (or any container with splice() and
+         * erase()) in place. Routes are relinked, never copied.
+         * Return true if any summarization was done, return false otherwise.
+         */
+        template <class T> bool summarize(T & rt_container)
+        {
+            ListRange<T> range(rt_container);
+
+            return summarizeRange(range);
+        };
+
+        /* Summarize a std::vector in place, then shrink it to the routes
+         * that are left.
+         * Return true if any summarization was done, return false otherwise.
+         */
+        template <class R, class A> bool summarize(std::vector<R, A> & rt_vector)
+        {
+            typename std::vector<R, A>::iterator last =
+                summarize(rt_vector.begin(), rt_vector.end());
+
+            bool summarized = (last != rt_vector.end());
+            rt_vector.erase(last, rt_vector.end());
+
+            return summarized;
+        };
+
+        /* Summarize the contiguous range [first, last), such as an array or
+         * part of a vector. The summarized routes are compacted to the
+         * front of the range and the new end is returned, in the manner of
+         * std::remove(). Routes past the new end are left in a valid but
+         * unspecified state.
+         */
+        template <class I> I summarize(I first, I last)
+        {
+            ArrayRange<I> range(first, last);
+
+            summarizeRange(range);
+
+            return range.end();
+        };
+
         void setLogging(bool logging)
         {
-            m_logging = logging;
+            m_log.setEnabled(logging);
         };
 
         bool getLogging()
         {
-            return m_logging;
+            return m_log.enabled();
+        };
+
+        void setEngine(Engine engine)
+        {
+            m_engine = engine;
+        };
+
+        Engine getEngine()
+        {
+            return m_engine;
+        };
+
+        /* Number of threads to summarize with. More than one selects the
+         * sharded parallel mode, which gives the same result. ENGINE_ORTC
+         * always runs on one.
+         */
+        void setThreads(unsigned int threads)
+        {
+            m_threads = (threads == 0) ? 1 : threads;
+        };
+
+        unsigned int getThreads()
+        {
+            return m_threads;
+        };
+
+        /* Keep summarizing past exact merges until no more than
+         * 'max_routes' routes are left, or 0 (the default) to stop at
+         * exact merges. This is lossy: see BudgetMerger. It is not done
+         * with ENGINE_ORTC, whose metrics are not costs.
+         */
+        void setMaxRoutes(size_t max_routes)
+        {
+            m_max_routes = max_routes;
+        };
+
+        size_t getMaxRoutes()
+        {
+            return m_max_routes;
+        };
+
+        /* Extra address space added by the last summarize() because of
+         * setMaxRoutes(): addresses the lossy summaries cover that no
+         * route did, at any metric
+         */
+        double getExtraSpace()
+        {
+            return m_extra_space;
+        };
+
+        /* Fill 'stats' on every summarize() from now on, or stop if NULL.
+         * The counters and times cover the last call only.
+         */
+        void setStats(Stats * stats)
+        {
+            m_stats = stats;
+        };
+
+        Stats * getStats()
+        {
+            return m_stats;
         };
 
         /* Constructor */
-        Acrs(std::ostream & os = std::cout, bool logging = false)
+        Acrs(std::ostream & os = std::cout, bool logging = false,
+             Engine engine = ENGINE_PASS)
              :
-             m_os(os), m_logging(logging) {};
+             m_log(os, logging), m_engine(engine), m_threads(1),
+             m_stats(NULL), m_max_routes(0), m_extra_space(0) {};
 
         /* Destructor */
         virtual ~Acrs() {};
@@ -0,0 +1,336 @@
+/* acrsarena.hpp -- Arena allocation for route containers
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ACRS_ARENA_H
+#define ACRS_ARENA_H
+
+#include <new>
+#include <vector>
+
+#include <stddef.h>
+#include <inttypes.h>
+#include <sys/mman.h>
+
+namespace Acrs
+{
+    /* Allocations an Arena has served, and what it took from the system
+     * to serve them
+     */
+    struct ArenaCounts
+    {
+        size_t allocations;     /* Calls to allocate() */
+        size_t frees;           /* Calls to deallocate() */
+        size_t reused;          /* Allocations served from freed memory */
+        size_t system;          /* Allocations made from the system */
+        size_t system_bytes;    /* Bytes they hold */
+    };
+
+    /* Memory for the nodes of a route list, such as a std::list of
+     * Route4 given an ArenaAllocator. With BACK_HEAP every allocation is
+     * passed to operator new, and only counted. Otherwise memory is carved
+     * from large blocks mapped from the system. Small pieces given back
+     * are kept on a free list per size and handed out again, since the
+     * summarizer erases routes as often as it adds them; larger ones are
+     * kept until release(). release() and the destructor return every
+     * block at once, instead of one call per route.
+     *
+     * BACK_HUGE maps blocks from reserved huge pages, or where none are
+     * reserved asks for transparent huge pages, cutting TLB misses when
+     * walking a large list.
+     *
+     * An Arena is not thread-safe. The summarizer only adds and removes
+     * routes on the calling thread, whatever setThreads() says.
+     */
+    class Arena
+    {
+    public:
+        enum Backing
+        {
+            BACK_HEAP,      /* operator new for every allocation (default) */
+            BACK_ARENA,     /* Blocks of ordinary pages */
+            BACK_HUGE       /* Blocks of huge pages */
+        };
+
+    private:
+        enum
+        {
+            GRAIN = 16,                     /* Sizes are rounded up to this */
+            POOLED = 256,                   /* Largest size kept for reuse */
+            BLOCK_SIZE = 4 << 20            /* A multiple of the huge page */
+        };
+
+        struct Block
+        {
+            void * start;
+            size_t size;
+        };
+
+        struct Free
+        {
+            Free * next;
+        };
+
+        Backing m_backing;
+        std::vector<Block> m_blocks;
+        char * m_next;
+        char * m_end;
+        Free * m_free[POOLED / GRAIN + 1];
+        ArenaCounts m_counts;
+
+        static size_t roundUp(size_t value, size_t to)
+        {
+            return (value + to - 1) / to * to;
+        };
+
+        /* Map a block of at least 'bytes' and carve from it from now on */
+        void addBlock(size_t bytes)
+        {
+            size_t size = roundUp(bytes, BLOCK_SIZE);
+            void * p_start = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+            if (m_backing == BACK_HUGE)
+            {
+                p_start = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                               -1, 0);
+            }
+#endif
+
+            if (p_start == MAP_FAILED)
+            {
+                p_start = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+                if (p_start == MAP_FAILED)
+                {
+                    throw std::bad_alloc();
+                }
+
+#ifdef MADV_HUGEPAGE
+                if (m_backing == BACK_HUGE)
+                {
+                    madvise(p_start, size, MADV_HUGEPAGE);
+                }
+#endif
+            }
+
+            Block block = { p_start, size };
+            m_blocks.push_back(block);
+
+            m_next = static_cast<char *>(p_start);
+            m_end = m_next + size;
+
+            m_counts.system++;
+            m_counts.system_bytes += size;
+        };
+
+    public:
+        void * allocate(size_t bytes, size_t align)
+        {
+            m_counts.allocations++;
+
+            if (m_backing == BACK_HEAP)
+            {
+                m_counts.system++;
+                m_counts.system_bytes += bytes;
+
+                return ::operator new(bytes);
+            }
+
+            bytes = roundUp((bytes == 0) ? 1 : bytes, GRAIN);
+
+            if (bytes <= POOLED && align <= GRAIN &&
+                m_free[bytes / GRAIN] != NULL)
+            {
+                Free * p_free = m_free[bytes / GRAIN];
+                m_free[bytes / GRAIN] = p_free->next;
+                m_counts.reused++;
+
+                return p_free;
+            }
+
+            /* Blocks start page aligned, and every size keeps the next
+             * piece GRAIN aligned
+             */
+            char * p_start = reinterpret_cast<char *>(
+                roundUp(reinterpret_cast<uintptr_t>(m_next), align));
+
+            if (m_next == NULL || p_start + bytes > m_end)
+            {
+                addBlock(bytes + align);
+                p_start = reinterpret_cast<char *>(
+                    roundUp(reinterpret_cast<uintptr_t>(m_next), align));
+            }
+
+            m_next = p_start + bytes;
+
+            return p_start;
+        };
+
+        void deallocate(void * p, size_t bytes, size_t align)
+        {
+            m_counts.frees++;
+
+            if (m_backing == BACK_HEAP)
+            {
+                ::operator delete(p);
+                return;
+            }
+
+            bytes = roundUp((bytes == 0) ? 1 : bytes, GRAIN);
+
+            if (bytes <= POOLED && align <= GRAIN)
+            {
+                Free * p_free = static_cast<Free *>(p);
+                p_free->next = m_free[bytes / GRAIN];
+                m_free[bytes / GRAIN] = p_free;
+            }
+        };
+
+        /* Return every block to the system. Nothing allocated from the
+         * arena may be used afterwards.
+         */
+        void release()
+        {
+            for (size_t i = 0; i < m_blocks.size(); i++)
+            {
+                munmap(m_blocks[i].start, m_blocks[i].size);
+            }
+
+            m_blocks.clear();
+            m_next = NULL;
+            m_end = NULL;
+
+            for (size_t i = 0; i <= POOLED / GRAIN; i++)
+            {
+                m_free[i] = NULL;
+            }
+        };
+
+        Backing getBacking() const
+        {
+            return m_backing;
+        };
+
+        const ArenaCounts & getCounts() const
+        {
+            return m_counts;
+        };
+
+        /* Constructor */
+        Arena(Backing backing = BACK_HEAP) : m_backing(backing), m_next(NULL),
+                                             m_end(NULL)
+        {
+            ArenaCounts zero = { 0, 0, 0, 0, 0 };
+            m_counts = zero;
+
+            for (size_t i = 0; i <= POOLED / GRAIN; i++)
+            {
+                m_free[i] = NULL;
+            }
+        };
+
+        /* Destructor */
+        ~Arena()
+        {
+            release();
+        };
+
+    private:
+        Arena(const Arena &);
+        Arena & operator=(const Arena &);
+    };
+
+    /* A standard allocator drawing on an Arena, so a container can keep
+     * its routes there:
+     *
+     *     Acrs::Arena arena(Acrs::Arena::BACK_ARENA);
+     *     std::list<IP::Route4, Acrs::ArenaAllocator<IP::Route4> >
+     *         routes((Acrs::ArenaAllocator<IP::Route4>(&arena)));
+     *
+     * The arena must outlive the container. A default constructed
+     * allocator has no arena and uses operator new.
+     */
+    template <class T> class ArenaAllocator
+    {
+    public:
+        typedef T value_type;
+        typedef T * pointer;
+        typedef const T * const_pointer;
+        typedef T & reference;
+        typedef const T & const_reference;
+        typedef size_t size_type;
+        typedef ptrdiff_t difference_type;
+
+        template <class U> struct rebind
+        {
+            typedef ArenaAllocator<U> other;
+        };
+
+        T * allocate(size_t count)
+        {
+            if (m_arena == NULL)
+            {
+                return static_cast<T *>(::operator new(count * sizeof(T)));
+            }
+
+            return static_cast<T *>(m_arena->allocate(count * sizeof(T),
+                                                      alignof(T)));
+        };
+
+        void deallocate(T * p, size_t count)
+        {
+            if (m_arena == NULL)
+            {
+                ::operator delete(p);
+                return;
+            }
+
+            m_arena->deallocate(p, count * sizeof(T), alignof(T));
+        };
+
+        template <class U> bool operator==(const ArenaAllocator<U> & other)
+            const
+        {
+            return m_arena == other.getArena();
+        };
+
+        template <class U> bool operator!=(const ArenaAllocator<U> & other)
+            const
+        {
+            return m_arena != other.getArena();
+        };
+
+        /* Constructors */
+        ArenaAllocator(Arena * arena = NULL) : m_arena(arena) {};
+
+        template <class U> ArenaAllocator(const ArenaAllocator<U> & other) :
+            m_arena(other.getArena()) {};
+
+        Arena * getArena() const
+        {
+            return m_arena;
+        };
+
+    private:
+        Arena * m_arena;
+    };
+}
+
+#endif /* ACRS_ARENA_H */
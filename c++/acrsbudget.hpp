@@ -0,0 +1,516 @@
+/* acrsbudget.hpp -- Lossy summarization down to a route budget
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ACRS_BUDGET_H
+#define ACRS_BUDGET_H
+
+#include <vector>
+#include <queue>
+#include <algorithm>
+
+#include <math.h>
+#include <inttypes.h>
+
+#include "acrskey.hpp"
+
+namespace Acrs
+{
+    /* Replaces routes with shorter prefixes covering them until no more
+     * than a given number are left. This is lossy: a summary may also
+     * cover addresses between its routes that no route covered. Those
+     * are its extra space; addresses another route already covered, at
+     * whatever metric, are not.
+     *
+     * A summary is only ever made of routes with the same metric, and
+     * takes that metric, so no address it routes gets a worse metric than
+     * its routes had, as in Acrs::summarizeMain(). Routes inside a summary
+     * with a higher metric are dropped, as overlap removal would; those
+     * with a lower metric are kept and still win by longest match.
+     *
+     * Candidates are the parents of neighbouring routes of the same
+     * metric: the longest prefix containing both, which takes in every
+     * route of that metric within it. They are taken from a priority
+     * queue by the extra space they would add, least first.
+     * The routes are expected to be summarized exactly first, in which
+     * case no route of a metric lies within a route of the same or a
+     * lower metric, and that stays true as summaries are made.
+     *
+     * Like PrefixTrie, the merger refers to routes by the index given to
+     * insert() and reports back through a listener object with these
+     * members:
+     *
+     *   onSummary(rep, plen, extra)  Route rep becomes a summary of length
+     *                                plen, adding 'extra' addresses that
+     *                                no route covered
+     *   onAbsorb(dropped, rep)       Route was taken into rep's summary
+     *   onOverlap(dropped, rep)      Route with a higher metric fell
+     *                                within rep's summary
+     */
+    class BudgetMerger
+    {
+    public:
+        enum
+        {
+            NONE = 0xffffffff
+        };
+
+    private:
+        /* A route, linked to its neighbours of the same metric and to its
+         * neighbours of any metric, in overlapCmp order, and to the
+         * closest route containing it
+         */
+        struct Node
+        {
+            PrefixKey key;
+            uint32_t plen;
+            int metric;
+            uint32_t rep;
+            uint32_t prev;
+            uint32_t next;
+            uint32_t all_prev;
+            uint32_t all_next;
+            uint32_t parent;
+            bool alive;
+        };
+
+        /* Summarizing 'left' and its neighbour 'right' into a prefix of
+         * length 'plen'
+         */
+        struct Candidate
+        {
+            double extra;
+            uint32_t plen;
+            uint32_t left;
+            uint32_t right;
+
+            /* Least extra space first, then the longest prefix, then the
+             * lowest address, so the order doesn't depend on the heap
+             */
+            bool operator<(const Candidate & other) const
+            {
+                if (extra != other.extra)
+                {
+                    return extra > other.extra;
+                }
+                else if (plen != other.plen)
+                {
+                    return plen < other.plen;
+                }
+
+                return left > other.left;
+            };
+        };
+
+        struct OverlapOrder
+        {
+            const std::vector<Node> & nodes;
+
+            OverlapOrder(const std::vector<Node> & all) : nodes(all) {};
+
+            bool operator()(uint32_t a, uint32_t b) const
+            {
+                if (nodes[a].key != nodes[b].key)
+                {
+                    return nodes[a].key < nodes[b].key;
+                }
+                else if (nodes[a].plen != nodes[b].plen)
+                {
+                    return nodes[a].plen < nodes[b].plen;
+                }
+
+                return nodes[a].metric < nodes[b].metric;
+            };
+        };
+
+        std::vector<Node> m_nodes;
+        std::priority_queue<Candidate> m_queue;
+        std::vector<uint32_t> m_open;
+        uint32_t m_width;
+        size_t m_alive;
+
+        static bool metricOrder(const Node & a, const Node & b)
+        {
+            if (a.metric != b.metric)
+            {
+                return a.metric < b.metric;
+            }
+            else if (a.key != b.key)
+            {
+                return a.key < b.key;
+            }
+
+            return a.plen < b.plen;
+        };
+
+        /* Addresses in a prefix of length 'plen' */
+        double space(uint32_t plen) const
+        {
+            return ldexp(1.0, m_width - plen);
+        };
+
+        bool inside(uint32_t n, const PrefixKey & key, uint32_t plen) const
+        {
+            return m_nodes[n].plen >= plen &&
+                   key.contains(plen, m_nodes[n].key);
+        };
+
+        /* Work out the summary of 'left' and the next route of its metric,
+         * and the space it adds: its own less that of the routes of any
+         * metric within it, or none if a route already contains it
+         */
+        bool makeCandidate(uint32_t left, Candidate & cand) const
+        {
+            uint32_t right = m_nodes[left].next;
+
+            if (right == NONE)
+            {
+                return false;
+            }
+
+            const Node & a = m_nodes[left];
+            const Node & b = m_nodes[right];
+
+            cand.plen = std::min(a.key.commonBits(b.key),
+                                 std::min(a.plen, b.plen));
+            cand.left = left;
+            cand.right = right;
+            cand.extra = 0;
+
+            PrefixKey key = a.key.masked(cand.plen);
+            uint32_t up = a.parent;
+
+            while (up != NONE && inside(up, key, cand.plen))
+            {
+                up = m_nodes[up].parent;
+            }
+
+            if (up != NONE)
+            {
+                return true;
+            }
+
+            /* Routes within it are together in overlapCmp order. Only
+             * the outermost add to what is covered.
+             */
+            double covered = 0;
+
+            for (int dir = 0; dir < 2; dir++)
+            {
+                uint32_t n = dir ? a.all_next : left;
+
+                while (n != NONE && inside(n, key, cand.plen))
+                {
+                    uint32_t parent = m_nodes[n].parent;
+
+                    if (parent == NONE ||
+                        inside(parent, key, cand.plen) == false)
+                    {
+                        covered += space(m_nodes[n].plen);
+                    }
+
+                    n = dir ? m_nodes[n].all_next : m_nodes[n].all_prev;
+                }
+            }
+
+            cand.extra = space(cand.plen) - covered;
+
+            return true;
+        };
+
+        /* Set the parent of every route from 'first' on, in overlapCmp
+         * order, while they fall within route 'outer'
+         */
+        void linkParents(uint32_t outer, uint32_t first)
+        {
+            m_open.clear();
+            m_open.push_back(outer);
+
+            for (uint32_t n = first;
+                 n != NONE && inside(n, m_nodes[outer].key,
+                                     m_nodes[outer].plen);
+                 n = m_nodes[n].all_next)
+            {
+                while (inside(n, m_nodes[m_open.back()].key,
+                              m_nodes[m_open.back()].plen) == false)
+                {
+                    m_open.pop_back();
+                }
+
+                m_nodes[n].parent = m_open.back();
+                m_open.push_back(n);
+            }
+        };
+
+        void push(uint32_t left)
+        {
+            Candidate cand;
+
+            if (left != NONE && makeCandidate(left, cand) == true)
+            {
+                m_queue.push(cand);
+            }
+        };
+
+        /* Unlink a route from both lists. Its neighbours of the same
+         * metric become a candidate.
+         */
+        void remove(uint32_t n)
+        {
+            Node & node = m_nodes[n];
+
+            if (node.prev != NONE)
+            {
+                m_nodes[node.prev].next = node.next;
+            }
+
+            if (node.next != NONE)
+            {
+                m_nodes[node.next].prev = node.prev;
+            }
+
+            if (node.all_prev != NONE)
+            {
+                m_nodes[node.all_prev].all_next = node.all_next;
+            }
+
+            if (node.all_next != NONE)
+            {
+                m_nodes[node.all_next].all_prev = node.all_prev;
+            }
+
+            node.alive = false;
+            m_alive--;
+
+            push(node.prev);
+        };
+
+        /* Unlink route 'n' from the list of every route and put it back
+         * before route 'at'
+         */
+        void moveBefore(uint32_t n, uint32_t at)
+        {
+            Node & node = m_nodes[n];
+
+            if (node.all_prev != NONE)
+            {
+                m_nodes[node.all_prev].all_next = node.all_next;
+            }
+
+            if (node.all_next != NONE)
+            {
+                m_nodes[node.all_next].all_prev = node.all_prev;
+            }
+
+            node.all_prev = m_nodes[at].all_prev;
+            node.all_next = at;
+
+            if (node.all_prev != NONE)
+            {
+                m_nodes[node.all_prev].all_next = n;
+            }
+
+            m_nodes[at].all_prev = n;
+        };
+
+        /* Make route 'n' the summary of length 'plen', and drop what falls
+         * within it. Every route within it is next to it in overlapCmp
+         * order. Those left (of lower metrics) may have come before it, so
+         * it is moved back in front of them.
+         */
+        template <class L> void summarize(uint32_t n, uint32_t plen,
+                                          double extra, L & listener)
+        {
+            Node & node = m_nodes[n];
+            node.key = node.key.masked(plen);
+            node.plen = plen;
+
+            while (node.parent != NONE && inside(node.parent, node.key, plen))
+            {
+                node.parent = m_nodes[node.parent].parent;
+            }
+
+            listener.onSummary(node.rep, plen, extra);
+
+            uint32_t first_kept = NONE;
+
+            for (int dir = 0; dir < 2; dir++)
+            {
+                uint32_t cur = dir ? node.all_next : node.all_prev;
+
+                while (cur != NONE && inside(cur, node.key, plen))
+                {
+                    uint32_t following = dir ? m_nodes[cur].all_next :
+                                               m_nodes[cur].all_prev;
+
+                    if (m_nodes[cur].metric == node.metric)
+                    {
+                        listener.onAbsorb(m_nodes[cur].rep, node.rep);
+                        remove(cur);
+                    }
+                    else if (m_nodes[cur].metric > node.metric)
+                    {
+                        listener.onOverlap(m_nodes[cur].rep, node.rep);
+                        remove(cur);
+                    }
+                    else if (dir == 0)
+                    {
+                        first_kept = cur;
+                    }
+
+                    cur = following;
+                }
+            }
+
+            if (first_kept != NONE)
+            {
+                moveBefore(n, first_kept);
+            }
+
+            /* What is left within it was within routes now gone */
+            linkParents(n, node.all_next);
+
+            push(node.prev);
+            push(n);
+        };
+
+    public:
+        void reserve(size_t routes)
+        {
+            m_nodes.reserve(routes);
+        };
+
+        /* Add route 'rep' to be summarized */
+        void insert(const PrefixKey & key, uint32_t plen, int metric,
+                    uint32_t rep)
+        {
+            Node node;
+            node.key = key;
+            node.plen = plen;
+            node.metric = metric;
+            node.rep = rep;
+            node.alive = true;
+
+            m_nodes.push_back(node);
+        };
+
+        /* Summarize until no more than 'max_routes' are left or nothing
+         * more can be summarized. 'width' is the address length, 32 or
+         * 128. Return the number of routes left.
+         */
+        template <class L> size_t merge(size_t max_routes, uint32_t width,
+                                        L & listener)
+        {
+            m_width = width;
+            m_alive = m_nodes.size();
+
+            /* Link the routes of each metric in address order */
+            std::sort(m_nodes.begin(), m_nodes.end(), metricOrder);
+
+            for (uint32_t n = 0; n < m_nodes.size(); n++)
+            {
+                bool linked = (n > 0 &&
+                               m_nodes[n - 1].metric == m_nodes[n].metric);
+
+                m_nodes[n].prev = linked ? n - 1 : NONE;
+                m_nodes[n].next = NONE;
+
+                if (linked == true)
+                {
+                    m_nodes[n - 1].next = n;
+                }
+            }
+
+            /* Then every route in overlapCmp order */
+            std::vector<uint32_t> order(m_nodes.size());
+
+            for (uint32_t n = 0; n < order.size(); n++)
+            {
+                order[n] = n;
+            }
+
+            std::sort(order.begin(), order.end(), OverlapOrder(m_nodes));
+
+            for (uint32_t i = 0; i < order.size(); i++)
+            {
+                Node & node = m_nodes[order[i]];
+                node.all_prev = (i > 0) ? order[i - 1] : NONE;
+                node.all_next = (i + 1 < order.size()) ? order[i + 1] : NONE;
+                node.parent = NONE;
+            }
+
+            /* Each route's parent is the closest before it containing it */
+            m_open.clear();
+
+            for (uint32_t i = 0; i < order.size(); i++)
+            {
+                uint32_t n = order[i];
+
+                while (m_open.empty() == false &&
+                       inside(n, m_nodes[m_open.back()].key,
+                              m_nodes[m_open.back()].plen) == false)
+                {
+                    m_open.pop_back();
+                }
+
+                if (m_open.empty() == false)
+                {
+                    m_nodes[n].parent = m_open.back();
+                }
+
+                m_open.push_back(n);
+            }
+
+            for (uint32_t n = 0; n < m_nodes.size(); n++)
+            {
+                push(n);
+            }
+
+            while (m_alive > max_routes && m_queue.empty() == false)
+            {
+                Candidate cand = m_queue.top();
+                m_queue.pop();
+
+                /* Either side may have been dropped or grown since */
+                if (m_nodes[cand.left].alive == false ||
+                    m_nodes[cand.left].next != cand.right)
+                {
+                    continue;
+                }
+
+                Candidate now;
+                makeCandidate(cand.left, now);
+
+                if (now.extra > cand.extra || now.plen != cand.plen)
+                {
+                    m_queue.push(now);
+                    continue;
+                }
+
+                summarize(cand.left, now.plen, now.extra, listener);
+            }
+
+            return m_alive;
+        };
+
+        /* Constructor */
+        BudgetMerger() : m_width(0), m_alive(0) {};
+
+    };
+}
+
+#endif /* ACRS_BUDGET_H */
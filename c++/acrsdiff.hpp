@@ -0,0 +1,252 @@
+/* acrsdiff.hpp -- Differences between two route sets
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ACRS_DIFF_H
+#define ACRS_DIFF_H
+
+#include <vector>
+#include <utility>
+
+#include "acrsspace.hpp"
+
+namespace Acrs
+{
+    /* What changed from an old route set to a new one, such as two
+     * results of Acrs::summarize(). Either set may be any range of routes
+     * (Route4, Route6 or their packed forms); the results are routes of
+     * type R. Both sets are walked once, in overlapCmp order, in a single
+     * merge. Sets already in that order, as summarize() leaves them, are
+     * not sorted again.
+     *
+     * Results are reported by network, in overlapCmp order. Host bits
+     * given with routes are not kept.
+     */
+    template <class R> class RouteDiff : private SpaceSweep
+    {
+    public:
+        std::vector<R> added;       /* Only in the new set */
+        std::vector<R> removed;     /* Only in the old set */
+        std::vector<std::pair<R, R> > changed;
+                                    /* In both with other metrics, as
+                                     * (old, new) */
+
+    private:
+        static R makeRoute(const Entry & entry)
+        {
+            return keyRoute<R>(entry.key, entry.plen, entry.metric);
+        };
+
+        /* Report the entries of one prefix, [a, a_end) old and [b, b_end)
+         * new, sorted by metric. Metrics in both cancel out. A prefix left
+         * with one metric on each side changed metric.
+         */
+        void diffGroup(const Entry * a, const Entry * a_end,
+                       const Entry * b, const Entry * b_end)
+        {
+            std::vector<const Entry *> gone;
+            std::vector<const Entry *> came;
+
+            while (a != a_end || b != b_end)
+            {
+                if (b == b_end || (a != a_end && a->metric < b->metric))
+                {
+                    gone.push_back(a++);
+                }
+                else if (a == a_end || b->metric < a->metric)
+                {
+                    came.push_back(b++);
+                }
+                else
+                {
+                    a++;
+                    b++;
+                }
+            }
+
+            if (gone.size() == 1 && came.size() == 1)
+            {
+                changed.push_back(std::make_pair(makeRoute(*gone[0]),
+                                                 makeRoute(*came[0])));
+                return;
+            }
+
+            for (size_t i = 0; i < gone.size(); i++)
+            {
+                removed.push_back(makeRoute(*gone[i]));
+            }
+
+            for (size_t i = 0; i < came.size(); i++)
+            {
+                added.push_back(makeRoute(*came[i]));
+            }
+        };
+
+        /* Add the blocks from 'start' to 'end' inclusive as the fewest
+         * prefixes
+         */
+        void addRange(PrefixKey start, const PrefixKey & end,
+                      int old_metric, int new_metric)
+        {
+            while (true)
+            {
+                /* The shortest prefix starting here that ends in time */
+                uint32_t plen = 0;
+
+                while (start.masked(plen) != start ||
+                       end < start.last(plen))
+                {
+                    plen++;
+                }
+
+                Entry entry;
+                entry.key = start;
+                entry.plen = plen;
+
+                if (old_metric == NO_METRIC)
+                {
+                    entry.metric = new_metric;
+                    added.push_back(makeRoute(entry));
+                }
+                else if (new_metric == NO_METRIC)
+                {
+                    entry.metric = old_metric;
+                    removed.push_back(makeRoute(entry));
+                }
+                else
+                {
+                    entry.metric = old_metric;
+                    R old_route = makeRoute(entry);
+                    entry.metric = new_metric;
+                    changed.push_back(std::make_pair(old_route,
+                                                     makeRoute(entry)));
+                }
+
+                PrefixKey last = start.last(plen);
+
+                if (last == end)
+                {
+                    return;
+                }
+
+                start = last.next();
+            }
+        };
+
+    public:
+        /* Compare two route sets prefix by prefix. A prefix is added or
+         * removed if it is in only one set, and changed if it is in both
+         * with a different metric. [old_first, old_last) is the old set and
+         * [new_first, new_last) the new one.
+         */
+        template <class I, class J> void diffPrefixes(I old_first,
+                                                      I old_last,
+                                                      J new_first,
+                                                      J new_last)
+        {
+            std::vector<Entry> old_set;
+            std::vector<Entry> new_set;
+
+            clear();
+            getEntries(old_first, old_last, old_set);
+            getEntries(new_first, new_last, new_set);
+
+            const Entry * a = old_set.empty() ? 0 : &old_set[0];
+            const Entry * a_end = a + old_set.size();
+            const Entry * b = new_set.empty() ? 0 : &new_set[0];
+            const Entry * b_end = b + new_set.size();
+
+            while (a != a_end || b != b_end)
+            {
+                if (b == b_end || (a != a_end && entryLess(*a, *b) &&
+                                   samePrefix(*a, *b) == false))
+                {
+                    removed.push_back(makeRoute(*a++));
+                }
+                else if (a == a_end || samePrefix(*a, *b) == false)
+                {
+                    added.push_back(makeRoute(*b++));
+                }
+                else
+                {
+                    const Entry * a_next = a;
+                    const Entry * b_next = b;
+
+                    while (a_next != a_end && samePrefix(*a_next, *a))
+                    {
+                        a_next++;
+                    }
+
+                    while (b_next != b_end && samePrefix(*b_next, *b))
+                    {
+                        b_next++;
+                    }
+
+                    diffGroup(a, a_next, b, b_next);
+                    a = a_next;
+                    b = b_next;
+                }
+            }
+        };
+
+        /* Compare the address space two route sets cover. Each address is
+         * routed by the longest prefix covering it, as a router would. The
+         * addresses only the new set routes are reported as added, those
+         * only the old set routes as removed, and those routed by both with
+         * different metrics as changed, each as the fewest prefixes. Sets
+         * that differ only in how they split the same space are equal.
+         */
+        template <class I, class J> void diffSpace(I old_first, I old_last,
+                                                   J new_first, J new_last)
+        {
+            std::vector<Breakpoint> old_space;
+            std::vector<Breakpoint> new_space;
+
+            clear();
+            sweep(old_first, old_last, old_space);
+            sweep(new_first, new_last, new_space);
+
+            Walk walk(old_space, new_space);
+
+            while (walk.next() == true)
+            {
+                if (walk.a_metric != walk.b_metric)
+                {
+                    addRange(walk.start, walk.end(), walk.a_metric,
+                             walk.b_metric);
+                }
+            }
+        };
+
+        bool empty() const
+        {
+            return added.empty() && removed.empty() && changed.empty();
+        };
+
+        void clear()
+        {
+            added.clear();
+            removed.clear();
+            changed.clear();
+        };
+
+        /* Constructor */
+        RouteDiff() : SpaceSweep(MATCH_LONGEST) {};
+    };
+}
+
+#endif /* ACRS_DIFF_H */
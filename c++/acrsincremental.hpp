@@ -0,0 +1,566 @@
+/* acrsincremental.hpp -- Summarization kept up to date route by route
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ACRS_INCREMENTAL_H
+#define ACRS_INCREMENTAL_H
+
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+
+#include <limits.h>
+#include <inttypes.h>
+
+#include "acrskey.hpp"
+
+namespace Acrs
+{
+    /* Keeps the result of Acrs::summarize() for a set of routes up to date
+     * as routes are added and withdrawn, and reports what changed.
+     *
+     * Routes are held in a binary trie keyed by network bits. Besides the
+     * metrics given for its prefix, each node keeps what summarization
+     * decides for it:
+     *
+     *   present  Metrics the prefix has after merging: those given for
+     *            it, plus those both of its halves have
+     *   kept     The metric the prefix is summarized with, if any. This
+     *            is the lowest present metric its sibling does not also
+     *            have (so it was not merged away), provided that is below
+     *            'bound'
+     *   bound    The metric of the closest kept prefix above it
+     *
+     * This is the fixed point summarizeMain works towards and the overlap
+     * rule of summarizeOverlap, so the kept prefixes are exactly what
+     * summarize() would return. A change to one prefix alters 'present'
+     * only on the path up from it, as far as it keeps changing, and 'kept'
+     * only on that path, beside it, and below it where 'bound' changes.
+     * Nothing else is visited.
+     *
+     * Routes are matched by network, prefix length and metric. Summaries
+     * are reported by network; host bits given with routes are not kept.
+     */
+    template <class R> class IncrementalSummary
+    {
+    public:
+        enum
+        {
+            NONE = 0xffffffff
+        };
+
+    private:
+        static const int NO_METRIC = INT_MAX;
+
+        struct Given
+        {
+            int metric;
+            uint32_t count;     /* Times this route was added */
+        };
+
+        struct Node
+        {
+            PrefixKey key;
+            uint32_t child[2];
+            uint32_t parent;
+            uint32_t plen;      /* NONE if the node is free */
+            int bound;
+            int kept;           /* NO_METRIC if not kept */
+            int reported;       /* 'kept' as of the last flush() */
+            bool dirty;         /* In m_dirty */
+            std::vector<Given> given;
+            std::vector<int> present;
+        };
+
+        std::vector<Node> m_nodes;
+        std::vector<uint32_t> m_free;
+        std::vector<uint32_t> m_dirty;      /* 'kept' may have changed */
+        std::vector<std::pair<uint32_t, int> > m_stack;
+        std::vector<int> m_merged;
+        std::vector<int> m_present;
+        size_t m_routes;
+
+        /* Overlap order, for reporting */
+        struct NodeLess
+        {
+            const std::vector<Node> * p_nodes;
+
+            bool operator()(uint32_t a, uint32_t b) const
+            {
+                const Node & x = (*p_nodes)[a];
+                const Node & y = (*p_nodes)[b];
+
+                return (x.key < y.key) ||
+                       (x.key == y.key && x.plen < y.plen);
+            };
+        };
+
+        uint32_t newNode(uint32_t parent, uint32_t plen, const PrefixKey & key)
+        {
+            uint32_t n;
+
+            if (m_free.empty() == false)
+            {
+                n = m_free.back();
+                m_free.pop_back();
+            }
+            else
+            {
+                m_nodes.push_back(Node());
+                n = m_nodes.size() - 1;
+            }
+
+            Node & node = m_nodes[n];
+            node.key = key;
+            node.child[0] = NONE;
+            node.child[1] = NONE;
+            node.parent = parent;
+            node.plen = plen;
+            node.bound = (parent == NONE) ? NO_METRIC : childBound(parent);
+            node.kept = NO_METRIC;
+            node.reported = NO_METRIC;
+            node.dirty = false;
+            node.given.clear();
+            node.present.clear();
+
+            return n;
+        };
+
+        /* The bound node n passes on to its children */
+        int childBound(uint32_t n) const
+        {
+            const Node & node = m_nodes[n];
+
+            return (node.kept != NO_METRIC) ? node.kept : node.bound;
+        };
+
+        /* The node for key/plen, created along with any missing nodes
+         * above it if 'create' is true, or NONE
+         */
+        uint32_t findNode(const PrefixKey & key, uint32_t plen, bool create)
+        {
+            uint32_t n = 0;
+
+            for (uint32_t pos = 0; pos < plen; pos++)
+            {
+                int side = key.bit(pos);
+                uint32_t child = m_nodes[n].child[side];
+
+                if (child == NONE)
+                {
+                    if (create == false)
+                    {
+                        return NONE;
+                    }
+
+                    child = newNode(n, pos + 1, key.masked(pos + 1));
+                    m_nodes[n].child[side] = child;
+                }
+
+                n = child;
+            }
+
+            return n;
+        };
+
+        static const std::vector<int> & noMetrics()
+        {
+            static const std::vector<int> empty;
+
+            return empty;
+        };
+
+        const std::vector<int> & presentOf(uint32_t n) const
+        {
+            return (n == NONE) ? noMetrics() : m_nodes[n].present;
+        };
+
+        uint32_t siblingOf(uint32_t n) const
+        {
+            uint32_t parent = m_nodes[n].parent;
+
+            if (parent == NONE)
+            {
+                return NONE;
+            }
+
+            const Node & node = m_nodes[parent];
+
+            return (node.child[0] == n) ? node.child[1] : node.child[0];
+        };
+
+        /* Rebuild 'present' for node n from its given metrics and its
+         * children. Returns true if it changed.
+         */
+        bool updatePresent(uint32_t n)
+        {
+            Node & node = m_nodes[n];
+            const std::vector<int> & lower = presentOf(node.child[0]);
+            const std::vector<int> & upper = presentOf(node.child[1]);
+
+            m_merged.clear();
+            std::set_intersection(lower.begin(), lower.end(),
+                                  upper.begin(), upper.end(),
+                                  std::back_inserter(m_merged));
+
+            m_present.clear();
+            std::vector<int>::const_iterator merged = m_merged.begin();
+
+            for (size_t i = 0; i < node.given.size(); i++)
+            {
+                int metric = node.given[i].metric;
+
+                while (merged != m_merged.end() && *merged < metric)
+                {
+                    m_present.push_back(*merged++);
+                }
+
+                if (merged != m_merged.end() && *merged == metric)
+                {
+                    merged++;
+                }
+
+                m_present.push_back(metric);
+            }
+
+            std::vector<int>::const_iterator merged_end = m_merged.end();
+            m_present.insert(m_present.end(), merged, merged_end);
+
+            if (m_present == node.present)
+            {
+                return false;
+            }
+
+            node.present.swap(m_present);
+
+            return true;
+        };
+
+        /* The lowest present metric of node n that its sibling lacks */
+        int unmergedMetric(uint32_t n) const
+        {
+            const std::vector<int> & own = m_nodes[n].present;
+            const std::vector<int> & other = presentOf(siblingOf(n));
+            std::vector<int>::const_iterator o = other.begin();
+
+            for (size_t i = 0; i < own.size(); i++)
+            {
+                while (o != other.end() && *o < own[i])
+                {
+                    o++;
+                }
+
+                if (o == other.end() || *o != own[i])
+                {
+                    return own[i];
+                }
+            }
+
+            return NO_METRIC;
+        };
+
+        void markDirty(uint32_t n)
+        {
+            if (m_nodes[n].dirty == false)
+            {
+                m_nodes[n].dirty = true;
+                m_dirty.push_back(n);
+            }
+        };
+
+        /* Recompute 'kept' from node 'start' down, given the bound above
+         * it. Nodes on the way to 'changed' (whose 'present' sets moved)
+         * have both children visited; elsewhere a child is only visited
+         * if its bound is different.
+         */
+        void refresh(uint32_t start, int bound, uint32_t changed)
+        {
+            const Node & target = m_nodes[changed];
+
+            m_stack.clear();
+            m_stack.push_back(std::make_pair(start, bound));
+
+            while (m_stack.empty() == false)
+            {
+                uint32_t n = m_stack.back().first;
+                int node_bound = m_stack.back().second;
+                m_stack.pop_back();
+
+                Node & node = m_nodes[n];
+                int metric = unmergedMetric(n);
+                int kept = (metric < node_bound) ? metric : NO_METRIC;
+
+                node.bound = node_bound;
+
+                if (kept != node.kept)
+                {
+                    node.kept = kept;
+                    markDirty(n);
+                }
+
+                int child_bound = childBound(n);
+                bool on_path = (node.plen < target.plen &&
+                                node.key.contains(node.plen, target.key));
+
+                for (int side = 0; side < 2; side++)
+                {
+                    uint32_t child = node.child[side];
+
+                    if (child != NONE &&
+                        (on_path == true ||
+                         m_nodes[child].bound != child_bound))
+                    {
+                        m_stack.push_back(std::make_pair(child, child_bound));
+                    }
+                }
+            }
+        };
+
+        /* Bring the trie up to date after node n's given metrics changed */
+        void update(uint32_t n)
+        {
+            uint32_t top = NONE;
+
+            for (uint32_t p = n; p != NONE && updatePresent(p) == true;
+                 p = m_nodes[p].parent)
+            {
+                top = p;
+            }
+
+            if (top == NONE)
+            {
+                return;
+            }
+
+            /* 'present' is unchanged above 'top', so so is 'kept' */
+            uint32_t parent = m_nodes[top].parent;
+
+            if (parent == NONE)
+            {
+                refresh(top, NO_METRIC, n);
+                return;
+            }
+
+            for (int side = 0; side < 2; side++)
+            {
+                uint32_t child = m_nodes[parent].child[side];
+
+                if (child != NONE)
+                {
+                    refresh(child, childBound(parent), n);
+                }
+            }
+        };
+
+        /* Free node n and any of its ancestors left holding nothing */
+        void prune(uint32_t n)
+        {
+            while (n != 0 && m_nodes[n].plen != NONE)
+            {
+                Node & node = m_nodes[n];
+
+                if (node.given.empty() == false || node.child[0] != NONE ||
+                    node.child[1] != NONE || node.reported != NO_METRIC ||
+                    node.dirty == true)
+                {
+                    return;
+                }
+
+                uint32_t parent = node.parent;
+                Node & up = m_nodes[parent];
+                up.child[(up.child[0] == n) ? 0 : 1] = NONE;
+
+                node.plen = NONE;
+                node.given.clear();
+                node.present.clear();
+                m_free.push_back(n);
+
+                n = parent;
+            }
+        };
+
+    public:
+        /* Add a route. Adding the same route again needs as many
+         * withdrawals to remove it.
+         */
+        void add(const R & rt)
+        {
+            uint32_t n = findNode(routeKey(rt), rt.getPlen(), true);
+            std::vector<Given> & given = m_nodes[n].given;
+            int metric = rt.getMetric();
+            size_t i = 0;
+
+            while (i < given.size() && given[i].metric < metric)
+            {
+                i++;
+            }
+
+            m_routes++;
+
+            if (i < given.size() && given[i].metric == metric)
+            {
+                given[i].count++;
+                return;
+            }
+
+            Given entry;
+            entry.metric = metric;
+            entry.count = 1;
+            given.insert(given.begin() + i, entry);
+
+            update(n);
+        };
+
+        /* Withdraw a route added earlier. Returns false if there was no
+         * such route.
+         */
+        bool withdraw(const R & rt)
+        {
+            uint32_t n = findNode(routeKey(rt), rt.getPlen(), false);
+
+            if (n == NONE)
+            {
+                return false;
+            }
+
+            std::vector<Given> & given = m_nodes[n].given;
+            int metric = rt.getMetric();
+            size_t i = 0;
+
+            while (i < given.size() && given[i].metric < metric)
+            {
+                i++;
+            }
+
+            if (i == given.size() || given[i].metric != metric)
+            {
+                return false;
+            }
+
+            m_routes--;
+
+            if (--given[i].count > 0)
+            {
+                return true;
+            }
+
+            given.erase(given.begin() + i);
+
+            /* Checked for pruning at the next flush() */
+            markDirty(n);
+            update(n);
+
+            return true;
+        };
+
+        /* Append the summaries that appeared to 'added' and those that
+         * went away to 'removed', each in overlap order, covering every
+         * change since the last flush(). A summary that came and went in
+         * between is not reported. A summary whose metric changed is
+         * both removed and added.
+         */
+        void flush(std::vector<R> & added, std::vector<R> & removed)
+        {
+            NodeLess less;
+            less.p_nodes = &m_nodes;
+            std::sort(m_dirty.begin(), m_dirty.end(), less);
+
+            for (size_t i = 0; i < m_dirty.size(); i++)
+            {
+                Node & node = m_nodes[m_dirty[i]];
+                node.dirty = false;
+
+                if (node.kept == node.reported)
+                {
+                    continue;
+                }
+
+                if (node.reported != NO_METRIC)
+                {
+                    removed.push_back(keyRoute<R>(node.key, node.plen,
+                                                  node.reported));
+                }
+
+                if (node.kept != NO_METRIC)
+                {
+                    added.push_back(keyRoute<R>(node.key, node.plen,
+                                                node.kept));
+                }
+
+                node.reported = node.kept;
+            }
+
+            for (size_t i = 0; i < m_dirty.size(); i++)
+            {
+                prune(m_dirty[i]);
+            }
+
+            m_dirty.clear();
+        };
+
+        /* Append the current summarized set to 'out' in overlap order, as
+         * summarize() would leave it.
+         */
+        void getSummary(std::vector<R> & out) const
+        {
+            std::vector<uint32_t> stack(1, 0);
+
+            while (stack.empty() == false)
+            {
+                const Node & node = m_nodes[stack.back()];
+                stack.pop_back();
+
+                if (node.kept != NO_METRIC)
+                {
+                    out.push_back(keyRoute<R>(node.key, node.plen,
+                                              node.kept));
+                }
+
+                /* Upper half first, so the lower half comes out first */
+                for (int side = 1; side >= 0; side--)
+                {
+                    if (node.child[side] != NONE)
+                    {
+                        stack.push_back(node.child[side]);
+                    }
+                }
+            }
+        };
+
+        /* Number of routes added and not withdrawn */
+        size_t size() const
+        {
+            return m_routes;
+        };
+
+        /* Reserve room for roughly 'routes' routes */
+        void reserve(size_t routes)
+        {
+            m_nodes.reserve(routes * 2);
+        };
+
+        /* Constructor */
+        IncrementalSummary() : m_routes(0)
+        {
+            PrefixKey root_key = { 0, 0 };
+            newNode(NONE, 0, root_key);
+        };
+    };
+}
+
+#endif /* ACRS_INCREMENTAL_H */
@@ -0,0 +1,286 @@
+/* acrskey.hpp -- Fixed-width prefix keys used by the ACRS engines
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ACRS_KEY_H
+#define ACRS_KEY_H
+
+#include <inttypes.h>
+#include <endian.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include "route4packed.hpp"
+#include "route6packed.hpp"
+
+namespace Acrs
+{
+    /* A network address widened to 128 bits and stored as two host order
+     * words, most significant word first. IPv4 addresses occupy the top 32
+     * bits of 'hi', so IPv4 and IPv6 prefixes can be walked bit by bit with
+     * the same code.
+     */
+    struct PrefixKey
+    {
+        uint64_t hi;
+        uint64_t lo;
+
+        /* Return bit 'pos', counting from the most significant bit */
+        int bit(uint32_t pos) const
+        {
+            if (pos < 64)
+            {
+                return (hi >> (63 - pos)) & 1;
+            }
+
+            return (lo >> (127 - pos)) & 1;
+        }
+
+        /* Return a copy with bit 'pos' set to 'value' */
+        PrefixKey withBit(uint32_t pos, int value) const
+        {
+            PrefixKey key = *this;
+            uint64_t & word = (pos < 64) ? key.hi : key.lo;
+            uint64_t flag = (uint64_t) 1 << (63 - (pos % 64));
+
+            if (value)
+            {
+                word |= flag;
+            }
+            else
+            {
+                word &= ~flag;
+            }
+
+            return key;
+        }
+
+        /* Return a copy with every bit past the first 'plen' bits cleared */
+        PrefixKey masked(uint32_t plen) const
+        {
+            PrefixKey key;
+
+            if (plen == 0)
+            {
+                key.hi = 0;
+                key.lo = 0;
+            }
+            else if (plen < 64)
+            {
+                key.hi = hi & ~((~(uint64_t) 0) >> plen);
+                key.lo = 0;
+            }
+            else if (plen < 128)
+            {
+                key.hi = hi;
+                key.lo = lo & ~((~(uint64_t) 0) >> (plen - 64));
+            }
+            else
+            {
+                key = *this;
+            }
+
+            return key;
+        }
+
+        /* Return a copy with every bit past the first 'plen' bits set, the
+         * last key within the prefix
+         */
+        PrefixKey last(uint32_t plen) const
+        {
+            PrefixKey key = *this;
+
+            if (plen < 64)
+            {
+                key.hi |= (plen == 0) ? ~(uint64_t) 0 :
+                                        (~(uint64_t) 0) >> plen;
+                key.lo = ~(uint64_t) 0;
+            }
+            else if (plen < 128)
+            {
+                key.lo |= (~(uint64_t) 0) >> (plen - 64);
+            }
+
+            return key;
+        }
+
+        /* Return the key one above this one, wrapping to zero after the
+         * highest key
+         */
+        PrefixKey next() const
+        {
+            PrefixKey key;
+            key.lo = lo + 1;
+            key.hi = (key.lo == 0) ? hi + 1 : hi;
+
+            return key;
+        }
+
+        /* Return the key one below this one, wrapping to the highest key
+         * after zero
+         */
+        PrefixKey prev() const
+        {
+            PrefixKey key;
+            key.lo = lo - 1;
+            key.hi = (lo == 0) ? hi - 1 : hi;
+
+            return key;
+        }
+
+        bool isMax() const
+        {
+            return (hi & lo) == ~(uint64_t) 0;
+        }
+
+        /* Number of leading bits this key shares with 'other' */
+        uint32_t commonBits(const PrefixKey & other) const
+        {
+            if (hi != other.hi)
+            {
+                return __builtin_clzll(hi ^ other.hi);
+            }
+            else if (lo != other.lo)
+            {
+                return 64 + __builtin_clzll(lo ^ other.lo);
+            }
+
+            return 128;
+        }
+
+        /* True if this key, as a prefix of length 'plen', contains 'other' */
+        bool contains(uint32_t plen, const PrefixKey & other) const
+        {
+            return other.masked(plen) == *this;
+        }
+
+        bool operator==(const PrefixKey & other) const
+        {
+            return ((hi ^ other.hi) | (lo ^ other.lo)) == 0;
+        }
+
+        bool operator!=(const PrefixKey & other) const
+        {
+            return ! operator==(other);
+        }
+
+        bool operator<(const PrefixKey & other) const
+        {
+            return (hi < other.hi) || (hi == other.hi && lo < other.lo);
+        }
+    };
+
+    /* in_addr_t is kept in network byte order by Addr4NetForm */
+    inline PrefixKey makePrefixKey(const in_addr_t addr)
+    {
+        PrefixKey key;
+        key.hi = (uint64_t) ntohl(addr) << 32;
+        key.lo = 0;
+
+        return key;
+    }
+
+    inline PrefixKey makePrefixKey(const in6_addr & addr)
+    {
+        uint64_t words[2];
+        memcpy(words, &addr, sizeof(words));
+
+        PrefixKey key;
+        key.hi = be64toh(words[0]);
+        key.lo = be64toh(words[1]);
+
+        return key;
+    }
+
+    /* Key for a route's network address (host bits already cleared) */
+    template <class R> PrefixKey routeKey(const R & rt)
+    {
+        return makePrefixKey(rt.getNetworkN().getAddr());
+    }
+
+    /* The packed routes already hold host order words */
+    inline PrefixKey routeKey(const IP::Route4Packed & rt)
+    {
+        PrefixKey key;
+        key.hi = (uint64_t) rt.getNetworkH() << 32;
+        key.lo = 0;
+
+        return key;
+    }
+
+    inline PrefixKey routeKey(const IP::Route6Packed & rt)
+    {
+        PrefixKey key;
+        key.hi = rt.getNetworkHi();
+        key.lo = rt.getNetworkLo();
+
+        return key;
+    }
+
+    /* The inverses of makePrefixKey(), in network byte order */
+    inline in_addr_t keyAddr4(const PrefixKey & key)
+    {
+        return htonl((uint32_t) (key.hi >> 32));
+    }
+
+    inline in6_addr keyAddr6(const PrefixKey & key)
+    {
+        uint64_t words[2];
+        words[0] = htobe64(key.hi);
+        words[1] = htobe64(key.lo);
+
+        in6_addr addr;
+        memcpy(&addr, words, sizeof(addr));
+
+        return addr;
+    }
+
+    /* A route for prefix 'key'/'plen', the inverse of routeKey() */
+    template <class R> R keyRoute(const PrefixKey & key, uint32_t plen,
+                                  int metric);
+
+    template <> inline IP::Route4 keyRoute<IP::Route4>(const PrefixKey & key,
+                                                       uint32_t plen,
+                                                       int metric)
+    {
+        return IP::Route4(keyAddr4(key), plen, IP::PLEN, metric);
+    }
+
+    template <> inline IP::Route6 keyRoute<IP::Route6>(const PrefixKey & key,
+                                                       uint32_t plen,
+                                                       int metric)
+    {
+        return IP::Route6(keyAddr6(key), plen, IP::PLEN, metric);
+    }
+
+    template <> inline IP::Route4Packed keyRoute<IP::Route4Packed>(
+                                            const PrefixKey & key,
+                                            uint32_t plen, int metric)
+    {
+        return IP::Route4Packed(keyAddr4(key), plen, metric);
+    }
+
+    template <> inline IP::Route6Packed keyRoute<IP::Route6Packed>(
+                                            const PrefixKey & key,
+                                            uint32_t plen, int metric)
+    {
+        return IP::Route6Packed(keyAddr6(key), plen, metric);
+    }
+}
+
+#endif /* ACRS_KEY_H */
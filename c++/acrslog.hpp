@@ -0,0 +1,156 @@
+/* acrslog.hpp -- Buffered log sink for summarization tracing
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ACRS_LOG_H
+#define ACRS_LOG_H
+
+#include <iostream>
+#include <string>
+#include <cstdio>
+
+/* Log 'msg', a chain of values joined with <<, to a LogSink. Nothing in
+ * 'msg' is evaluated unless the sink is enabled, so route strings are
+ * never built when logging is off.
+ */
+#define ACRS_LOG(sink, msg)                     \
+    do                                          \
+    {                                           \
+        if ((sink).enabled() == true)           \
+        {                                       \
+            (sink) << msg;                      \
+        }                                       \
+    }                                           \
+    while (0)
+
+namespace Acrs
+{
+    /* Collects log text in memory and writes it to a stream in large
+     * blocks, rather than flushing after every message. Call flush() at
+     * the end of each operation so the log comes out ahead of whatever
+     * the caller prints next.
+     */
+    class LogSink
+    {
+    private:
+        enum
+        {
+            FLUSH_SIZE = 64 * 1024    /* Write out once this much is held */
+        };
+
+        std::ostream & m_os;
+        std::string m_buffer;
+        bool m_enabled;
+
+    public:
+        LogSink & operator<<(const std::string & text)
+        {
+            m_buffer += text;
+
+            if (m_buffer.size() >= FLUSH_SIZE)
+            {
+                flush();
+            }
+
+            return *this;
+        };
+
+        LogSink & operator<<(const char * text)
+        {
+            m_buffer += text;
+
+            if (m_buffer.size() >= FLUSH_SIZE)
+            {
+                flush();
+            }
+
+            return *this;
+        };
+
+        LogSink & operator<<(int value)
+        {
+            return *this << std::to_string(value);
+        };
+
+        LogSink & operator<<(unsigned int value)
+        {
+            return *this << std::to_string(value);
+        };
+
+        LogSink & operator<<(unsigned long value)
+        {
+            return *this << std::to_string(value);
+        };
+
+        /* Whole numbers too large for unsigned long, such as counts of
+         * IPv6 addresses
+         */
+        LogSink & operator<<(double value)
+        {
+            char buf[64];
+            snprintf(buf, sizeof(buf), "%.0f", value);
+
+            return *this << buf;
+        };
+
+        void flush()
+        {
+            if (m_buffer.empty() == true)
+            {
+                return;
+            }
+
+            m_os.write(m_buffer.data(), m_buffer.size());
+            m_os.flush();
+            m_buffer.clear();
+        };
+
+        bool enabled() const
+        {
+            return m_enabled;
+        };
+
+        /* Anything already logged is written out when disabling */
+        void setEnabled(bool enabled)
+        {
+            if (enabled == false)
+            {
+                flush();
+            }
+
+            m_enabled = enabled;
+        };
+
+        std::ostream & stream() const
+        {
+            return m_os;
+        };
+
+        /* Constructor */
+        LogSink(std::ostream & os, bool enabled)
+                :
+                m_os(os), m_enabled(enabled) {};
+
+        /* Destructor */
+        ~LogSink()
+        {
+            flush();
+        };
+    };
+}
+
+#endif /* ACRS_LOG_H */
@@ -0,0 +1,287 @@
+/* acrsmem.hpp -- Allocation counts and resident memory sampling
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ACRS_MEM_H
+#define ACRS_MEM_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#include <stddef.h>
+
+namespace Acrs
+{
+    /* Counts kept by the operator new and delete hooks in memhooks.cpp.
+     * Nothing is counted unless that file is linked in and counting is
+     * enabled, so a program that does not profile pays nothing.
+     */
+    struct AllocCounters
+    {
+        enum
+        {
+            SIZE_CLASSES = 16   /* Up to 8, 16, ... 128K, and larger */
+        };
+
+        bool hooked;            /* memhooks.cpp is linked in */
+        std::atomic<bool> enabled;
+        std::atomic<size_t> allocations;
+        std::atomic<size_t> frees;
+        std::atomic<size_t> bytes;
+        std::atomic<size_t> by_size[SIZE_CLASSES];
+
+        /* Size class of an allocation: the smallest 8 << n it fits */
+        static int sizeClass(size_t size)
+        {
+            int n = 0;
+
+            while (n < SIZE_CLASSES - 1 && size > ((size_t) 8 << n))
+            {
+                n++;
+            }
+
+            return n;
+        };
+
+        void count(size_t size)
+        {
+            allocations.fetch_add(1, std::memory_order_relaxed);
+            bytes.fetch_add(size, std::memory_order_relaxed);
+            by_size[sizeClass(size)].fetch_add(1, std::memory_order_relaxed);
+        };
+    };
+
+    /* The one set of counters. A function static, so the hooks can use
+     * it from the first allocation, before any other static is built.
+     */
+    inline AllocCounters & allocCounters()
+    {
+        static AllocCounters counters;
+
+        return counters;
+    }
+
+    /* Memory use at one moment */
+    struct MemUsage
+    {
+        size_t allocations;     /* Allocations counted so far */
+        size_t frees;
+        size_t bytes;           /* Bytes they asked for */
+        size_t by_size[AllocCounters::SIZE_CLASSES];
+        size_t rss;             /* Resident set size in bytes */
+        size_t peak_rss;        /* Its high water mark */
+
+        /* Take the counters and read VmRSS and VmHWM from
+         * /proc/self/status, leaving the sizes 0 where that can't be read
+         */
+        static MemUsage now()
+        {
+            AllocCounters & counters = allocCounters();
+            MemUsage usage;
+
+            usage.allocations = counters.allocations;
+            usage.frees = counters.frees;
+            usage.bytes = counters.bytes;
+
+            for (int i = 0; i < AllocCounters::SIZE_CLASSES; i++)
+            {
+                usage.by_size[i] = counters.by_size[i];
+            }
+
+            usage.rss = 0;
+            usage.peak_rss = 0;
+
+            FILE * p_status = fopen("/proc/self/status", "r");
+            char line[256];
+
+            while (p_status != NULL &&
+                   fgets(line, sizeof(line), p_status) != NULL)
+            {
+                unsigned long kb;
+
+                if (sscanf(line, "VmRSS: %lu kB", &kb) == 1)
+                {
+                    usage.rss = kb * 1024;
+                }
+                else if (sscanf(line, "VmHWM: %lu kB", &kb) == 1)
+                {
+                    usage.peak_rss = kb * 1024;
+                }
+            }
+
+            if (p_status != NULL)
+            {
+                fclose(p_status);
+            }
+
+            return usage;
+        };
+    };
+
+    /* Splits a run into named phases, such as parsing, summarizing and
+     * output, and records the allocations made in each and the resident
+     * size at its end. Counting is enabled from the first start() until
+     * the profile is destroyed.
+     *
+     *     MemProfile profile;
+     *     profile.start("parse");
+     *     ...
+     *     profile.start("summarize");
+     *     ...
+     *     profile.stop();
+     *     profile.writeJson(std::cerr, routes.size(), "parse");
+     */
+    class MemProfile
+    {
+    private:
+        struct Phase
+        {
+            std::string name;
+            MemUsage start;
+            MemUsage end;
+        };
+
+        std::vector<Phase> m_phases;
+        bool m_running;
+
+        static void writeUsage(std::ostream & os, const MemUsage & start,
+                               const MemUsage & end)
+        {
+            os << "{\"allocations\": " << end.allocations - start.allocations
+               << ", \"frees\": " << end.frees - start.frees
+               << ", \"bytes\": " << end.bytes - start.bytes
+               << ", \"rss\": " << end.rss
+               << ", \"rss_growth\": " << (long long) (end.rss - start.rss)
+               << ", \"by_size\": {";
+
+            const char * p_sep = "";
+
+            for (int i = 0; i < AllocCounters::SIZE_CLASSES; i++)
+            {
+                size_t count = end.by_size[i] - start.by_size[i];
+
+                if (count == 0)
+                {
+                    continue;
+                }
+
+                os << p_sep << "\"";
+
+                if (i == AllocCounters::SIZE_CLASSES - 1)
+                {
+                    os << ">" << ((size_t) 8 << (i - 1));
+                }
+                else
+                {
+                    os << ((size_t) 8 << i);
+                }
+
+                os << "\": " << count;
+                p_sep = ", ";
+            }
+
+            os << "}}";
+        };
+
+    public:
+        /* End the running phase, if any, and start another */
+        void start(const char * p_name)
+        {
+            stop();
+            allocCounters().enabled = true;
+
+            Phase phase;
+            phase.name = p_name;
+            phase.start = MemUsage::now();
+
+            m_phases.push_back(phase);
+            m_running = true;
+        };
+
+        void stop()
+        {
+            if (m_running == true)
+            {
+                m_phases.back().end = MemUsage::now();
+                m_running = false;
+            }
+        };
+
+        /* Write every phase, the peak resident size and, over 'routes',
+         * the bytes counted and resident size gained in the phase named
+         * 'p_input', which read them in, as one JSON object
+         */
+        void writeJson(std::ostream & os, size_t routes,
+                       const char * p_input)
+        {
+            stop();
+
+            MemUsage last = MemUsage::now();
+            size_t divisor = (routes == 0) ? 1 : routes;
+
+            os << "{\n"
+               << "  \"hooked\": "
+               << (allocCounters().hooked ? "true" : "false") << ",\n"
+               << "  \"routes\": " << routes << ",\n"
+               << "  \"peak_rss\": " << last.peak_rss << ",\n"
+               << "  \"phases\": {";
+
+            for (size_t i = 0; i < m_phases.size(); i++)
+            {
+                os << (i == 0 ? "\n" : ",\n") << "    \""
+                   << m_phases[i].name << "\": ";
+                writeUsage(os, m_phases[i].start, m_phases[i].end);
+            }
+
+            os << "\n  }";
+
+            for (size_t i = 0; i < m_phases.size(); i++)
+            {
+                const Phase & input = m_phases[i];
+
+                if (input.name != p_input)
+                {
+                    continue;
+                }
+
+                os << ",\n  \"bytes_per_route\": "
+                   << (input.end.bytes - input.start.bytes) / divisor
+                   << ",\n  \"rss_per_route\": "
+                   << (long long) (input.end.rss - input.start.rss) /
+                      (long long) divisor;
+                break;
+            }
+
+            os << "\n}\n";
+        };
+
+        /* Constructor */
+        MemProfile() : m_running(false) {};
+
+        /* Destructor */
+        ~MemProfile()
+        {
+            allocCounters().enabled = false;
+        };
+    };
+}
+
+#endif /* ACRS_MEM_H */
@@ -0,0 +1,360 @@
+/* acrsortc.hpp -- Minimal forwarding tables by ORTC
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ACRS_ORTC_H
+#define ACRS_ORTC_H
+
+#include <vector>
+#include <iterator>
+#include <algorithm>
+
+#include <inttypes.h>
+
+#include "acrskey.hpp"
+
+namespace Acrs
+{
+    /* Builds the smallest route table that forwards every address as a
+     * given one does, by longest prefix match, using the Optimal Routing
+     * Table Constructor (Draves, King, Venkatachary and Zill, 1999). The
+     * metric is taken as the route's forwarding attribute, such as a
+     * next-hop ID: any two routes with different metrics are treated as
+     * going different ways. Unlike sibling merging, the result may use a
+     * covering prefix with more specific exceptions.
+     *
+     * Three passes are made over a binary trie of the routes:
+     *
+     *   1) Every node gets the metric it inherits by longest match. A node
+     *      with one child is taken to have a leaf with that metric as the
+     *      other, so every node is a leaf or has two children.
+     *   2) Bottom up, a leaf's set is its metric. A parent's set is the
+     *      intersection of its children's, or if that is empty, their
+     *      union: the metrics a prefix here could take at least cost.
+     *   3) Top down, a node keeps the metric it inherits if that is in its
+     *      set, and otherwise takes one from the set (the lowest) as a
+     *      route.
+     *
+     * A table has no way to say "no route", so addresses no route covers
+     * must not end up under a route. A set holding NO_ROUTE is kept as
+     * just NO_ROUTE, and since it reaches the root, no prefix covering
+     * such addresses is chosen.
+     *
+     * Where a prefix is given more than once, the lowest metric is taken,
+     * as by RouteLookup4 and RouteLookup6.
+     */
+    class OrtcTrie
+    {
+    public:
+        enum
+        {
+            NONE = 0xffffffff
+        };
+
+        static const int NO_ROUTE = -1;
+
+    private:
+        /* A node's set is a single metric, or a run of metrics in m_sets.
+         * A missing child is a leaf taking its parent's metric, which is
+         * never stored.
+         */
+        struct Node
+        {
+            uint32_t child[2];
+            int metric;             /* Given here, else NO_ROUTE; after
+                                     * pass 1, inherited by longest match */
+            uint32_t set;           /* The metric, or the first in m_sets */
+            uint16_t set_size;
+            uint8_t plen;
+            bool given;
+        };
+
+        enum
+        {
+            MISSING = 0x80000000,   /* Visit the missing half of a node */
+            MAX_BITS = 128
+        };
+
+        /* A node to visit in pass 3, with the metric it inherits */
+        struct Visit
+        {
+            uint32_t node;
+            PrefixKey key;
+            int metric;
+        };
+
+        std::vector<Node> m_nodes;
+        std::vector<int> m_sets;
+
+        uint32_t m_path[MAX_BITS + 1];   /* Nodes down to m_last */
+        PrefixKey m_last;
+        uint32_t m_depth;
+
+        uint32_t newNode(uint32_t plen)
+        {
+            Node node;
+            node.child[0] = NONE;
+            node.child[1] = NONE;
+            node.metric = NO_ROUTE;
+            node.set = 0;
+            node.set_size = 0;
+            node.plen = plen;
+            node.given = false;
+
+            m_nodes.push_back(node);
+
+            return m_nodes.size() - 1;
+        };
+
+        const int * setOf(const Node & node) const
+        {
+            return (node.set_size == 1) ? (const int *) &node.set :
+                                          &m_sets[node.set];
+        };
+
+        /* Pass 1. Children are always created after their parent, so
+         * walking the pool forwards visits every parent first.
+         */
+        void inherit()
+        {
+            for (uint32_t n = 0; n < m_nodes.size(); n++)
+            {
+                for (int side = 0; side < 2; side++)
+                {
+                    uint32_t child = m_nodes[n].child[side];
+
+                    if (child != NONE && m_nodes[child].given == false)
+                    {
+                        m_nodes[child].metric = m_nodes[n].metric;
+                    }
+                }
+            }
+        };
+
+        /* Pass 2, walking the pool backwards so children come first */
+        void makeSets()
+        {
+            std::vector<int> merged;
+
+            m_sets.clear();
+
+            for (uint32_t n = m_nodes.size(); n-- > 0; )
+            {
+                Node & node = m_nodes[n];
+                const int * sides[2];
+                uint32_t sizes[2];
+
+                if (node.child[0] == NONE && node.child[1] == NONE)
+                {
+                    node.set = node.metric;
+                    node.set_size = 1;
+                    continue;
+                }
+
+                for (int side = 0; side < 2; side++)
+                {
+                    if (node.child[side] == NONE)
+                    {
+                        sides[side] = &node.metric;
+                        sizes[side] = 1;
+                    }
+                    else
+                    {
+                        sides[side] = setOf(m_nodes[node.child[side]]);
+                        sizes[side] = m_nodes[node.child[side]].set_size;
+                    }
+                }
+
+                /* Most sets hold one metric */
+                if (sizes[0] == 1 && sizes[1] == 1)
+                {
+                    int low = std::min(sides[0][0], sides[1][0]);
+                    int high = std::max(sides[0][0], sides[1][0]);
+
+                    if (low == high || low == NO_ROUTE)
+                    {
+                        node.set = low;
+                        node.set_size = 1;
+                    }
+                    else
+                    {
+                        node.set = m_sets.size();
+                        node.set_size = 2;
+                        m_sets.push_back(low);
+                        m_sets.push_back(high);
+                    }
+
+                    continue;
+                }
+
+                merged.clear();
+                std::set_intersection(sides[0], sides[0] + sizes[0],
+                                      sides[1], sides[1] + sizes[1],
+                                      std::back_inserter(merged));
+
+                if (merged.empty() == true)
+                {
+                    std::set_union(sides[0], sides[0] + sizes[0],
+                                   sides[1], sides[1] + sizes[1],
+                                   std::back_inserter(merged));
+                }
+
+                /* NO_ROUTE sorts first */
+                if (merged.size() == 1 || merged[0] == NO_ROUTE)
+                {
+                    node.set = merged[0];
+                    node.set_size = 1;
+                }
+                else
+                {
+                    node.set = m_sets.size();
+                    node.set_size = merged.size();
+                    m_sets.insert(m_sets.end(), merged.begin(), merged.end());
+                }
+            }
+        };
+
+    public:
+        void reserve(size_t routes)
+        {
+            m_nodes.reserve(routes * 2);
+        };
+
+        /* Add a route. The path to the last route added is kept, so
+         * routes in order share the walk down to where they part.
+         */
+        void insert(const PrefixKey & key, uint32_t plen, int metric)
+        {
+            uint32_t pos = std::min(std::min(m_depth, plen),
+                                    key.commonBits(m_last));
+            uint32_t n = m_path[pos];
+
+            for ( ; pos < plen; pos++)
+            {
+                int side = key.bit(pos);
+
+                if (m_nodes[n].child[side] == NONE)
+                {
+                    uint32_t child = newNode(pos + 1);
+                    m_nodes[n].child[side] = child;
+                }
+
+                n = m_nodes[n].child[side];
+                m_path[pos + 1] = n;
+            }
+
+            m_last = key;
+            m_depth = plen;
+
+            if (m_nodes[n].given == false || metric < m_nodes[n].metric)
+            {
+                m_nodes[n].metric = metric;
+                m_nodes[n].given = true;
+            }
+        };
+
+        /* Run the passes and report the routes of the result to the
+         * listener's onRoute(key, plen, metric), in overlapCmp order
+         */
+        template <class L> void compress(L & listener)
+        {
+            inherit();
+            makeSets();
+
+            /* Pass 3 */
+            std::vector<Visit> stack;
+            Visit root = { 0, { 0, 0 }, NO_ROUTE };
+
+            stack.push_back(root);
+
+            while (stack.empty() == false)
+            {
+                Visit visit = stack.back();
+                stack.pop_back();
+
+                if ((visit.node & MISSING) != 0)
+                {
+                    const Node & parent = m_nodes[visit.node & ~MISSING];
+
+                    if (parent.metric != visit.metric)
+                    {
+                        listener.onRoute(visit.key, parent.plen + 1,
+                                         parent.metric);
+                    }
+
+                    continue;
+                }
+
+                const Node & node = m_nodes[visit.node];
+                const int * set = setOf(node);
+
+                if (std::binary_search(set, set + node.set_size,
+                                       visit.metric) == false)
+                {
+                    visit.metric = set[0];
+                    listener.onRoute(visit.key, node.plen, visit.metric);
+                }
+
+                /* Push the upper half first so the lower half is visited
+                 * first. A missing half is a leaf with this node's metric.
+                 */
+                for (int side = 1; side >= 0; side--)
+                {
+                    Visit child = { node.child[side],
+                                    side ? visit.key.withBit(node.plen, 1) :
+                                           visit.key,
+                                    visit.metric };
+
+                    if (child.node == NONE)
+                    {
+                        if (node.child[side ^ 1] == NONE)
+                        {
+                            continue;
+                        }
+
+                        child.node = visit.node | MISSING;
+                    }
+
+                    stack.push_back(child);
+                }
+            }
+        };
+
+        void clear()
+        {
+            m_nodes.clear();
+            m_sets.clear();
+            newNode(0);
+            m_path[0] = 0;
+            m_last.hi = 0;
+            m_last.lo = 0;
+            m_depth = 0;
+        };
+
+        /* Constructor */
+        OrtcTrie()
+        {
+            newNode(0);
+            m_path[0] = 0;
+            m_last.hi = 0;
+            m_last.lo = 0;
+            m_depth = 0;
+        };
+    };
+}
+
+#endif /* ACRS_ORTC_H */
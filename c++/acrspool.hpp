@@ -0,0 +1,160 @@
+/* acrspool.hpp -- Work-stealing thread pool for parallel summarization
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ACRS_POOL_H
+#define ACRS_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <exception>
+#include <functional>
+
+namespace Acrs
+{
+    /* Runs a fixed set of tasks, numbered 0 to count - 1, on a group of
+     * threads and waits for all of them. The tasks are dealt out to one
+     * queue per thread in the order given, so callers should list the
+     * largest first. A thread takes work from the front of its own queue,
+     * and once that is empty steals from the back of the others, so a
+     * single large task does not leave the remaining threads idle.
+     *
+     * The calling thread is one of the workers. If a task throws, the
+     * first exception is rethrown here once every thread has stopped.
+     */
+    class WorkPool
+    {
+    private:
+        struct Queue
+        {
+            std::mutex lock;
+            std::deque<size_t> tasks;
+        };
+
+        std::vector<Queue> m_queues;
+        std::mutex m_error_lock;
+        std::exception_ptr m_error;
+
+        bool takeOwn(unsigned int self, size_t & task)
+        {
+            std::lock_guard<std::mutex> guard(m_queues[self].lock);
+
+            if (m_queues[self].tasks.empty() == true)
+            {
+                return false;
+            }
+
+            task = m_queues[self].tasks.front();
+            m_queues[self].tasks.pop_front();
+
+            return true;
+        };
+
+        bool steal(unsigned int self, size_t & task)
+        {
+            for (unsigned int i = 1; i < m_queues.size(); i++)
+            {
+                Queue & victim = m_queues[(self + i) % m_queues.size()];
+                std::lock_guard<std::mutex> guard(victim.lock);
+
+                if (victim.tasks.empty() == false)
+                {
+                    task = victim.tasks.back();
+                    victim.tasks.pop_back();
+
+                    return true;
+                }
+            }
+
+            return false;
+        };
+
+        template <class F> void work(unsigned int self, F & func)
+        {
+            size_t task;
+
+            /* No tasks are added once the threads start, so when every
+             * queue is empty this thread is done.
+             */
+            while (takeOwn(self, task) == true || steal(self, task) == true)
+            {
+                try
+                {
+                    func(task);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> guard(m_error_lock);
+
+                    if (! m_error)
+                    {
+                        m_error = std::current_exception();
+                    }
+                }
+            }
+        };
+
+    public:
+        /* Call func(task) for each task */
+        template <class F> void run(size_t count, unsigned int threads,
+                                    F & func)
+        {
+            if (threads == 0)
+            {
+                threads = 1;
+            }
+
+            if (threads > count)
+            {
+                threads = (count == 0) ? 1 : count;
+            }
+
+            std::vector<Queue> queues(threads);
+            m_queues.swap(queues);
+            m_error = std::exception_ptr();
+
+            for (size_t task = 0; task < count; task++)
+            {
+                m_queues[task % threads].tasks.push_back(task);
+            }
+
+            std::vector<std::thread> workers;
+
+            for (unsigned int i = 1; i < threads; i++)
+            {
+                workers.push_back(std::thread(&WorkPool::work<F>, this, i,
+                                              std::ref(func)));
+            }
+
+            work(0, func);
+
+            for (size_t i = 0; i < workers.size(); i++)
+            {
+                workers[i].join();
+            }
+
+            if (m_error)
+            {
+                std::rethrow_exception(m_error);
+            }
+        };
+    };
+}
+
+#endif /* ACRS_POOL_H */
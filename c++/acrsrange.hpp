@@ -0,0 +1,223 @@
+/* acrsrange.hpp -- Route storage adaptors for the ACRS summarizer
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ACRS_RANGE_H
+#define ACRS_RANGE_H
+
+#include <vector>
+#include <iterator>
+#include <algorithm>
+
+#include <inttypes.h>
+
+#include "acrssort.hpp"
+
+namespace Acrs
+{
+    /* The summarizer sees routes as an iterator range, plus the few
+     * operations that depend on how the routes are stored:
+     *
+     *   sort(order)    Reorder the routes
+     *   drop(iter)     Mark a route for removal. Iterators stay valid
+     *                  until compact() is called.
+     *   compact()      Remove the marked routes, keeping the order of
+     *                  the rest
+     *   select(keep)   Keep only the routes at the given positions
+     *                  (counted from begin()), in the given order
+     *   assign(f, l)   Replace the routes with copies of another range
+     *                  that is no longer
+     */
+
+    /* A std::list, or another container with splice() and erase().
+     * Routes are never copied; nodes are relinked or erased.
+     */
+    template <class T> class ListRange
+    {
+    public:
+        typedef typename T::iterator iterator;
+        typedef typename T::value_type value_type;
+
+    private:
+        T & m_list;
+        std::vector<iterator> m_dropped;
+
+    public:
+        iterator begin()
+        {
+            return m_list.begin();
+        };
+
+        iterator end()
+        {
+            return m_list.end();
+        };
+
+        size_t size() const
+        {
+            return m_list.size();
+        };
+
+        void sort(SortOrder order)
+        {
+            radixSort(m_list, order);
+        };
+
+        void drop(iterator iter)
+        {
+            m_dropped.push_back(iter);
+        };
+
+        void compact()
+        {
+            for (size_t i = 0; i < m_dropped.size(); i++)
+            {
+                m_list.erase(m_dropped[i]);
+            }
+
+            m_dropped.clear();
+        };
+
+        void select(const std::vector<uint32_t> & keep)
+        {
+            std::vector<iterator> routes;
+            T result(m_list.get_allocator());
+
+            for (iterator iter = m_list.begin(); iter != m_list.end(); iter++)
+            {
+                routes.push_back(iter);
+            }
+
+            for (size_t i = 0; i < keep.size(); i++)
+            {
+                result.splice(result.end(), m_list, routes[keep[i]]);
+            }
+
+            m_list.swap(result);
+        };
+
+        /* Replace the routes with copies of [first, last) */
+        template <class I> void assign(I first, I last)
+        {
+            m_list.assign(first, last);
+        };
+
+        ListRange(T & list) : m_list(list) {};
+    };
+
+    /* A contiguous range of routes: a std::vector, an array, or part of
+     * either. Removal never frees or allocates routes. Survivors are
+     * copied down over the removed ones in one pass, and end() moves
+     * back. The caller decides what to do with the routes left past the
+     * new end.
+     */
+    template <class I> class ArrayRange
+    {
+    public:
+        typedef I iterator;
+        typedef typename std::iterator_traits<I>::value_type value_type;
+
+    private:
+        I m_first;
+        I m_last;
+        std::vector<bool> m_dropped;
+
+    public:
+        iterator begin()
+        {
+            return m_first;
+        };
+
+        iterator end()
+        {
+            return m_last;
+        };
+
+        size_t size() const
+        {
+            return m_last - m_first;
+        };
+
+        void sort(SortOrder order)
+        {
+            radixSortRange(m_first, m_last, order);
+        };
+
+        void drop(iterator iter)
+        {
+            if (m_dropped.empty() == true)
+            {
+                m_dropped.assign(size(), false);
+            }
+
+            m_dropped[iter - m_first] = true;
+        };
+
+        void compact()
+        {
+            if (m_dropped.empty() == true)
+            {
+                return;
+            }
+
+            I out = m_first;
+
+            for (size_t i = 0; i < m_dropped.size(); i++)
+            {
+                if (m_dropped[i] == true)
+                {
+                    continue;
+                }
+
+                if (out != m_first + i)
+                {
+                    *out = m_first[i];
+                }
+
+                out++;
+            }
+
+            m_last = out;
+            m_dropped.clear();
+        };
+
+        void select(const std::vector<uint32_t> & keep)
+        {
+            std::vector<value_type> kept;
+            kept.reserve(keep.size());
+
+            for (size_t i = 0; i < keep.size(); i++)
+            {
+                kept.push_back(m_first[keep[i]]);
+            }
+
+            m_last = std::copy(kept.begin(), kept.end(), m_first);
+        };
+
+        /* Replace the routes with copies of [first, last), which must not
+         * hold more routes than the range does.
+         */
+        template <class J> void assign(J first, J last)
+        {
+            m_last = std::copy(first, last, m_first);
+        };
+
+        ArrayRange(I first, I last) : m_first(first), m_last(last) {};
+    };
+}
+
+#endif /* ACRS_RANGE_H */
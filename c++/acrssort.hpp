@@ -0,0 +1,260 @@
+/* acrssort.hpp -- Packed-key LSD radix sort for route containers
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ACRS_SORT_H
+#define ACRS_SORT_H
+
+#include <vector>
+#include <iterator>
+
+#include <inttypes.h>
+
+#include "acrskey.hpp"
+
+namespace Acrs
+{
+    enum SortOrder
+    {
+        ORDER_ACRS,     /* Metric, then prefix length descending, then
+                         * network (the order of acrsCmp) */
+        ORDER_OVERLAP   /* Network, then prefix length, then metric
+                         * (the order of overlapCmp) */
+    };
+
+    /* A route's sort fields packed into one 192 bit unsigned number,
+     * most significant word first. Comparing two keys as numbers gives
+     * the same answer as the comparator for the chosen order.
+     */
+    struct SortKey
+    {
+        enum
+        {
+            WORDS = 3,
+            BYTES = WORDS * 8
+        };
+
+        uint64_t word[WORDS];
+
+        /* Byte 'pos' of the key, counting from the least significant */
+        unsigned int byte(unsigned int pos) const
+        {
+            return (word[WORDS - 1 - pos / 8] >> ((pos % 8) * 8)) & 0xff;
+        };
+    };
+
+    /* Build the key for a route. The network is widened to 128 bits for
+     * both address families. For IPv4 the low network bytes are always
+     * zero, so the sort skips them.
+     */
+    template <class R> SortKey makeSortKey(const R & rt, SortOrder order)
+    {
+        SortKey key;
+        PrefixKey net = routeKey(rt);
+        uint64_t plen = rt.getPlen();
+        uint64_t metric = (uint32_t) rt.getMetric();
+
+        if (order == ORDER_ACRS)
+        {
+            key.word[0] = (metric << 8) | (255 - plen);
+            key.word[1] = net.hi;
+            key.word[2] = net.lo;
+        }
+        else
+        {
+            key.word[0] = net.hi;
+            key.word[1] = net.lo;
+            key.word[2] = (plen << 32) | metric;
+        }
+
+        return key;
+    }
+
+    /* Stable LSD radix sort of (key, index) pairs, one byte per pass.
+     * Histograms for every byte are gathered in a single read of the
+     * input, and a byte is skipped when every key has the same value
+     * there. IPv4 tables with few metrics need six or seven passes.
+     */
+    class RadixSorter
+    {
+    public:
+        struct Item
+        {
+            SortKey key;
+            uint32_t index;
+        };
+
+    private:
+        std::vector<Item> m_items;
+        std::vector<Item> m_buffer;
+
+    public:
+        void clear()
+        {
+            m_items.clear();
+        };
+
+        void reserve(size_t count)
+        {
+            m_items.reserve(count);
+        };
+
+        void add(const SortKey & key, uint32_t index)
+        {
+            Item item;
+            item.key = key;
+            item.index = index;
+
+            m_items.push_back(item);
+        };
+
+        /* Sort the added items. Items with equal keys keep the order they
+         * were added in.
+         */
+        const std::vector<Item> & sort()
+        {
+            size_t count = m_items.size();
+
+            if (count < 2)
+            {
+                return m_items;
+            }
+
+            std::vector<uint32_t> hist(SortKey::BYTES * 256, 0);
+
+            for (size_t i = 0; i < count; i++)
+            {
+                const SortKey & key = m_items[i].key;
+
+                for (unsigned int pos = 0; pos < SortKey::BYTES; pos++)
+                {
+                    hist[pos * 256 + key.byte(pos)]++;
+                }
+            }
+
+            m_buffer.resize(count);
+
+            for (unsigned int pos = 0; pos < SortKey::BYTES; pos++)
+            {
+                uint32_t * counts = &hist[pos * 256];
+
+                /* Every key has the same byte here, nothing to do */
+                if (counts[m_items[0].key.byte(pos)] == count)
+                {
+                    continue;
+                }
+
+                /* Turn the counts into starting offsets */
+                uint32_t offset = 0;
+
+                for (unsigned int value = 0; value < 256; value++)
+                {
+                    uint32_t n = counts[value];
+                    counts[value] = offset;
+                    offset += n;
+                }
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    unsigned int value = m_items[i].key.byte(pos);
+                    m_buffer[counts[value]++] = m_items[i];
+                }
+
+                m_items.swap(m_buffer);
+            }
+
+            return m_items;
+        };
+    };
+
+    /* Reorder a random access range (a std::vector, an array) by the
+     * given order. Keys are computed once, then the permutation is applied
+     * in place by following its cycles, so each route is copied once and
+     * only one route per cycle is held aside.
+     */
+    template <class I> void radixSortRange(I first, I last, SortOrder order)
+    {
+        typedef typename std::iterator_traits<I>::value_type Route;
+
+        RadixSorter sorter;
+        size_t count = last - first;
+
+        sorter.reserve(count);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            sorter.add(makeSortKey(first[i], order), i);
+        }
+
+        /* Position i takes the route now at sorted[i].index */
+        const std::vector<RadixSorter::Item> & sorted = sorter.sort();
+        std::vector<bool> placed(count, false);
+
+        for (size_t start = 0; start < count; start++)
+        {
+            if (placed[start] == true || sorted[start].index == start)
+            {
+                continue;
+            }
+
+            Route held = first[start];
+            size_t pos = start;
+
+            while (true)
+            {
+                size_t src = sorted[pos].index;
+                placed[pos] = true;
+
+                if (src == start)
+                {
+                    first[pos] = held;
+                    break;
+                }
+
+                first[pos] = first[src];
+                pos = src;
+            }
+        }
+    }
+
+    /* Reorder a list (anything with splice()) by the given order. Each
+     * route's key is computed once, and the nodes are relinked without
+     * copying any routes.
+     */
+    template <class T> void radixSort(T & rt_list, SortOrder order)
+    {
+        std::vector<typename T::iterator> routes;
+        RadixSorter sorter;
+
+        for (typename T::iterator iter = rt_list.begin();
+             iter != rt_list.end();
+             iter++)
+        {
+            sorter.add(makeSortKey(*iter, order), routes.size());
+            routes.push_back(iter);
+        }
+
+        const std::vector<RadixSorter::Item> & sorted = sorter.sort();
+
+        for (size_t i = 0; i < sorted.size(); i++)
+        {
+            rt_list.splice(rt_list.end(), rt_list, routes[sorted[i].index]);
+        }
+    }
+}
+
+#endif /* ACRS_SORT_H */
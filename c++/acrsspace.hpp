@@ -0,0 +1,327 @@
+/* acrsspace.hpp -- The metric a route set gives each address
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ACRS_SPACE_H
+#define ACRS_SPACE_H
+
+#include <vector>
+#include <algorithm>
+
+#include <limits.h>
+#include <inttypes.h>
+
+#include "acrskey.hpp"
+
+namespace Acrs
+{
+    /* Turns a set of routes into the metric each address is routed with,
+     * as the ranges over which that metric is constant, and walks two
+     * such sets side by side. Neither set is expanded into addresses.
+     * This is the common ground of Verifier and RouteDiff.
+     *
+     * Routes are swept in overlapCmp order, sorting them first unless
+     * they already are, as summarize() leaves them. Prefixes either nest
+     * or don't overlap at all, so in that order the routes covering the
+     * sweep position form a stack, and a route ends before the next one
+     * starts or after the one inside it ends.
+     */
+    class SpaceSweep
+    {
+    public:
+        static const int NO_METRIC = INT_MAX;   /* Address not routed */
+
+        /* Which route's metric an address takes */
+        enum Match
+        {
+            MATCH_BEST,     /* The lowest of all covering it (default) */
+            MATCH_LONGEST   /* The longest prefix's, the lowest if given
+                             * more than once */
+        };
+
+        /* Choose which metric an address takes */
+        void setMatch(Match match)
+        {
+            m_match = match;
+        };
+
+        Match getMatch() const
+        {
+            return m_match;
+        };
+
+    protected:
+        struct Entry
+        {
+            PrefixKey key;
+            uint32_t plen;
+            int metric;
+        };
+
+        /* From 'start' up to the next breakpoint, every address is routed
+         * with 'metric', or not at all if it is NO_METRIC
+         */
+        struct Breakpoint
+        {
+            PrefixKey start;
+            int metric;
+        };
+
+        /* Steps through two swept sets together, one range at a time.
+         * After next(), every address from 'start' to end() has
+         * 'a_metric' in the first set and 'b_metric' in the second.
+         */
+        class Walk
+        {
+        private:
+            const std::vector<Breakpoint> & m_a;
+            const std::vector<Breakpoint> & m_b;
+            size_t m_i;
+            size_t m_j;
+
+        public:
+            PrefixKey start;
+            int a_metric;
+            int b_metric;
+
+            /* Move to the next range. Return false if there are no more. */
+            bool next()
+            {
+                if (m_i == m_a.size() && m_j == m_b.size())
+                {
+                    return false;
+                }
+
+                /* Both start at zero, so every step passes a breakpoint */
+                if (m_j == m_b.size() ||
+                    (m_i < m_a.size() &&
+                     (m_b[m_j].start < m_a[m_i].start) == false))
+                {
+                    start = m_a[m_i].start;
+                }
+                else
+                {
+                    start = m_b[m_j].start;
+                }
+
+                if (m_i < m_a.size() && m_a[m_i].start == start)
+                {
+                    a_metric = m_a[m_i++].metric;
+                }
+
+                if (m_j < m_b.size() && m_b[m_j].start == start)
+                {
+                    b_metric = m_b[m_j++].metric;
+                }
+
+                return true;
+            };
+
+            /* The last address of the range, just before the next
+             * breakpoint of either set
+             */
+            PrefixKey end() const
+            {
+                PrefixKey last = { ~(uint64_t) 0, ~(uint64_t) 0 };
+
+                if (m_i < m_a.size())
+                {
+                    last = m_a[m_i].start.prev();
+                }
+
+                if (m_j < m_b.size() && m_b[m_j].start.prev() < last)
+                {
+                    last = m_b[m_j].start.prev();
+                }
+
+                return last;
+            };
+
+            /* Constructor */
+            Walk(const std::vector<Breakpoint> & a,
+                 const std::vector<Breakpoint> & b)
+                 :
+                 m_a(a), m_b(b), m_i(0), m_j(0), a_metric(NO_METRIC),
+                 b_metric(NO_METRIC)
+            {
+                start.hi = 0;
+                start.lo = 0;
+            };
+        };
+
+        static bool entryLess(const Entry & a, const Entry & b)
+        {
+            if (a.key != b.key)
+            {
+                return a.key < b.key;
+            }
+            else if (a.plen != b.plen)
+            {
+                return a.plen < b.plen;
+            }
+
+            return a.metric < b.metric;
+        };
+
+        static bool samePrefix(const Entry & a, const Entry & b)
+        {
+            return a.key == b.key && a.plen == b.plen;
+        };
+
+        /* Append the routes in [first, last) to 'out' in overlapCmp order */
+        template <class I> static void getEntries(I first, I last,
+                                                  std::vector<Entry> & out)
+        {
+            bool sorted = true;
+
+            for (I iter = first; iter != last; iter++)
+            {
+                Entry entry;
+                entry.key = routeKey(*iter);
+                entry.plen = iter->getPlen();
+                entry.metric = iter->getMetric();
+
+                if (out.empty() == false && entryLess(entry, out.back()))
+                {
+                    sorted = false;
+                }
+
+                out.push_back(entry);
+            }
+
+            if (sorted == false)
+            {
+                std::sort(out.begin(), out.end(), entryLess);
+            }
+        };
+
+        /* Sweep the routes in [first, last) into 'out' */
+        template <class I> void sweep(I first, I last,
+                                      std::vector<Breakpoint> & out)
+        {
+            m_entries.clear();
+            getEntries(first, last, m_entries);
+            flatten(m_entries, out);
+        };
+
+        /* Sweep entries already in overlapCmp order into 'out' */
+        void flatten(const std::vector<Entry> & entries,
+                     std::vector<Breakpoint> & out)
+        {
+            PrefixKey zero = { 0, 0 };
+
+            out.clear();
+            m_open.clear();
+            addBreakpoint(out, zero, NO_METRIC);
+
+            for (size_t i = 0; i <= entries.size(); i++)
+            {
+                const Entry * cur = (i < entries.size()) ? &entries[i] : 0;
+
+                /* Close the routes that end before this one starts, and
+                 * all of them at the end
+                 */
+                while (m_open.empty() == false &&
+                       (cur == 0 || m_open.back().last < cur->key))
+                {
+                    PrefixKey closed = m_open.back().last;
+                    m_open.pop_back();
+
+                    if (closed.isMax() == false)
+                    {
+                        addBreakpoint(out, closed.next(),
+                                      m_open.empty() ? NO_METRIC :
+                                                       m_open.back().metric);
+                    }
+                }
+
+                if (cur == 0)
+                {
+                    break;
+                }
+
+                /* Sorted by metric last, the first of a prefix is lowest */
+                if (m_match == MATCH_LONGEST && i > 0 &&
+                    samePrefix(entries[i - 1], *cur))
+                {
+                    continue;
+                }
+
+                Open open;
+                open.last = cur->key.last(cur->plen);
+                open.metric = cur->metric;
+
+                if (m_match == MATCH_BEST && m_open.empty() == false &&
+                    m_open.back().metric < open.metric)
+                {
+                    open.metric = m_open.back().metric;
+                }
+
+                addBreakpoint(out, cur->key, open.metric);
+                m_open.push_back(open);
+            }
+        };
+
+        /* Release the working memory */
+        void clearSweep()
+        {
+            std::vector<Entry>().swap(m_entries);
+            std::vector<Open>().swap(m_open);
+        };
+
+        /* Constructor */
+        SpaceSweep(Match match) : m_match(match) {};
+
+    private:
+        /* A route still covering the sweep position */
+        struct Open
+        {
+            PrefixKey last;
+            int metric;     /* Metric of its addresses, counting the routes
+                             * around it when matching the best */
+        };
+
+        std::vector<Entry> m_entries;
+        std::vector<Open> m_open;
+        Match m_match;
+
+        /* Record that the metric changes at 'start', merging with the
+         * breakpoint before where nothing really changes
+         */
+        static void addBreakpoint(std::vector<Breakpoint> & out,
+                                  const PrefixKey & start, int metric)
+        {
+            if (out.empty() == false && out.back().start == start)
+            {
+                out.pop_back();
+            }
+
+            if (out.empty() == false && out.back().metric == metric)
+            {
+                return;
+            }
+
+            Breakpoint point;
+            point.start = start;
+            point.metric = metric;
+
+            out.push_back(point);
+        };
+    };
+}
+
+#endif /* ACRS_SPACE_H */
@@ -0,0 +1,272 @@
+/* acrsstats.hpp -- Summarization statistics and phase timing
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ACRS_STATS_H
+#define ACRS_STATS_H
+
+#include <iostream>
+#include <map>
+#include <cstdio>
+
+#include <inttypes.h>
+#include <time.h>
+
+namespace Acrs
+{
+    /* Wall clock and CPU time spent in one phase, in seconds. CPU time
+     * is for the whole process, so it includes every worker thread.
+     */
+    struct PhaseTime
+    {
+        double wall;
+        double cpu;
+    };
+
+    /* What one call to Acrs::summarize() did. Counters add up across
+     * passes, and across shards when summarizing on several threads.
+     */
+    struct Stats
+    {
+        enum Phase
+        {
+            PHASE_SORT,       /* Sorting, in either order */
+            PHASE_MERGE,      /* Merging siblings (and building the trie) */
+            PHASE_OVERLAP,    /* Removing overlap (and walking the trie) */
+            PHASE_BUDGET,     /* Lossy summarization to a route budget */
+            NUM_PHASES
+        };
+
+        typedef std::map<uint32_t, size_t> PlenCounts;
+        typedef std::map<int, size_t> MetricCounts;
+
+        size_t passes;        /* Merge passes, 1 for the trie engine */
+        size_t candidates;    /* Pairs of routes compared for merging */
+        size_t merges;        /* Sibling pairs merged into their parent */
+        size_t duplicates;    /* Routes dropped as exact duplicates */
+        size_t overlaps;      /* Routes dropped as covered by another */
+        size_t budget_summaries;
+                              /* Lossy summaries made to meet a budget */
+        double extra_space;   /* Addresses they cover that no route
+                               * did */
+        size_t allocations;   /* Made while summarizing, if counted (see
+                               * MemProfile) */
+        size_t allocated_bytes;
+        size_t peak_rss;      /* Process high water mark after, in bytes */
+
+        size_t input_routes;
+        size_t output_routes;
+        PlenCounts input_plen;
+        PlenCounts output_plen;
+        MetricCounts input_metric;
+        MetricCounts output_metric;
+
+        PhaseTime phase[NUM_PHASES];
+        PhaseTime total;
+
+        void clear()
+        {
+            *this = Stats();
+        };
+
+        /* Add another run's counters, but not its times */
+        void addCounts(const Stats & other)
+        {
+            passes += other.passes;
+            candidates += other.candidates;
+            merges += other.merges;
+            duplicates += other.duplicates;
+            overlaps += other.overlaps;
+            budget_summaries += other.budget_summaries;
+        };
+
+        /* Count a route summarize() was given, or one it returned */
+        void countInput(uint32_t plen, int metric)
+        {
+            input_routes++;
+            input_plen[plen]++;
+            input_metric[metric]++;
+        };
+
+        void countOutput(uint32_t plen, int metric)
+        {
+            output_routes++;
+            output_plen[plen]++;
+            output_metric[metric]++;
+        };
+
+        static const char * phaseName(Phase phase)
+        {
+            static const char * names[NUM_PHASES] =
+            {
+                "sort",
+                "merge",
+                "overlap",
+                "budget"
+            };
+
+            return names[phase];
+        };
+
+        /* Write everything as one JSON object */
+        void writeJson(std::ostream & os) const
+        {
+            os << "{\n"
+               << "  \"passes\": " << passes << ",\n"
+               << "  \"candidates\": " << candidates << ",\n"
+               << "  \"merges\": " << merges << ",\n"
+               << "  \"duplicates\": " << duplicates << ",\n"
+               << "  \"overlaps\": " << overlaps << ",\n"
+               << "  \"budget_summaries\": " << budget_summaries << ",\n"
+               << "  \"extra_space\": " << extra_space << ",\n"
+               << "  \"memory\": {\"allocations\": " << allocations
+               << ", \"bytes\": " << allocated_bytes
+               << ", \"peak_rss\": " << peak_rss << "},\n";
+
+            os << "  \"input\": ";
+            writeCounts(os, input_routes, input_plen, input_metric);
+            os << ",\n  \"output\": ";
+            writeCounts(os, output_routes, output_plen, output_metric);
+
+            os << ",\n  \"phases\": {\n";
+
+            for (int i = 0; i < NUM_PHASES; i++)
+            {
+                os << "    \"" << phaseName(static_cast<Phase>(i)) << "\": ";
+                writeTime(os, phase[i]);
+                os << ",\n";
+            }
+
+            os << "    \"total\": ";
+            writeTime(os, total);
+            os << "\n  }\n}\n";
+        };
+
+        Stats()
+              :
+              passes(0), candidates(0), merges(0), duplicates(0),
+              overlaps(0), budget_summaries(0), extra_space(0),
+              allocations(0), allocated_bytes(0), peak_rss(0),
+              input_routes(0), output_routes(0)
+        {
+            for (int i = 0; i < NUM_PHASES; i++)
+            {
+                phase[i].wall = 0;
+                phase[i].cpu = 0;
+            }
+
+            total.wall = 0;
+            total.cpu = 0;
+        };
+
+    private:
+        template <class M> static void writeMap(std::ostream & os,
+                                                const M & counts)
+        {
+            os << "{";
+
+            for (typename M::const_iterator iter = counts.begin();
+                 iter != counts.end();
+                 iter++)
+            {
+                os << (iter == counts.begin() ? "" : ", ")
+                   << "\"" << iter->first << "\": " << iter->second;
+            }
+
+            os << "}";
+        };
+
+        static void writeCounts(std::ostream & os, size_t routes,
+                                const PlenCounts & by_plen,
+                                const MetricCounts & by_metric)
+        {
+            os << "{\n"
+               << "    \"routes\": " << routes << ",\n"
+               << "    \"by_plen\": ";
+            writeMap(os, by_plen);
+            os << ",\n    \"by_metric\": ";
+            writeMap(os, by_metric);
+            os << "\n  }";
+        };
+
+        static void writeTime(std::ostream & os, const PhaseTime & time)
+        {
+            char buf[64];
+            snprintf(buf, sizeof(buf), "{\"wall\": %.6f, \"cpu\": %.6f}",
+                     time.wall, time.cpu);
+            os << buf;
+        };
+    };
+
+    /* Adds the time from its construction to stop() (or its destruction)
+     * to a phase. Does nothing if given no PhaseTime.
+     */
+    class PhaseTimer
+    {
+    private:
+        PhaseTime * m_time;
+        struct timespec m_wall_start;
+        struct timespec m_cpu_start;
+
+        static double elapsed(const struct timespec & start,
+                              const struct timespec & end)
+        {
+            return (end.tv_sec - start.tv_sec) +
+                   (end.tv_nsec - start.tv_nsec) / 1e9;
+        };
+
+    public:
+        void stop()
+        {
+            if (m_time == NULL)
+            {
+                return;
+            }
+
+            struct timespec wall_end;
+            struct timespec cpu_end;
+            clock_gettime(CLOCK_MONOTONIC, &wall_end);
+            clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_end);
+
+            m_time->wall += elapsed(m_wall_start, wall_end);
+            m_time->cpu += elapsed(m_cpu_start, cpu_end);
+            m_time = NULL;
+        };
+
+        /* Constructor */
+        PhaseTimer(PhaseTime * time)
+                   :
+                   m_time(time), m_wall_start(), m_cpu_start()
+        {
+            if (m_time == NULL)
+            {
+                return;
+            }
+
+            clock_gettime(CLOCK_MONOTONIC, &m_wall_start);
+            clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &m_cpu_start);
+        };
+
+        /* Destructor */
+        ~PhaseTimer()
+        {
+            stop();
+        };
+    };
+}
+
+#endif /* ACRS_STATS_H */
@@ -0,0 +1,356 @@
+/* acrstrie.hpp -- Binary prefix trie for single-pass summarization
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ACRS_TRIE_H
+#define ACRS_TRIE_H
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include <inttypes.h>
+
+#include "acrskey.hpp"
+
+namespace Acrs
+{
+    /* Binary trie keyed by network bits, with one entry per metric at each
+     * node. The trie never stores routes itself. Each entry refers to a
+     * route by the index the caller gave to insert(), and results are
+     * reported back through a listener object with these members:
+     *
+     *   onCandidate()                    Two sibling entries were compared
+     *   onMerge(lower, upper, plen)      Siblings merged into a parent of
+     *                                    length plen, lower survives
+     *   onDuplicate(kept, dropped, plen) Two routes had the same prefix
+     *   onOverlap(removed, removed_plen,
+     *             covering, covering_plen)
+     *                                    Route fell within another
+     *   onRoute(rep, plen)               Route survived; rep is to be
+     *                                    given prefix length plen
+     *
+     * onRoute() is called in overlapCmp order: network address ascending,
+     * then prefix length ascending, then metric ascending.
+     */
+    class PrefixTrie
+    {
+    public:
+        enum
+        {
+            NONE = 0xffffffff
+        };
+
+    private:
+        struct Node
+        {
+            uint32_t child[2];
+            uint32_t entry;        /* First entry, sorted by metric */
+            uint32_t plen;
+        };
+
+        struct Entry
+        {
+            int metric;
+            uint32_t rep;          /* Index of the route standing for this
+                                    * prefix and metric */
+            uint32_t next;
+            bool merged;           /* Folded into the parent's entry */
+        };
+
+        std::vector<Node> m_nodes;
+        std::vector<Entry> m_entries;
+
+        uint32_t newNode(uint32_t plen)
+        {
+            Node node;
+            node.child[0] = NONE;
+            node.child[1] = NONE;
+            node.entry = NONE;
+            node.plen = plen;
+
+            m_nodes.push_back(node);
+
+            return m_nodes.size() - 1;
+        };
+
+        /* Return the entry for 'metric' at node 'n', or NONE if there is
+         * none and 'rep' is NONE. Otherwise a new entry standing for route
+         * 'rep' is linked in. 'prev' and 'cur' are a cursor into the node's
+         * entry list and are left pointing at the returned entry, so a
+         * caller working through metrics in ascending order does not rescan
+         * the list.
+         */
+        uint32_t findEntry(uint32_t n, int metric, uint32_t rep,
+                           uint32_t & prev, uint32_t & cur)
+        {
+            while (cur != NONE && m_entries[cur].metric < metric)
+            {
+                prev = cur;
+                cur = m_entries[cur].next;
+            }
+
+            if (cur != NONE && m_entries[cur].metric == metric)
+            {
+                return cur;
+            }
+
+            if (rep == NONE)
+            {
+                return NONE;
+            }
+
+            Entry entry;
+            entry.metric = metric;
+            entry.rep = rep;
+            entry.next = cur;
+            entry.merged = false;
+
+            m_entries.push_back(entry);
+            uint32_t added = m_entries.size() - 1;
+
+            if (prev == NONE)
+            {
+                m_nodes[n].entry = added;
+            }
+            else
+            {
+                m_entries[prev].next = added;
+            }
+
+            cur = added;
+
+            return added;
+        };
+
+    public:
+        /* Fold sibling entries with equal metrics into their parent. This
+         * reaches the fixed point summarizeMain works towards over its
+         * passes: a prefix is present if it was given, or if both of its
+         * halves are present with the same metric.
+         *
+         * Children are always created after their parent, so walking the
+         * node pool from the end visits every child before its parent.
+         */
+        template <class L> void mergeSiblings(L & listener)
+        {
+            for (uint32_t n = m_nodes.size(); n-- > 0; )
+            {
+                uint32_t lower = m_nodes[n].child[0];
+                uint32_t upper = m_nodes[n].child[1];
+
+                if (lower == NONE || upper == NONE)
+                {
+                    continue;
+                }
+
+                uint32_t a = m_nodes[lower].entry;
+                uint32_t b = m_nodes[upper].entry;
+
+                /* Insertion point in this node's own entry list */
+                uint32_t prev = NONE;
+                uint32_t cur = m_nodes[n].entry;
+
+                while (a != NONE && b != NONE)
+                {
+                    int metric = m_entries[a].metric;
+                    listener.onCandidate();
+
+                    if (metric < m_entries[b].metric)
+                    {
+                        a = m_entries[a].next;
+                        continue;
+                    }
+                    else if (metric > m_entries[b].metric)
+                    {
+                        b = m_entries[b].next;
+                        continue;
+                    }
+
+                    /* If reached, both halves exist with the same metric */
+                    m_entries[a].merged = true;
+                    m_entries[b].merged = true;
+
+                    listener.onMerge(m_entries[a].rep, m_entries[b].rep,
+                                     m_nodes[n].plen);
+
+                    uint32_t e = findEntry(n, metric, NONE, prev, cur);
+
+                    if (e == NONE)
+                    {
+                        findEntry(n, metric, m_entries[a].rep, prev, cur);
+                    }
+                    else
+                    {
+                        /* The merged route replaces the one already here,
+                         * as it sorts ahead of it on the next pass.
+                         */
+                        listener.onDuplicate(m_entries[a].rep,
+                                             m_entries[e].rep,
+                                             m_nodes[n].plen);
+                        m_entries[e].rep = m_entries[a].rep;
+                    }
+
+                    a = m_entries[a].next;
+                    b = m_entries[b].next;
+                }
+            }
+        };
+
+        /* Visit the surviving entries in pre-order (node, lower subtree,
+         * upper subtree), which is overlapCmp order. An entry is dropped if
+         * the closest route kept above it does not have a higher metric,
+         * the same rule summarizeOverlap applies. With 'remove_overlap'
+         * false every entry left by merging is reported.
+         */
+        template <class L> void removeOverlap(L & listener,
+                                              bool remove_overlap)
+        {
+            struct Open
+            {
+                PrefixKey key;
+                uint32_t plen;
+                int metric;
+                uint32_t rep;
+            };
+
+            std::vector<std::pair<uint32_t, PrefixKey> > stack;
+            std::vector<Open> open;
+            PrefixKey root_key = { 0, 0 };
+
+            stack.push_back(std::make_pair(0, root_key));
+
+            while (stack.empty() == false)
+            {
+                uint32_t n = stack.back().first;
+                PrefixKey key = stack.back().second;
+                uint32_t plen = m_nodes[n].plen;
+                stack.pop_back();
+
+                while (open.empty() == false &&
+                       open.back().key.contains(open.back().plen, key) == false)
+                {
+                    open.pop_back();
+                }
+
+                for (uint32_t e = m_nodes[n].entry; e != NONE;
+                     e = m_entries[e].next)
+                {
+                    uint32_t rep = m_entries[e].rep;
+
+                    if (m_entries[e].merged == true)
+                    {
+                        continue;
+                    }
+
+                    if (remove_overlap == true && open.empty() == false &&
+                        m_entries[e].metric >= open.back().metric)
+                    {
+                        listener.onOverlap(rep, plen, open.back().rep,
+                                           open.back().plen);
+                        continue;
+                    }
+
+                    listener.onRoute(rep, plen);
+
+                    Open entry;
+                    entry.key = key;
+                    entry.plen = plen;
+                    entry.metric = m_entries[e].metric;
+                    entry.rep = rep;
+
+                    open.push_back(entry);
+                }
+
+                /* Push the upper half first so the lower half is visited
+                 * first.
+                 */
+                if (m_nodes[n].child[1] != NONE)
+                {
+                    stack.push_back(std::make_pair(m_nodes[n].child[1],
+                                                   key.withBit(plen, 1)));
+                }
+
+                if (m_nodes[n].child[0] != NONE)
+                {
+                    stack.push_back(std::make_pair(m_nodes[n].child[0], key));
+                }
+            }
+        };
+
+        /* Add a route. 'rep' is the caller's index for the route. If the
+         * same prefix and metric were already inserted, the earlier route
+         * is kept.
+         */
+        template <class L> void insert(const PrefixKey & key, uint32_t plen,
+                                       int metric, uint32_t rep,
+                                       L & listener)
+        {
+            uint32_t n = 0;
+
+            for (uint32_t pos = 0; pos < plen; pos++)
+            {
+                int side = key.bit(pos);
+
+                if (m_nodes[n].child[side] == NONE)
+                {
+                    uint32_t child = newNode(pos + 1);
+                    m_nodes[n].child[side] = child;
+                }
+
+                n = m_nodes[n].child[side];
+            }
+
+            uint32_t prev = NONE;
+            uint32_t cur = m_nodes[n].entry;
+            uint32_t e = findEntry(n, metric, NONE, prev, cur);
+
+            if (e != NONE)
+            {
+                listener.onDuplicate(m_entries[e].rep, rep, plen);
+                return;
+            }
+
+            findEntry(n, metric, rep, prev, cur);
+        };
+
+        /* Run sibling merging followed, unless 'remove_overlap' is false,
+         * by overlap removal. Callers timing the two steps can call
+         * mergeSiblings() and removeOverlap() themselves.
+         */
+        template <class L> void summarize(L & listener,
+                                          bool remove_overlap = true)
+        {
+            mergeSiblings(listener);
+            removeOverlap(listener, remove_overlap);
+        };
+
+        /* Reserve room for roughly 'routes' routes */
+        void reserve(size_t routes)
+        {
+            m_nodes.reserve(routes * 2);
+            m_entries.reserve(routes);
+        };
+
+        PrefixTrie()
+        {
+            newNode(0);
+        };
+    };
+}
+
+#endif /* ACRS_TRIE_H */
@@ -0,0 +1,145 @@
+/* acrsverify.hpp -- Check a summary against the routes it was made from
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ACRS_VERIFY_H
+#define ACRS_VERIFY_H
+
+#include <vector>
+
+#include "acrsspace.hpp"
+
+namespace Acrs
+{
+    /* Checks that a summary, such as the result of Acrs::summarize(),
+     * routes exactly the addresses its input did, each with the same best
+     * metric: the lowest metric of the routes covering it. This is what
+     * summarizing must keep; merged routes and removed overlaps change the
+     * prefixes but not the best metric of any address.
+     *
+     * Neither set is expanded into addresses. Each is swept once, as
+     * SpaceSweep does, into the ranges over which the best metric is
+     * constant, so a check costs a sort of each set, skipped if the set is
+     * already in overlapCmp order as summarize() leaves it, and a linear
+     * merge. IPv4 and IPv6 are handled alike. Set the match before
+     * setInput().
+     *
+     * The input is taken before summarizing, since summarize() works in
+     * place:
+     *
+     *     verifier.setInput(routes.begin(), routes.end());
+     *     acrs.summarize(routes);
+     *     bool same = verifier.check(routes.begin(), routes.end());
+     *
+     * A compressed forwarding table, such as the ORTC engine makes, keeps
+     * the metric of the longest matching prefix instead, and is checked
+     * with setMatch(MATCH_LONGEST). A summary made to a route budget
+     * routes extra space on purpose, and is checked with
+     * setCompare(COMPARE_NO_WORSE).
+     */
+    class Verifier : public SpaceSweep
+    {
+    public:
+        /* What a summary must keep of each address's metric */
+        enum Compare
+        {
+            COMPARE_SAME,       /* The same, routed or not (default) */
+            COMPARE_NO_WORSE    /* No higher, so addresses the input didn't
+                                 * route may be routed, but none it did may
+                                 * be left unrouted */
+        };
+
+        /* After a failed check(), the first range of addresses, from
+         * 'start' to 'end' inclusive, whose best metric differs (or is
+         * worse, with COMPARE_NO_WORSE), and that
+         * metric in the input and in the summary (NO_METRIC if not routed)
+         */
+        PrefixKey start;
+        PrefixKey end;
+        int input_metric;
+        int output_metric;
+
+    private:
+        std::vector<Breakpoint> m_input;
+        std::vector<Breakpoint> m_output;
+        Compare m_compare;
+
+    public:
+        /* Choose what check() accepts */
+        void setCompare(Compare compare)
+        {
+            m_compare = compare;
+        };
+
+        /* Take the routes in [first, last) as the input to compare with */
+        template <class I> void setInput(I first, I last)
+        {
+            sweep(first, last, m_input);
+        };
+
+        /* Compare the summary in [first, last) with the input. Return true
+         * if every address has the same best metric in both (or one no
+         * higher in the summary, with COMPARE_NO_WORSE), or false with the
+         * first range that doesn't in start, end, input_metric and
+         * output_metric.
+         */
+        template <class I> bool check(I first, I last)
+        {
+            sweep(first, last, m_output);
+
+            Walk walk(m_input, m_output);
+
+            while (walk.next() == true)
+            {
+                if (walk.a_metric == walk.b_metric ||
+                    (m_compare == COMPARE_NO_WORSE &&
+                     walk.b_metric < walk.a_metric))
+                {
+                    continue;
+                }
+
+                start = walk.start;
+                end = walk.end();
+                input_metric = walk.a_metric;
+                output_metric = walk.b_metric;
+
+                return false;
+            }
+
+            return true;
+        };
+
+        /* Release the input and working memory */
+        void clear()
+        {
+            std::vector<Breakpoint>().swap(m_input);
+            std::vector<Breakpoint>().swap(m_output);
+            clearSweep();
+        };
+
+        /* Constructor */
+        Verifier() : SpaceSweep(MATCH_BEST), input_metric(NO_METRIC),
+                     output_metric(NO_METRIC), m_compare(COMPARE_SAME)
+        {
+            start.hi = 0;
+            start.lo = 0;
+            end = start;
+        };
+    };
+}
+
+#endif /* ACRS_VERIFY_H */
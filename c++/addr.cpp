@@ -146,16 +146,6 @@ namespace IP
     /* Counts the number of bits set to 1 in a 4 byte integer */
     uint32_t Addr::onBits(uint32_t bytes) const
     {
-        int count;
-
-        /* Below is from:
-         *    http://graphics.stanford.edu/~seander/bithacks.html
-         */
-        for (count = 0; bytes; count++)
-        {
-            bytes &= bytes - 1;
-        }
-
-        return count;
+        return __builtin_popcount(bytes);
     }
 }
@@ -121,7 +121,18 @@ namespace IP
 
     bool Addr4::setAddr(const in_addr_t addr)
     {
-        return m_addr_net_form.setAddr(addr);
+        char buf[getAddrStrLen()];
+
+        if (! inet_ntop(getAddrFamily(), &addr, buf, getAddrStrLen()))
+        {
+            setAddrFail();
+            return false;
+        }
+
+        m_addr_net_form.setAddr(addr);
+        m_addr_pres_form = buf;
+        setAddrSuccess();
+        return true;
     }
 
     bool Addr4::setSnmask(const std::string & snmask)
@@ -22,6 +22,7 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <inttypes.h>
+#include <endian.h>
 #include <string.h>
 
 #include "addr6.hpp"
@@ -108,41 +109,12 @@ namespace IP
         return true;
     }
 
-    /* Requires that in6_addr.s6_addr be a uint8_t[16], which may not be true on
-     * all systems.
+    /* A mask is valid if it is exactly the mask for the prefix length its
+     * bit count gives.
      */
     bool Addr6::isValidSnmask(const in6_addr & mask) const
     {
-        const void * p_end = &(mask.s6_addr[sizeof(mask.s6_addr) - 1]);
-        bool sawzero = false;
-
-        for (uint8_t * p_addr_byte = const_cast<uint8_t *>(mask.s6_addr);
-             p_addr_byte != p_end;
-             p_addr_byte++)
-        {
-            if (sawzero == true)
-            {
-                /* After seeing a 0, all remaining bytes should be 0 */
-                if (*p_addr_byte != 0)
-                {
-                    return false;
-                }
-            }
-            else if (*p_addr_byte != 255)
-            {
-                /* At least one bit was not 0 */
-                sawzero = true;
-
-                /* Check if the byte is valid */
-                if (isValidSnmaskOnce(*p_addr_byte) == false)
-                {
-                    return false;
-                }
-            }
-        }
-
-        /* All bytes were valid */
-        return true;
+        return Addr6NetForm(mask) == Addr6NetForm(pltosm(smtopl(mask)));
     }
 
     bool Addr6::setMask(const std::string & mask)
@@ -175,20 +147,12 @@ namespace IP
 
     bool Addr6::setMask(const in6_addr & mask)
     {
-        char buf[getAddrStrLen()];
-
         if (! isValidSnmask(mask))
         {
             setMaskFail();
             return false;
         }
 
-        if (! inet_ntop(getAddrFamily(), &mask, buf, getAddrStrLen()))
-        {
-            setMaskFail();
-            return false;
-        }
-
         m_mask_net_form.setAddr(mask);
         m_plen = smtopl(mask);
         setMaskSuccess();
@@ -202,23 +166,22 @@ namespace IP
 
     Addr6NetForm Addr6::getBroadcastN() const
     {
-        return (Addr6NetForm(getNetworkN()) |
-               Addr6NetForm(getHostmaskN())).getAddr();
+        return (m_addr_net_form & m_mask_net_form) | ~m_mask_net_form;
     }
 
     Addr6NetForm Addr6::getNetworkN() const
     {
-        return (getNetFormAddr() & getNetFormMask()).getAddr();
+        return m_addr_net_form & m_mask_net_form;
     }
 
     Addr6NetForm Addr6::getHostmaskN() const
     {
-        return (~ getNetFormMask()).getAddr();
+        return ~m_mask_net_form;
     }
 
     Addr6NetForm Addr6::getAddrN() const
     {
-        return getNetFormAddr().getAddr();
+        return m_addr_net_form;
     }
 
     Addr6NetForm Addr6::getMaskN() const
@@ -309,31 +272,15 @@ namespace IP
         return;
     }
 
-    /* Mask must be validated in the caller. This counts the number of
-     * bits set to 1, assuming the mask is valid. (That is, it stops
-     * counting after it counts a byte that is not all 1s.)
+    /* Mask must be validated in the caller. For a valid mask the prefix
+     * length is the number of bits set, counted a word at a time.
      */
     uint32_t Addr6::smtopl(const in6_addr & mask) const
     {
-        const uint8_t * p_end = &(mask.s6_addr[sizeof(mask.s6_addr) - 1]);
-        int plen = 0;
-
-        for (const uint8_t * p_mask_byte = mask.s6_addr;
-             p_mask_byte <= p_end;
-             p_mask_byte++)
-        {
-            if (*p_mask_byte != 255)
-            {
-                return plen + onBits(*p_mask_byte);
-            }
-            else
-            {
-                plen += 8;
-            }
-        }
+        Addr6NetForm words(mask);
 
-        /* All bits on */
-        return plen;
+        return __builtin_popcountll(words.getHighWord()) +
+               __builtin_popcountll(words.getLowWord());
     }
 
     bool Addr6::setSnmaskFromPlen(const uint32_t plen)
@@ -341,33 +288,22 @@ namespace IP
         return setMask(pltosm(plen));
     }
 
-    /* Prefix length should be validated by the caller */
+    /* Prefix length should be validated by the caller. Each half of the
+     * mask is all ones shifted left by the number of host bits it holds.
+     */
     in6_addr Addr6::pltosm(const uint32_t plen) const
     {
+        uint32_t hi_bits = (plen > 64) ? 64 : plen;
+        uint32_t lo_bits = (plen > 64) ? plen - 64 : 0;
+        uint64_t words[2];
         in6_addr mask;
-        int count = 0;
-        int fullbytes = plen / 8;
 
-        /* Init mask to all 0s */
-        memset(&mask.s6_addr, 0, sizeof(mask.s6_addr));
-
-        /* Turn on each "all 1's" byte */
-        memset(&mask.s6_addr, 0xFF, fullbytes);
-
-        /* Number of bits set to 1 in the last non-zero byte */
-        int extra_bits = plen % 8;
-
-        if (extra_bits == 0)
-        {
-            return mask;
-        }
+        words[0] = (hi_bits == 0) ? 0 : ~((uint64_t) 0) << (64 - hi_bits);
+        words[1] = (lo_bits == 0) ? 0 : ~((uint64_t) 0) << (64 - lo_bits);
 
-        /* Magic number 8 = number of bits in a byte
-         *
-         * In the last non-zero mask byte, flip on a number of bits equal to
-         * extra bits from the prefix length.
-         */
-        mask.s6_addr[fullbytes] = ~((1 << (8 - extra_bits)) - 1);
+        words[0] = htobe64(words[0]);
+        words[1] = htobe64(words[1]);
+        memcpy(&mask, words, sizeof(mask));
 
         return mask;
     }
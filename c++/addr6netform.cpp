@@ -19,6 +19,8 @@
 #include <string>
 
 #include <string.h>
+#include <endian.h>
+#include <inttypes.h>
 #include <netinet/in.h>
 
 #include "addrnetform.hpp"
@@ -33,103 +35,65 @@ namespace IP
 
     bool Addr6NetForm::setAddr(const in6_addr & addr)
     {
-        memcpy(&m_addr_net_form, &addr, sizeof(m_addr_net_form));
+        memcpy(m_addr_net_form, &addr, sizeof(m_addr_net_form));
         return true;
     }
 
+    /* Bitwise operators don't care about byte order, so they work on the
+     * stored words directly. Compilers turn these into a pair of 64 bit
+     * operations, or a single SSE2 one.
+     */
     Addr6NetForm Addr6NetForm::operator&(const Addr6NetForm & other) const
     {
-        in6_addr newaddr;
-        in6_addr thisaddr = this->getAddr();
-        in6_addr otheraddr = other.getAddr();
+        Addr6NetForm result;
 
-        for (int i = 0; i < sizeof(m_addr_net_form); i++)
-        {
-            newaddr.s6_addr[i] = thisaddr.s6_addr[i] & otheraddr.s6_addr[i];
-        }
+        result.m_addr_net_form[0] = m_addr_net_form[0] & other.m_addr_net_form[0];
+        result.m_addr_net_form[1] = m_addr_net_form[1] & other.m_addr_net_form[1];
 
-        return Addr6NetForm(newaddr);
+        return result;
     };
 
     Addr6NetForm Addr6NetForm::operator|(const Addr6NetForm & other) const
     {
-        in6_addr newaddr;
-        in6_addr thisaddr = this->getAddr();
-        in6_addr otheraddr = other.getAddr();
+        Addr6NetForm result;
 
-        for (int i = 0; i < sizeof(m_addr_net_form); i++)
-        {
-            newaddr.s6_addr[i] = thisaddr.s6_addr[i] | otheraddr.s6_addr[i];
-        }
+        result.m_addr_net_form[0] = m_addr_net_form[0] | other.m_addr_net_form[0];
+        result.m_addr_net_form[1] = m_addr_net_form[1] | other.m_addr_net_form[1];
 
-        return Addr6NetForm(newaddr);
+        return result;
     }
 
     Addr6NetForm Addr6NetForm::operator~() const
     {
-        in6_addr newaddr;
-        in6_addr thisaddr = this->getAddr();
+        Addr6NetForm result;
 
-        for (int i = 0; i < sizeof(m_addr_net_form); i++)
-        {
-            newaddr.s6_addr[i] = ~(thisaddr.s6_addr[i]);
-        }
+        result.m_addr_net_form[0] = ~m_addr_net_form[0];
+        result.m_addr_net_form[1] = ~m_addr_net_form[1];
 
-        return Addr6NetForm(newaddr);
+        return result;
     }
 
+    /* Compare as one 128 bit number. The high words decide unless they
+     * are equal, which is written without branches.
+     */
     bool Addr6NetForm::operator<(const Addr6NetForm & other) const
     {
-        in6_addr thisaddr = this->getAddr();
-        in6_addr otheraddr = other.getAddr();
-
-        for (int i = 0; i < sizeof(m_addr_net_form); i++)
-        {
-            if (thisaddr.s6_addr[i] < otheraddr.s6_addr[i])
-            {
-                return true;
-            }
-            else if (thisaddr.s6_addr[i] > otheraddr.s6_addr[i])
-            {
-                return false;
-            }
-        }
-
-        /* Full addresses were equal */
-        return false;
+        uint64_t hi = getHighWord();
+        uint64_t other_hi = other.getHighWord();
+
+        return (hi < other_hi) |
+               ((hi == other_hi) & (getLowWord() < other.getLowWord()));
     }
 
     bool Addr6NetForm::operator>(const Addr6NetForm & other) const
     {
-        in6_addr thisaddr = this->getAddr();
-        in6_addr otheraddr = other.getAddr();
-
-        for (int i = 0; i < sizeof(m_addr_net_form); i++)
-        {
-            if (thisaddr.s6_addr[i] > otheraddr.s6_addr[i])
-            {
-                return true;
-            }
-            else if (thisaddr.s6_addr[i] < otheraddr.s6_addr[i])
-            {
-                return false;
-            }
-        }
-
-        /* Full addresses were equal */
-        return false;
+        return other < *this;
     }
 
     bool Addr6NetForm::operator==(const Addr6NetForm & other) const
     {
-        if ((*this < other) || (*this > other))
-        {
-            return false;
-        }
-        else
-        {
-            return true;
-        }
+        return ((m_addr_net_form[0] ^ other.m_addr_net_form[0]) |
+                (m_addr_net_form[1] ^ other.m_addr_net_form[1])) == 0;
     }
 
     bool Addr6NetForm::operator!=(const Addr6NetForm & other) const
@@ -139,16 +103,18 @@ namespace IP
 
     Addr6NetForm Addr6NetForm::nbo() const
     {
-        return m_addr_net_form;
+        return *this;
     }
 
     Addr6NetForm Addr6NetForm::hbo() const
     {
-        return m_addr_net_form;
+        return *this;
     }
 
     Addr6NetForm::Addr6NetForm()
     {
+        m_addr_net_form[0] = 0;
+        m_addr_net_form[1] = 0;
     }
 
     Addr6NetForm::~Addr6NetForm()
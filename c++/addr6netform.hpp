@@ -23,6 +23,9 @@
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <inttypes.h>
+#include <endian.h>
+#include <string.h>
 
 #include "addrnetform.hpp"
 
@@ -32,12 +35,26 @@ namespace IP
     {
         private:
         protected:
-            in6_addr m_addr_net_form;
+            /* The address bytes as two 64 bit words, still in network
+             * byte order. Masking and equality work on the words as they
+             * are; ordering swaps them to host order first.
+             */
+            uint64_t m_addr_net_form[2];
 
         public:
-            in6_addr getAddr() const { return m_addr_net_form; };
+            in6_addr getAddr() const
+            {
+                in6_addr addr;
+                memcpy(&addr, m_addr_net_form, sizeof(addr));
+                return addr;
+            };
+
             bool setAddr(const in6_addr & addr);
 
+            /* Most and least significant halves, in host byte order */
+            uint64_t getHighWord() const { return be64toh(m_addr_net_form[0]); };
+            uint64_t getLowWord() const { return be64toh(m_addr_net_form[1]); };
+
             Addr6NetForm operator&(const Addr6NetForm & other) const;
             Addr6NetForm operator|(const Addr6NetForm & other) const;
             Addr6NetForm operator~() const;
@@ -0,0 +1,747 @@
+/* churn-bench.cpp -- Replay route churn against the summarizers
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <inttypes.h>
+#include <sys/resource.h>
+
+#include "../acrs.hpp"
+#include "../acrsincremental.hpp"
+#include "../route4packed.hpp"
+#include "../route6packed.hpp"
+#include "../cidrparse.hpp"
+#include "../routetable.hpp"
+#include "../routegen.hpp"
+
+#define OPTIONS "46chm:e:j:f:b:u:n:B:r:s:"
+
+/* Settings taken from the command line */
+typedef struct benchOptions
+{
+    bool ipv6;
+    bool check;
+    bool incremental;
+    int engine;
+    int threads;
+    const char * p_file;        /* -f, base table as text */
+    const char * p_table;       /* -b, base table as a route table */
+    const char * p_updates;     /* -u, recorded updates */
+    size_t count;               /* Synthetic updates to make */
+    size_t batch;               /* Updates applied between summaries */
+    double rate;                /* Updates per second, 0 for flat out */
+    uint64_t seed;
+} benchOptions;
+
+template <class P> struct Update
+{
+    P route;
+    bool withdraw;
+};
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void sleepUntil(double when)
+{
+    struct timespec ts;
+    ts.tv_sec = (time_t) when;
+    ts.tv_nsec = (long) ((when - ts.tv_sec) * 1e9);
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) ==
+           EINTR)
+    {
+    }
+}
+
+static bool parseRoute(const char * text, size_t len, IP::Route4Packed & rt)
+{
+    IP::Cidr4 cidr;
+    IP::ParseError err;
+
+    if (IP::parseCidr4(text, len, cidr, err) == false)
+    {
+        return false;
+    }
+
+    rt = IP::Route4Packed(cidr.addr, cidr.plen, cidr.metric);
+    return true;
+}
+
+static bool parseRoute(const char * text, size_t len, IP::Route6Packed & rt)
+{
+    IP::Cidr6 cidr;
+    IP::ParseError err;
+
+    if (IP::parseCidr6(text, len, cidr, err) == false)
+    {
+        return false;
+    }
+
+    rt = IP::Route6Packed(cidr.addr, cidr.plen, cidr.metric);
+    return true;
+}
+
+/* The whitespace separated words of a file, or of stdin if p_path is "-" */
+static bool readWords(const char * p_path, std::string & text,
+                      std::vector<std::pair<size_t, size_t> > & words)
+{
+    bool from_stdin = (strcmp(p_path, "-") == 0);
+    int fd = from_stdin ? STDIN_FILENO : open(p_path, O_RDONLY);
+    char buf[65536];
+    ssize_t got;
+
+    if (fd < 0)
+    {
+        fprintf(stderr, "Error: Could not open %s: %s\n", p_path,
+                strerror(errno));
+        return false;
+    }
+
+    while ((got = read(fd, buf, sizeof(buf))) != 0)
+    {
+        if (got < 0 && errno != EINTR)
+        {
+            fprintf(stderr, "Error: Could not read %s: %s\n", p_path,
+                    strerror(errno));
+            return false;
+        }
+
+        text.append(buf, (got > 0) ? got : 0);
+    }
+
+    if (from_stdin == false)
+    {
+        close(fd);
+    }
+
+    for (size_t pos = 0; pos < text.size(); )
+    {
+        pos = text.find_first_not_of(" \t\r\n", pos);
+
+        if (pos == std::string::npos)
+        {
+            break;
+        }
+
+        size_t end = text.find_first_of(" \t\r\n", pos);
+        end = (end == std::string::npos) ? text.size() : end;
+        words.push_back(std::make_pair(pos, end - pos));
+        pos = end;
+    }
+
+    return true;
+}
+
+static bool getRoutes(const IP::RouteTable & table,
+                      std::vector<IP::Route4Packed> & base)
+{
+    IP::Route4Packed * p_routes;
+    size_t count;
+
+    if (table.getRoutes(p_routes, count) == false)
+    {
+        return false;
+    }
+
+    base.assign(p_routes, p_routes + count);
+    return true;
+}
+
+static bool getRoutes(const IP::RouteTable & table,
+                      std::vector<IP::Route6Packed> & base)
+{
+    IP::Route6Packed * p_routes;
+    size_t count;
+
+    if (table.getRoutes(p_routes, count) == false)
+    {
+        return false;
+    }
+
+    base.assign(p_routes, p_routes + count);
+    return true;
+}
+
+template <class P> bool readBase(const benchOptions & opts,
+                                 std::vector<P> & base)
+{
+    if (opts.p_table != 0)
+    {
+        IP::RouteTable table;
+
+        if (table.load(opts.p_table) == false)
+        {
+            fprintf(stderr, "Error: Could not load %s: %s\n", opts.p_table,
+                    table.getError());
+            return false;
+        }
+
+        if (getRoutes(table, base) == false)
+        {
+            fprintf(stderr, "Error: %s holds IPv%d routes.\n", opts.p_table,
+                    table.getFamily());
+            return false;
+        }
+    }
+
+    if (opts.p_file == 0)
+    {
+        return true;
+    }
+
+    std::string text;
+    std::vector<std::pair<size_t, size_t> > words;
+
+    if (readWords(opts.p_file, text, words) == false)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < words.size(); i++)
+    {
+        P rt;
+
+        if (parseRoute(&text[words[i].first], words[i].second, rt) == false)
+        {
+            fprintf(stderr, "Error: %s: invalid prefix '%s'\n", opts.p_file,
+                    text.substr(words[i].first, words[i].second).c_str());
+            return false;
+        }
+
+        base.push_back(rt);
+    }
+
+    return true;
+}
+
+/* Recorded updates are pairs of words: '+' or '-' and a prefix */
+template <class P> bool readUpdates(const char * p_path,
+                                    std::vector<Update<P> > & updates)
+{
+    std::string text;
+    std::vector<std::pair<size_t, size_t> > words;
+
+    if (readWords(p_path, text, words) == false)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i + 1 < words.size(); i += 2)
+    {
+        const char * p_op = &text[words[i].first];
+        Update<P> update;
+
+        if (words[i].second != 1 || (*p_op != '+' && *p_op != '-') ||
+            parseRoute(&text[words[i + 1].first], words[i + 1].second,
+                       update.route) == false)
+        {
+            fprintf(stderr, "Error: %s: invalid update '%s %s'\n", p_path,
+                    text.substr(words[i].first, words[i].second).c_str(),
+                    text.substr(words[i + 1].first,
+                                words[i + 1].second).c_str());
+            return false;
+        }
+
+        update.withdraw = (*p_op == '-');
+        updates.push_back(update);
+    }
+
+    if (words.size() % 2 != 0)
+    {
+        fprintf(stderr, "Error: %s: update without a prefix\n", p_path);
+        return false;
+    }
+
+    return true;
+}
+
+/* Flapping routes of the base table: each update withdraws a route that
+ * is up or announces one that is down. One announcement in eight comes
+ * back with a different metric, as a withdrawal and an announcement.
+ */
+template <class P> void makeUpdates(std::vector<P> base, size_t count,
+                                    uint64_t seed,
+                                    std::vector<Update<P> > & updates)
+{
+    std::vector<bool> up(base.size(), true);
+    IP::RouteGenerator random;
+
+    /* The same seed replays the same churn */
+    random.setSeed(seed);
+
+    while (updates.size() < count && base.empty() == false)
+    {
+        size_t i = random.nextRand(base.size());
+        Update<P> update;
+
+        if (up[i] == true && random.nextRand(8) == 0)
+        {
+            update.route = base[i];
+            update.withdraw = true;
+            updates.push_back(update);
+
+            base[i].setMetric((base[i].getMetric() + 1) % 4);
+            update.route = base[i];
+            update.withdraw = false;
+        }
+        else
+        {
+            update.route = base[i];
+            update.withdraw = up[i];
+            up[i] = !up[i];
+        }
+
+        updates.push_back(update);
+    }
+
+    updates.resize(std::min(updates.size(), count));
+}
+
+static bool sameRoute(const IP::Route4Packed & a, const IP::Route4Packed & b)
+{
+    return a.getNetworkH() == b.getNetworkH() && a.getPlen() == b.getPlen() &&
+           a.getMetric() == b.getMetric();
+}
+
+static bool sameRoute(const IP::Route6Packed & a, const IP::Route6Packed & b)
+{
+    return a.getNetworkHi() == b.getNetworkHi() &&
+           a.getNetworkLo() == b.getNetworkLo() &&
+           a.getPlen() == b.getPlen() && a.getMetric() == b.getMetric();
+}
+
+/* The baseline: apply updates to a plain table and summarize all of it
+ * again with Acrs::summarize after every batch.
+ */
+template <class P> class BatchReplay
+{
+private:
+    std::vector<P> m_routes;
+    std::vector<P> m_summary;
+    Acrs::Acrs m_acrs;
+
+public:
+    const char * name() const { return "batch"; };
+
+    void load(const std::vector<P> & base)
+    {
+        m_routes = base;
+        commit();
+    };
+
+    /* Returns false if a withdrawn route was not there */
+    bool apply(const Update<P> & update)
+    {
+        if (update.withdraw == false)
+        {
+            m_routes.push_back(update.route);
+            return true;
+        }
+
+        for (size_t i = 0; i < m_routes.size(); i++)
+        {
+            if (sameRoute(m_routes[i], update.route) == true)
+            {
+                m_routes[i] = m_routes.back();
+                m_routes.pop_back();
+                return true;
+            }
+        }
+
+        return false;
+    };
+
+    void commit()
+    {
+        m_summary = m_routes;
+        m_acrs.summarize(m_summary);
+    };
+
+    size_t summarySize() const { return m_summary.size(); };
+
+    void getSummary(std::vector<P> & out) const
+    {
+        out = m_summary;
+    };
+
+    BatchReplay(const benchOptions & opts)
+    {
+        m_acrs.setEngine(static_cast<Acrs::Acrs::Engine>(opts.engine));
+        m_acrs.setThreads(opts.threads);
+    };
+};
+
+/* Applies updates to an IncrementalSummary and flushes after every batch */
+template <class P> class IncrementalReplay
+{
+private:
+    Acrs::IncrementalSummary<P> m_summary;
+    std::vector<P> m_added;
+    std::vector<P> m_removed;
+    size_t m_size;
+
+public:
+    const char * name() const { return "incremental"; };
+
+    void load(const std::vector<P> & base)
+    {
+        m_summary.reserve(base.size());
+
+        for (size_t i = 0; i < base.size(); i++)
+        {
+            m_summary.add(base[i]);
+        }
+
+        commit();
+    };
+
+    bool apply(const Update<P> & update)
+    {
+        if (update.withdraw == true)
+        {
+            return m_summary.withdraw(update.route);
+        }
+
+        m_summary.add(update.route);
+        return true;
+    };
+
+    void commit()
+    {
+        m_added.clear();
+        m_removed.clear();
+        m_summary.flush(m_added, m_removed);
+        m_size += m_added.size();
+        m_size -= m_removed.size();
+    };
+
+    size_t summarySize() const { return m_size; };
+
+    void getSummary(std::vector<P> & out) const
+    {
+        out.clear();
+        m_summary.getSummary(out);
+    };
+
+    IncrementalReplay(const benchOptions & /* opts */) : m_size(0) {};
+};
+
+static double percentile(const std::vector<double> & sorted, double p)
+{
+    if (sorted.empty() == true)
+    {
+        return 0;
+    }
+
+    size_t i = (size_t) (p * (sorted.size() - 1) + 0.5);
+    return sorted[i];
+}
+
+/* Load the base table, replay the updates in batches, optionally paced,
+ * and write the results as JSON to stdout. An update's latency runs from
+ * when it was due (or, flat out, when its batch started) to when the
+ * summary covering it was done.
+ */
+template <class P, class E> int replay(E & engine,
+                                       const std::vector<P> & base,
+                                       const std::vector<Update<P> > & updates,
+                                       const benchOptions & opts)
+{
+    std::vector<double> latency;
+    size_t misses = 0;
+
+    latency.reserve(updates.size());
+
+    double load_start = now();
+    engine.load(base);
+    double start = now();
+
+    for (size_t first = 0; first < updates.size(); first += opts.batch)
+    {
+        size_t last = std::min(first + opts.batch, updates.size());
+        double due = now();
+
+        if (opts.rate > 0)
+        {
+            sleepUntil(start + (last - 1) / opts.rate);
+        }
+
+        for (size_t i = first; i < last; i++)
+        {
+            if (engine.apply(updates[i]) == false)
+            {
+                misses++;
+            }
+        }
+
+        engine.commit();
+        double done = now();
+
+        for (size_t i = first; i < last; i++)
+        {
+            if (opts.rate > 0)
+            {
+                due = start + i / opts.rate;
+            }
+
+            latency.push_back((done - due) * 1e6);
+        }
+    }
+
+    double elapsed = now() - start;
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    std::sort(latency.begin(), latency.end());
+
+    std::cout << "{\n"
+              << "  \"engine\": \"" << engine.name() << "\",\n"
+              << "  \"family\": " << (opts.ipv6 ? 6 : 4) << ",\n"
+              << "  \"base_routes\": " << base.size() << ",\n"
+              << "  \"updates\": " << updates.size() << ",\n"
+              << "  \"missed_withdrawals\": " << misses << ",\n"
+              << "  \"batch\": " << opts.batch << ",\n"
+              << "  \"rate\": " << opts.rate << ",\n"
+              << "  \"load_seconds\": " << start - load_start << ",\n"
+              << "  \"replay_seconds\": " << elapsed << ",\n"
+              << "  \"updates_per_second\": "
+              << (elapsed > 0 ? updates.size() / elapsed : 0) << ",\n"
+              << "  \"latency_us\": {\"p50\": " << percentile(latency, 0.5)
+              << ", \"p99\": " << percentile(latency, 0.99)
+              << ", \"p999\": " << percentile(latency, 0.999)
+              << ", \"max\": "
+              << (latency.empty() ? 0 : latency.back()) << "},\n"
+              << "  \"summary_routes\": " << engine.summarySize() << ",\n"
+              << "  \"peak_rss_kb\": " << usage.ru_maxrss << "\n"
+              << "}\n";
+
+    if (opts.check == false)
+    {
+        return 0;
+    }
+
+    /* The end result must match a batch summary of the same updates */
+    BatchReplay<P> reference(opts);
+    std::vector<P> expected;
+    std::vector<P> got;
+
+    reference.load(base);
+
+    for (size_t i = 0; i < updates.size(); i++)
+    {
+        reference.apply(updates[i]);
+    }
+
+    reference.commit();
+    reference.getSummary(expected);
+    engine.getSummary(got);
+
+    bool same = (expected.size() == got.size());
+
+    for (size_t i = 0; i < got.size() && same == true; i++)
+    {
+        same = sameRoute(expected[i], got[i]);
+    }
+
+    if (same == false)
+    {
+        fprintf(stderr, "Error: The %s summary differs from a batch "
+                        "summary.\n", engine.name());
+        return 1;
+    }
+
+    return 0;
+}
+
+template <class P> int run(const benchOptions & opts)
+{
+    std::vector<P> base;
+    std::vector<Update<P> > updates;
+
+    if (readBase(opts, base) == false)
+    {
+        return 2;
+    }
+
+    if (opts.p_updates != 0)
+    {
+        if (readUpdates(opts.p_updates, updates) == false)
+        {
+            return 2;
+        }
+    }
+    else
+    {
+        makeUpdates(base, opts.count, opts.seed, updates);
+    }
+
+    if (opts.incremental == true)
+    {
+        IncrementalReplay<P> engine(opts);
+        return replay(engine, base, updates, opts);
+    }
+
+    BatchReplay<P> engine(opts);
+    return replay(engine, base, updates, opts);
+}
+
+static void usage()
+{
+    fprintf(stderr,
+            "Replays route churn against a summarizer and reports its\n"
+            "throughput, latency and memory use as JSON.\n"
+            "Usage:\n"
+            "\n"
+            "       ./churn-bench [-46c] [-m MODE] [-e ENGINE] [-j THREADS] [-B BATCH]\n"
+            "                     [-r RATE] [-n COUNT] [-s SEED] [-u UPDATES]\n"
+            "                     -f FILE | -b TABLE\n"
+            "\n"
+            "       Options:\n"
+            "       -f FILE  Base table as prefixes, as read by acrs-demo -f\n"
+            "       -b TABLE Base table as a binary route table\n"
+            "       -u UPDATES  Replays recorded updates: pairs of '+' (announce)\n"
+            "             or '-' (withdraw) and a prefix. Without -u, COUNT updates\n"
+            "             flapping routes of the base table are made up.\n"
+            "       -n COUNT Number of updates to make up (default 10000)\n"
+            "       -s SEED  Seed for made up updates (default 1)\n"
+            "       -m MODE  incremental (default) applies updates to an\n"
+            "             IncrementalSummary; batch summarizes the whole table\n"
+            "             again with Acrs::summarize, as a baseline\n"
+            "       -e ENGINE, -j THREADS  Engine (pass or trie) and threads\n"
+            "             for batch mode\n"
+            "       -B BATCH Updates applied between summaries (default 1)\n"
+            "       -r RATE  Updates per second, 0 for as fast as possible\n"
+            "             (default 0)\n"
+            "       -c    Checks the final summary against a batch summary\n"
+            "       -4    Routes are IPv4 (default)\n"
+            "       -6    Routes are IPv6\n"
+            "       -h    Displays this help message\n");
+}
+
+int main(int argc, char * argv[])
+{
+    int c;
+    benchOptions opts;
+
+    opts.ipv6 = false;
+    opts.check = false;
+    opts.incremental = true;
+    opts.engine = Acrs::Acrs::ENGINE_PASS;
+    opts.threads = 1;
+    opts.p_file = 0;
+    opts.p_table = 0;
+    opts.p_updates = 0;
+    opts.count = 10000;
+    opts.batch = 1;
+    opts.rate = 0;
+    opts.seed = 1;
+
+    while ((c = getopt(argc, argv, OPTIONS)) != -1)
+    {
+        switch (c)
+        {
+        case '4':
+            opts.ipv6 = false;
+            break;
+        case '6':
+            opts.ipv6 = true;
+            break;
+        case 'c':
+            opts.check = true;
+            break;
+        case 'm':
+            if (strcmp(optarg, "incremental") != 0 &&
+                strcmp(optarg, "batch") != 0)
+            {
+                fprintf(stderr, "Invalid mode: %s\n", optarg);
+                return 2;
+            }
+
+            opts.incremental = (strcmp(optarg, "incremental") == 0);
+            break;
+        case 'e':
+            if (strcmp(optarg, "pass") != 0 && strcmp(optarg, "trie") != 0)
+            {
+                fprintf(stderr, "Invalid engine: %s\n", optarg);
+                return 2;
+            }
+
+            opts.engine = (strcmp(optarg, "trie") == 0) ?
+                          Acrs::Acrs::ENGINE_TRIE : Acrs::Acrs::ENGINE_PASS;
+            break;
+        case 'j':
+            opts.threads = atoi(optarg);
+            break;
+        case 'f':
+            opts.p_file = optarg;
+            break;
+        case 'b':
+            opts.p_table = optarg;
+            break;
+        case 'u':
+            opts.p_updates = optarg;
+            break;
+        case 'n':
+            opts.count = strtoul(optarg, NULL, 10);
+            break;
+        case 'B':
+            opts.batch = strtoul(optarg, NULL, 10);
+            break;
+        case 'r':
+            opts.rate = strtod(optarg, NULL);
+            break;
+        case 's':
+            opts.seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'h': /* Fall through */
+        default:
+            usage();
+            return 2;
+        }
+    }
+
+    if ((opts.p_file == 0 && opts.p_table == 0) || opts.batch == 0 ||
+        opts.threads < 1 || opts.rate < 0)
+    {
+        usage();
+        return 2;
+    }
+
+    if (opts.ipv6 == true)
+    {
+        return run<IP::Route6Packed>(opts);
+    }
+
+    return run<IP::Route4Packed>(opts);
+}
@@ -0,0 +1,234 @@
+/* gen-table.cpp -- Writes reproducible synthetic route tables
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+#include <cstdio>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <inttypes.h>
+
+#include "../routegen.hpp"
+#include "../routetable.hpp"
+#include "../routewriter.hpp"
+
+#define OPTIONS "46hrt:n:s:m:d:o:"
+
+/* Settings taken from the command line */
+typedef struct genOptions
+{
+    bool ipv6;
+    IP::RouteGenerator generator;
+    size_t count;
+    const char * p_out;         /* -o, binary route table output */
+} genOptions;
+
+/* Print the routes, or save them as a route table of the chosen family
+ * if -o was given ("-" for stdout)
+ */
+template <class P> static bool writeRoutes(const std::vector<P> & routes,
+                                           const genOptions & opts)
+{
+    const char * p_out = opts.p_out;
+
+    if (p_out == 0)
+    {
+        IP::RouteWriter writer(STDOUT_FILENO, IP::RouteWriter::METRIC_BRIEF);
+
+        for (size_t i = 0; i < routes.size(); i++)
+        {
+            writer.write(routes[i]);
+        }
+
+        if (writer.flush() == false)
+        {
+            fprintf(stderr, "Error: Could not write the routes: %s\n",
+                    strerror(errno));
+            return false;
+        }
+
+        return true;
+    }
+
+    IP::RouteTableWriter table;
+    table.setFamily(opts.ipv6 ? 6 : 4);
+
+    for (size_t i = 0; i < routes.size(); i++)
+    {
+        table.add(routes[i]);
+    }
+
+    bool to_stdout = (strcmp(p_out, "-") == 0);
+    int fd = to_stdout ? STDOUT_FILENO :
+                         open(p_out, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+    if (fd < 0)
+    {
+        fprintf(stderr, "Error: Could not open %s: %s\n", p_out,
+                strerror(errno));
+        return false;
+    }
+
+    bool ok = table.write(fd);
+
+    if (ok == false || (to_stdout == false && close(fd) != 0))
+    {
+        fprintf(stderr, "Error: Could not write %s: %s\n", p_out,
+                strerror(errno));
+        ok = false;
+    }
+
+    return ok;
+}
+
+template <class P> static int run(genOptions & opts)
+{
+    std::vector<P> routes;
+
+    opts.generator.generate(opts.count, routes);
+
+    return (writeRoutes(routes, opts) == true) ? 0 : 2;
+}
+
+static void usage()
+{
+    fprintf(stderr,
+            "Writes a synthetic route table. The same options always give\n"
+            "the same routes.\n"
+            "Usage:\n"
+            "\n"
+            "       ./gen-table [-46r] [-t SHAPE] [-n COUNT] [-s SEED] [-m METRICS]\n"
+            "                   [-d DUPS] [-o TABLE]\n"
+            "\n"
+            "       Options:\n"
+            "       -t SHAPE Shape of the table (default full):\n"
+            "             full: prefix lengths as in a full BGP table, in\n"
+            "                   clustered blocks mostly sharing a metric\n"
+            "             siblings: aligned runs of up to 65536 adjacent /24s\n"
+            "                   (/48s for IPv6) of one metric, each taking\n"
+            "                   up to 16 merge passes\n"
+            "             nested: chains of prefixes down to host routes,\n"
+            "                   each inside the one before\n"
+            "       -n COUNT Number of routes (default 1000000)\n"
+            "       -s SEED  Seed (default 1)\n"
+            "       -m METRICS  Number of distinct metrics (default 1)\n"
+            "       -d DUPS  Percent chance of a duplicate of an earlier\n"
+            "             route after each route, half with another metric\n"
+            "             (default 0)\n"
+            "       -r    Writes the routes in random order instead of the\n"
+            "             order generated\n"
+            "       -o TABLE Writes a binary route table, sorted, instead of\n"
+            "             printing prefixes as read by acrs-demo -f. Use - for\n"
+            "             standard output.\n"
+            "       -4    Routes are IPv4 (default)\n"
+            "       -6    Routes are IPv6\n"
+            "       -h    Displays this help message\n");
+}
+
+int main(int argc, char * argv[])
+{
+    int c;
+    genOptions opts;
+    char * p_end;
+
+    opts.ipv6 = false;
+    opts.count = 1000000;
+    opts.p_out = 0;
+
+    while ((c = getopt(argc, argv, OPTIONS)) != -1)
+    {
+        switch (c)
+        {
+        case '4':
+            opts.ipv6 = false;
+            break;
+        case '6':
+            opts.ipv6 = true;
+            break;
+        case 'r':
+            opts.generator.setShuffle(true);
+            break;
+        case 't':
+            if (strcmp(optarg, "full") == 0)
+            {
+                opts.generator.setShape(IP::RouteGenerator::SHAPE_FULL);
+            }
+            else if (strcmp(optarg, "siblings") == 0)
+            {
+                opts.generator.setShape(IP::RouteGenerator::SHAPE_SIBLINGS);
+            }
+            else if (strcmp(optarg, "nested") == 0)
+            {
+                opts.generator.setShape(IP::RouteGenerator::SHAPE_NESTED);
+            }
+            else
+            {
+                fprintf(stderr, "Invalid shape: %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 'n':
+            opts.count = strtoull(optarg, &p_end, 10);
+
+            if (*optarg == '\0' || *p_end != '\0')
+            {
+                fprintf(stderr, "Invalid number of routes: %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 's':
+            opts.generator.setSeed(strtoull(optarg, &p_end, 10));
+
+            if (*optarg == '\0' || *p_end != '\0')
+            {
+                fprintf(stderr, "Invalid seed: %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 'm':
+            opts.generator.setMetrics(atoi(optarg));
+            break;
+        case 'd':
+            opts.generator.setDuplicates(atoi(optarg));
+            break;
+        case 'o':
+            opts.p_out = optarg;
+            break;
+        case 'h': /* Fall through */
+        default:
+            usage();
+            return 2;
+        }
+    }
+
+    if (optind != argc)
+    {
+        usage();
+        return 2;
+    }
+
+    if (opts.ipv6 == true)
+    {
+        return run<IP::Route6Packed>(opts);
+    }
+
+    return run<IP::Route4Packed>(opts);
+}
@@ -0,0 +1,225 @@
+/* lookup-bench.cpp -- Benchmarks for longest prefix match lookups
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <map>
+#include <vector>
+#include <string>
+
+#include <arpa/inet.h>
+#include <inttypes.h>
+
+#include <benchmark/benchmark.h>
+
+#include "../acrs.hpp"
+#include "../routelookup.hpp"
+#include "../routegen.hpp"
+#include "../route4packed.hpp"
+#include "../route6packed.hpp"
+
+#define NUM_ROUTES 1000000
+#define NUM_METRICS 4
+#define NUM_ADDRS (1 << 20)
+
+#define TABLE_SEED 1
+#define ADDR_SEED 2
+
+typedef IP::RouteGenerator::Shape Shape;
+
+/* What differs between the address families */
+struct Family4
+{
+    typedef IP::Route4Packed Packed;
+    typedef IP::RouteLookup4 Lookup;
+    typedef in_addr_t Addr;
+    typedef std::vector<Addr> AddrList;
+
+    static Addr randomAddr(IP::RouteGenerator & generator)
+    {
+        return htonl(generator.nextRand() >> 32);
+    };
+};
+
+struct Family6
+{
+    typedef IP::Route6Packed Packed;
+    typedef IP::RouteLookup6 Lookup;
+    typedef in6_addr Addr;
+    typedef std::vector<Addr> AddrList;
+
+    static Addr randomAddr(IP::RouteGenerator & generator)
+    {
+        in6_addr addr;
+        uint64_t hi = generator.nextRand();
+        uint64_t lo = generator.nextRand();
+
+        for (int i = 0; i < 8; i++)
+        {
+            addr.s6_addr[i] = hi >> (56 - i * 8);
+            addr.s6_addr[i + 8] = lo >> (56 - i * 8);
+        }
+
+        /* Keep everything under 2000::/3, where the tables are */
+        addr.s6_addr[0] = 0x20 | (addr.s6_addr[0] & 0x1f);
+
+        return addr;
+    };
+};
+
+static const struct
+{
+    Shape shape;
+    const char * p_name;
+} SHAPES[] =
+{
+    {IP::RouteGenerator::SHAPE_FULL, "full"},
+    {IP::RouteGenerator::SHAPE_SIBLINGS, "siblings"},
+    {IP::RouteGenerator::SHAPE_NESTED, "nested"}
+};
+
+#define NUM_SHAPES (sizeof(SHAPES) / sizeof(SHAPES[0]))
+
+/* Tables are summarized first, as they would be when served */
+template <class F> static const typename F::Lookup & lookupTable(Shape shape)
+{
+    static std::map<Shape, typename F::Lookup> tables;
+
+    typename std::map<Shape, typename F::Lookup>::iterator found =
+        tables.find(shape);
+
+    if (found != tables.end())
+    {
+        return found->second;
+    }
+
+    typename F::Lookup & lookup = tables[shape];
+    IP::RouteGenerator generator;
+    std::vector<typename F::Packed> routes;
+
+    generator.setShape(shape);
+    generator.setSeed(TABLE_SEED);
+    generator.setMetrics(NUM_METRICS);
+    generator.generate(NUM_ROUTES, routes);
+
+    Acrs::Acrs acrs;
+    acrs.summarize(routes);
+
+    for (size_t i = 0; i < routes.size(); i++)
+    {
+        lookup.add(routes[i]);
+    }
+
+    lookup.build();
+
+    return lookup;
+}
+
+/* The same addresses for every table */
+template <class F> static const typename F::AddrList & lookupAddrs()
+{
+    static typename F::AddrList addrs;
+
+    if (addrs.empty())
+    {
+        IP::RouteGenerator generator;
+        generator.setSeed(ADDR_SEED);
+
+        for (int i = 0; i < NUM_ADDRS; i++)
+        {
+            addrs.push_back(F::randomAddr(generator));
+        }
+    }
+
+    return addrs;
+}
+
+template <class F> static void BM_Lookup(benchmark::State & state,
+                                         Shape shape)
+{
+    const typename F::Lookup & lookup = lookupTable<F>(shape);
+    const typename F::AddrList & addrs = lookupAddrs<F>();
+    uint32_t found = 0;
+
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < addrs.size(); i++)
+        {
+            found += (lookup.lookup(addrs[i]) != F::Lookup::NONE);
+        }
+    }
+
+    benchmark::DoNotOptimize(found);
+    state.SetItemsProcessed(state.iterations() * addrs.size());
+}
+
+template <class F> static void BM_LookupBatch(benchmark::State & state,
+                                              Shape shape)
+{
+    const typename F::Lookup & lookup = lookupTable<F>(shape);
+    const typename F::AddrList & addrs = lookupAddrs<F>();
+    std::vector<uint32_t> results(state.range(0));
+
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i + results.size() <= addrs.size();
+             i += results.size())
+        {
+            lookup.lookup(&addrs[i], results.size(), &results[0]);
+        }
+
+        benchmark::DoNotOptimize(results[0]);
+    }
+
+    state.SetItemsProcessed(state.iterations() * addrs.size());
+}
+
+/* Register the lookups for each shape, named FAMILY/SHAPE/LOOKUP so one
+ * table can be picked out with --benchmark_filter
+ */
+template <class F> static void addBenchmarks(const char * p_family)
+{
+    for (size_t i = 0; i < NUM_SHAPES; i++)
+    {
+        Shape shape = SHAPES[i].shape;
+        std::string prefix = std::string(p_family) + "/" +
+                             SHAPES[i].p_name + "/";
+
+        benchmark::RegisterBenchmark((prefix + "lookup").c_str(),
+                                     BM_Lookup<F>, shape)
+            ->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark((prefix + "lookup_batch").c_str(),
+                                     BM_LookupBatch<F>, shape)
+            ->Arg(64)->Arg(1024)->Unit(benchmark::kMillisecond);
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    benchmark::Initialize(&argc, argv);
+
+    if (benchmark::ReportUnrecognizedArguments(argc, argv) == true)
+    {
+        return 1;
+    }
+
+    addBenchmarks<Family4>("v4");
+    addBenchmarks<Family6>("v6");
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return 0;
+}
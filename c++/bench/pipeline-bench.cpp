@@ -0,0 +1,452 @@
+/* pipeline-bench.cpp -- Each stage of acrs-demo's pipeline, and all of it
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <list>
+#include <map>
+#include <vector>
+#include <string>
+#include <cstdio>
+
+#include <inttypes.h>
+#include <fcntl.h>
+
+#include <benchmark/benchmark.h>
+
+#include "../acrs.hpp"
+#include "../route4.hpp"
+#include "../route6.hpp"
+#include "../route4packed.hpp"
+#include "../route6packed.hpp"
+#include "../cidrparse.hpp"
+#include "../routewriter.hpp"
+#include "../routegen.hpp"
+
+#define NUM_ROUTES 250000
+#define NUM_METRICS 4
+#define DUPLICATES 5            /* Percent */
+
+typedef IP::RouteGenerator::Shape Shape;
+
+/* What differs between the address families */
+struct Family4
+{
+    typedef IP::Route4 Route;
+    typedef IP::Route4Packed Packed;
+    typedef IP::Cidr4 Cidr;
+
+    static bool parse(const char * p_text, size_t len, Cidr & cidr,
+                      IP::ParseError & err)
+    {
+        return IP::parseCidr4(p_text, len, cidr, err);
+    };
+
+    static size_t formatAddr(char * buf, const Packed & rt)
+    {
+        return IP::RouteWriter::formatAddr4(buf, rt.getAddrH());
+    };
+};
+
+struct Family6
+{
+    typedef IP::Route6 Route;
+    typedef IP::Route6Packed Packed;
+    typedef IP::Cidr6 Cidr;
+
+    static bool parse(const char * p_text, size_t len, Cidr & cidr,
+                      IP::ParseError & err)
+    {
+        return IP::parseCidr6(p_text, len, cidr, err);
+    };
+
+    static size_t formatAddr(char * buf, const Packed & rt)
+    {
+        return IP::RouteWriter::formatAddr6(buf, rt.getAddrHi(),
+                                            rt.getAddrLo());
+    };
+};
+
+/* One generated table at each stage of the pipeline, so every stage can
+ * be timed on its own input
+ */
+template <class F> struct Table
+{
+    typedef std::list<typename F::Route> RouteList;
+
+    std::string text;                       /* As acrs-demo -f reads it */
+    std::vector<typename F::Cidr> cidrs;    /* Parsed */
+    RouteList routes;                       /* Constructed */
+    RouteList summary;                      /* Summarized */
+};
+
+static const struct
+{
+    Shape shape;
+    const char * p_name;
+} SHAPES[] =
+{
+    {IP::RouteGenerator::SHAPE_FULL, "full"},
+    {IP::RouteGenerator::SHAPE_SIBLINGS, "siblings"},
+    {IP::RouteGenerator::SHAPE_NESTED, "nested"}
+};
+
+#define NUM_SHAPES (sizeof(SHAPES) / sizeof(SHAPES[0]))
+
+/* Output goes nowhere, so only formatting and write(2) are timed */
+static int nullFd()
+{
+    static int fd = open("/dev/null", O_WRONLY);
+
+    return fd;
+}
+
+/* Split the text on whitespace and parse each prefix, as acrs-demo's
+ * RouteReader does
+ */
+template <class F> static void parseText(const std::string & text,
+                                         std::vector<typename F::Cidr> & cidrs)
+{
+    const char * p = text.data();
+    const char * p_end = p + text.size();
+
+    while (p < p_end)
+    {
+        while (p < p_end && (*p == ' ' || *p == '\t' || *p == '\n'))
+        {
+            p++;
+        }
+
+        const char * p_prefix = p;
+
+        while (p < p_end && *p != ' ' && *p != '\t' && *p != '\n')
+        {
+            p++;
+        }
+
+        if (p == p_prefix)
+        {
+            break;
+        }
+
+        typename F::Cidr cidr;
+        IP::ParseError err;
+
+        if (F::parse(p_prefix, p - p_prefix, cidr, err) == true)
+        {
+            cidrs.push_back(cidr);
+        }
+    }
+}
+
+template <class F> static void construct(
+        const std::vector<typename F::Cidr> & cidrs,
+        typename Table<F>::RouteList & rt_list)
+{
+    for (size_t i = 0; i < cidrs.size(); i++)
+    {
+        rt_list.push_back(typename F::Route(cidrs[i].addr, cidrs[i].plen,
+                                            IP::PLEN, cidrs[i].metric));
+    }
+}
+
+template <class T> static void writeRoutes(const T & rt_list)
+{
+    IP::RouteWriter writer(nullFd(), IP::RouteWriter::METRIC_BRIEF);
+
+    for (typename T::const_iterator iter = rt_list.begin();
+         iter != rt_list.end();
+         iter++)
+    {
+        writer.write(*iter);
+    }
+
+    writer.flush();
+}
+
+/* Generate a shape's table the first time it's asked for. Routes are
+ * shuffled so that no stage is handed them already sorted.
+ */
+template <class F> static const Table<F> & getTable(Shape shape)
+{
+    static std::map<Shape, Table<F> > tables;
+
+    typename std::map<Shape, Table<F> >::iterator found = tables.find(shape);
+
+    if (found != tables.end())
+    {
+        return found->second;
+    }
+
+    Table<F> & table = tables[shape];
+    IP::RouteGenerator generator;
+    std::vector<typename F::Packed> packed;
+
+    generator.setShape(shape);
+    generator.setMetrics(NUM_METRICS);
+    generator.setDuplicates(DUPLICATES);
+    generator.setShuffle(true);
+    generator.generate(NUM_ROUTES, packed);
+
+    for (size_t i = 0; i < packed.size(); i++)
+    {
+        char buf[IP::RouteWriter::MAX_LINE];
+        size_t len = F::formatAddr(buf, packed[i]);
+
+        len += snprintf(buf + len, sizeof(buf) - len, "/%um%d\n",
+                        packed[i].getPlen(), packed[i].getMetric());
+        table.text.append(buf, len);
+    }
+
+    parseText<F>(table.text, table.cidrs);
+    construct<F>(table.cidrs, table.routes);
+
+    table.summary = table.routes;
+    Acrs::Acrs summary;
+    summary.summarize(table.summary);
+
+    return table;
+}
+
+template <class F> static void BM_Parse(benchmark::State & state, Shape shape)
+{
+    const Table<F> & table = getTable<F>(shape);
+    std::vector<typename F::Cidr> cidrs;
+    cidrs.reserve(table.cidrs.size());
+
+    for (auto _ : state)
+    {
+        cidrs.clear();
+        parseText<F>(table.text, cidrs);
+        benchmark::DoNotOptimize(cidrs.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * table.cidrs.size());
+    state.SetBytesProcessed(state.iterations() * table.text.size());
+}
+
+template <class F> static void BM_Construct(benchmark::State & state,
+                                            Shape shape)
+{
+    const Table<F> & table = getTable<F>(shape);
+    typename Table<F>::RouteList rt_list;
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        rt_list.clear();
+        state.ResumeTiming();
+
+        construct<F>(table.cidrs, rt_list);
+    }
+
+    state.SetItemsProcessed(state.iterations() * table.cidrs.size());
+}
+
+/* Sort with the comparators that define the summarizer's two orders */
+template <class F> static void BM_SortCmp(benchmark::State & state,
+                                          Shape shape, Acrs::SortOrder order)
+{
+    const Table<F> & table = getTable<F>(shape);
+    typename Table<F>::RouteList rt_list;
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        rt_list = table.routes;
+        state.ResumeTiming();
+
+        if (order == Acrs::ORDER_ACRS)
+        {
+            rt_list.sort(Acrs::Acrs::acrsCmp<typename F::Route>);
+        }
+        else
+        {
+            rt_list.sort(Acrs::Acrs::overlapCmp<typename F::Route>);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * table.routes.size());
+}
+
+/* The same orders by radix sort, as the summarizer sorts */
+template <class F> static void BM_SortRadix(benchmark::State & state,
+                                            Shape shape, Acrs::SortOrder order)
+{
+    const Table<F> & table = getTable<F>(shape);
+    typename Table<F>::RouteList rt_list;
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        rt_list = table.routes;
+        state.ResumeTiming();
+
+        Acrs::radixSort(rt_list, order);
+    }
+
+    state.SetItemsProcessed(state.iterations() * table.routes.size());
+}
+
+/* summarizeMain and summarizeOverlap are private, so the summarizer's
+ * own phase timers report their time. Sorting is left out, as it is
+ * timed above.
+ */
+template <class F> static void BM_Phase(benchmark::State & state,
+                                        Shape shape, Acrs::Stats::Phase phase)
+{
+    const Table<F> & table = getTable<F>(shape);
+    typename Table<F>::RouteList rt_list;
+    Acrs::Stats stats;
+    Acrs::Acrs summary;
+
+    summary.setStats(&stats);
+
+    for (auto _ : state)
+    {
+        rt_list = table.routes;
+        summary.summarize(rt_list);
+
+        state.SetIterationTime(stats.phase[phase].wall);
+    }
+
+    state.counters["passes"] = stats.passes;
+    state.counters["merges"] = stats.merges;
+    state.counters["overlaps"] = stats.overlaps;
+    state.SetItemsProcessed(state.iterations() * table.routes.size());
+}
+
+template <class F> static void BM_Summarize(benchmark::State & state,
+                                            Shape shape)
+{
+    const Table<F> & table = getTable<F>(shape);
+    typename Table<F>::RouteList rt_list;
+    Acrs::Acrs summary;
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        rt_list = table.routes;
+        state.ResumeTiming();
+
+        summary.summarize(rt_list);
+    }
+
+    state.counters["output_routes"] = table.summary.size();
+    state.SetItemsProcessed(state.iterations() * table.routes.size());
+}
+
+template <class F> static void BM_Output(benchmark::State & state,
+                                         Shape shape)
+{
+    const Table<F> & table = getTable<F>(shape);
+
+    for (auto _ : state)
+    {
+        writeRoutes(table.summary);
+    }
+
+    state.SetItemsProcessed(state.iterations() * table.summary.size());
+}
+
+/* Text in, summarized text out, as acrs-demo runs */
+template <class F> static void BM_EndToEnd(benchmark::State & state,
+                                           Shape shape)
+{
+    const Table<F> & table = getTable<F>(shape);
+
+    for (auto _ : state)
+    {
+        std::vector<typename F::Cidr> cidrs;
+        typename Table<F>::RouteList rt_list;
+        Acrs::Acrs summary;
+
+        parseText<F>(table.text, cidrs);
+        construct<F>(cidrs, rt_list);
+        summary.summarize(rt_list);
+        writeRoutes(rt_list);
+    }
+
+    state.SetItemsProcessed(state.iterations() * table.cidrs.size());
+    state.SetBytesProcessed(state.iterations() * table.text.size());
+}
+
+/* Register every stage for each shape, named FAMILY/SHAPE/STAGE so one
+ * table or one stage can be picked out with --benchmark_filter
+ */
+template <class F> static void addBenchmarks(const char * p_family)
+{
+    std::vector<benchmark::internal::Benchmark *> added;
+
+    for (size_t i = 0; i < NUM_SHAPES; i++)
+    {
+        Shape shape = SHAPES[i].shape;
+        std::string prefix = std::string(p_family) + "/" +
+                             SHAPES[i].p_name + "/";
+
+        added.push_back(benchmark::RegisterBenchmark(
+            (prefix + "parse").c_str(), BM_Parse<F>, shape));
+        added.push_back(benchmark::RegisterBenchmark(
+            (prefix + "construct").c_str(), BM_Construct<F>, shape));
+        added.push_back(benchmark::RegisterBenchmark(
+            (prefix + "sort_acrs_cmp").c_str(), BM_SortCmp<F>, shape,
+            Acrs::ORDER_ACRS));
+        added.push_back(benchmark::RegisterBenchmark(
+            (prefix + "sort_overlap_cmp").c_str(), BM_SortCmp<F>, shape,
+            Acrs::ORDER_OVERLAP));
+        added.push_back(benchmark::RegisterBenchmark(
+            (prefix + "sort_acrs_radix").c_str(), BM_SortRadix<F>, shape,
+            Acrs::ORDER_ACRS));
+        added.push_back(benchmark::RegisterBenchmark(
+            (prefix + "sort_overlap_radix").c_str(), BM_SortRadix<F>, shape,
+            Acrs::ORDER_OVERLAP));
+        added.push_back(benchmark::RegisterBenchmark(
+            (prefix + "summarize_main").c_str(), BM_Phase<F>, shape,
+            Acrs::Stats::PHASE_MERGE)->UseManualTime());
+        added.push_back(benchmark::RegisterBenchmark(
+            (prefix + "summarize_overlap").c_str(), BM_Phase<F>, shape,
+            Acrs::Stats::PHASE_OVERLAP)->UseManualTime());
+        added.push_back(benchmark::RegisterBenchmark(
+            (prefix + "summarize").c_str(), BM_Summarize<F>, shape));
+        added.push_back(benchmark::RegisterBenchmark(
+            (prefix + "output").c_str(), BM_Output<F>, shape));
+        added.push_back(benchmark::RegisterBenchmark(
+            (prefix + "end_to_end").c_str(), BM_EndToEnd<F>, shape));
+    }
+
+    for (size_t i = 0; i < added.size(); i++)
+    {
+        added[i]->Unit(benchmark::kMillisecond);
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    benchmark::Initialize(&argc, argv);
+
+    if (benchmark::ReportUnrecognizedArguments(argc, argv) == true)
+    {
+        return 1;
+    }
+
+    addBenchmarks<Family4>("v4");
+    addBenchmarks<Family6>("v6");
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return 0;
+}
@@ -0,0 +1,227 @@
+/* sort-bench.cpp -- Comparator sort vs. packed-key radix sort
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <list>
+#include <map>
+#include <vector>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "../acrs.hpp"
+#include "../route4.hpp"
+#include "../route6.hpp"
+#include "../route4packed.hpp"
+#include "../route6packed.hpp"
+#include "../routegen.hpp"
+
+#define NUM_ROUTES 1000000
+#define NUM_METRICS 4
+
+#define TABLE_SEED 1
+
+typedef IP::RouteGenerator::Shape Shape;
+
+/* What differs between the address families */
+struct Family4
+{
+    typedef IP::Route4 Route;
+    typedef IP::Route4Packed Packed;
+};
+
+struct Family6
+{
+    typedef IP::Route6 Route;
+    typedef IP::Route6Packed Packed;
+};
+
+/* One generated table, in random order, as full routes in a list and
+ * packed routes in a vector
+ */
+template <class F> struct Table
+{
+    std::list<typename F::Route> routes;
+    std::vector<typename F::Packed> packed;
+};
+
+static const struct
+{
+    Shape shape;
+    const char * p_name;
+} SHAPES[] =
+{
+    {IP::RouteGenerator::SHAPE_FULL, "full"},
+    {IP::RouteGenerator::SHAPE_SIBLINGS, "siblings"},
+    {IP::RouteGenerator::SHAPE_NESTED, "nested"}
+};
+
+#define NUM_SHAPES (sizeof(SHAPES) / sizeof(SHAPES[0]))
+
+template <class F> static const Table<F> & getTable(Shape shape)
+{
+    static std::map<Shape, Table<F> > tables;
+
+    typename std::map<Shape, Table<F> >::iterator found = tables.find(shape);
+
+    if (found != tables.end())
+    {
+        return found->second;
+    }
+
+    Table<F> & table = tables[shape];
+    IP::RouteGenerator generator;
+
+    generator.setShape(shape);
+    generator.setSeed(TABLE_SEED);
+    generator.setMetrics(NUM_METRICS);
+    generator.setShuffle(true);
+    generator.generate(NUM_ROUTES, table.packed);
+
+    for (size_t i = 0; i < table.packed.size(); i++)
+    {
+        table.routes.push_back(table.packed[i].toRoute());
+    }
+
+    return table;
+}
+
+/* std::list::sort() with the comparator for the order */
+template <class F> static void BM_SortCmp(benchmark::State & state,
+                                          Shape shape, Acrs::SortOrder order)
+{
+    const Table<F> & table = getTable<F>(shape);
+    std::list<typename F::Route> rt_list;
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        rt_list = table.routes;
+        state.ResumeTiming();
+
+        if (order == Acrs::ORDER_ACRS)
+        {
+            rt_list.sort(Acrs::Acrs::acrsCmp<typename F::Route>);
+        }
+        else
+        {
+            rt_list.sort(Acrs::Acrs::overlapCmp<typename F::Route>);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * table.routes.size());
+}
+
+/* radixSort() relinking the list */
+template <class F> static void BM_SortRadix(benchmark::State & state,
+                                            Shape shape, Acrs::SortOrder order)
+{
+    const Table<F> & table = getTable<F>(shape);
+    std::list<typename F::Route> rt_list;
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        rt_list = table.routes;
+        state.ResumeTiming();
+
+        Acrs::radixSort(rt_list, order);
+    }
+
+    state.SetItemsProcessed(state.iterations() * table.routes.size());
+}
+
+/* radixSortRange() permuting the packed vector in place */
+template <class F> static void BM_SortRadixPacked(benchmark::State & state,
+                                                  Shape shape,
+                                                  Acrs::SortOrder order)
+{
+    const Table<F> & table = getTable<F>(shape);
+    std::vector<typename F::Packed> rt_vector;
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        rt_vector = table.packed;
+        state.ResumeTiming();
+
+        Acrs::radixSortRange(rt_vector.begin(), rt_vector.end(), order);
+    }
+
+    state.SetItemsProcessed(state.iterations() * table.packed.size());
+}
+
+/* Register every sort for each shape and order, named
+ * FAMILY/SHAPE/SORT_ORDER so one table or one sort can be picked out
+ * with --benchmark_filter
+ */
+template <class F> static void addBenchmarks(const char * p_family)
+{
+    static const struct
+    {
+        Acrs::SortOrder order;
+        const char * p_name;
+    } ORDERS[] =
+    {
+        {Acrs::ORDER_ACRS, "acrs"},
+        {Acrs::ORDER_OVERLAP, "overlap"}
+    };
+
+    std::vector<benchmark::internal::Benchmark *> added;
+
+    for (size_t i = 0; i < NUM_SHAPES; i++)
+    {
+        for (size_t j = 0; j < sizeof(ORDERS) / sizeof(ORDERS[0]); j++)
+        {
+            Shape shape = SHAPES[i].shape;
+            Acrs::SortOrder order = ORDERS[j].order;
+            std::string prefix = std::string(p_family) + "/" +
+                                 SHAPES[i].p_name + "/sort_" +
+                                 ORDERS[j].p_name + "_";
+
+            added.push_back(benchmark::RegisterBenchmark(
+                (prefix + "cmp").c_str(), BM_SortCmp<F>, shape, order));
+            added.push_back(benchmark::RegisterBenchmark(
+                (prefix + "radix").c_str(), BM_SortRadix<F>, shape, order));
+            added.push_back(benchmark::RegisterBenchmark(
+                (prefix + "radix_packed").c_str(), BM_SortRadixPacked<F>,
+                shape, order));
+        }
+    }
+
+    for (size_t i = 0; i < added.size(); i++)
+    {
+        added[i]->Unit(benchmark::kMillisecond);
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    benchmark::Initialize(&argc, argv);
+
+    if (benchmark::ReportUnrecognizedArguments(argc, argv) == true)
+    {
+        return 1;
+    }
+
+    addBenchmarks<Family4>("v4");
+    addBenchmarks<Family6>("v6");
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return 0;
+}
@@ -0,0 +1,419 @@
+/* cidrparse.cpp -- Allocation-free parser for ADDR/PLEN[mMETRIC] text
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <inttypes.h>
+
+#include "route.hpp"
+#include "cidrparse.hpp"
+
+namespace IP
+{
+    enum
+    {
+        MAX_PLEN4 = 32,
+        MAX_PLEN6 = 128
+    };
+
+    static bool fail(ParseError & err, size_t offset, const char * reason)
+    {
+        err.offset = offset;
+        err.reason = reason;
+
+        return false;
+    }
+
+    static bool isDigit(char c)
+    {
+        return (unsigned char) (c - '0') < 10;
+    }
+
+    /* Value of a hex digit, or -1 */
+    static int hexValue(char c)
+    {
+        if (isDigit(c) == true)
+        {
+            return c - '0';
+        }
+
+        /* Folding to lower case leaves only 'a' to 'f' in range */
+        unsigned char lower = (c | 0x20) - 'a';
+
+        return (lower < 6) ? lower + 10 : -1;
+    }
+
+    /* Parse the dotted quad in text[pos, end) into a host order value */
+    static bool parseQuad(const char * text, size_t pos, size_t end,
+                          uint32_t & value, ParseError & err)
+    {
+        uint32_t result = 0;
+
+        for (int octet = 0; octet < 4; octet++)
+        {
+            if (octet > 0)
+            {
+                if (pos == end)
+                {
+                    return fail(err, pos, "address has fewer than 4 octets");
+                }
+
+                if (text[pos] != '.')
+                {
+                    return fail(err, pos, "unexpected character in address");
+                }
+
+                pos++;
+            }
+
+            size_t start = pos;
+            uint32_t n = 0;
+
+            while (pos < end && pos - start < 3 && isDigit(text[pos]) == true)
+            {
+                n = n * 10 + (text[pos] - '0');
+                pos++;
+            }
+
+            if (pos == start)
+            {
+                return fail(err, pos, "expected a decimal octet");
+            }
+
+            if (pos < end && isDigit(text[pos]) == true)
+            {
+                return fail(err, start, "octet has more than 3 digits");
+            }
+
+            if (text[start] == '0' && pos - start > 1)
+            {
+                return fail(err, start, "octet has a leading zero");
+            }
+
+            if (n > 255)
+            {
+                return fail(err, start, "octet is greater than 255");
+            }
+
+            result = (result << 8) | n;
+        }
+
+        if (pos != end)
+        {
+            return fail(err, pos, (text[pos] == '.') ?
+                                  "address has more than 4 octets" :
+                                  "unexpected character in address");
+        }
+
+        value = result;
+
+        return true;
+    }
+
+    /* Parse decimal digits at text[pos], leaving pos after them. Values
+     * over 'max' are refused without risk of overflow.
+     */
+    static bool parseNumber(const char * text, size_t len, size_t & pos,
+                            uint32_t max, uint32_t & value, ParseError & err,
+                            const char * missing, const char * too_big)
+    {
+        size_t start = pos;
+        uint32_t n = 0;
+
+        while (pos < len && isDigit(text[pos]) == true)
+        {
+            if (n <= max)
+            {
+                n = n * 10 + (text[pos] - '0');
+            }
+
+            pos++;
+        }
+
+        if (pos == start)
+        {
+            return fail(err, pos, missing);
+        }
+
+        if (n > max)
+        {
+            return fail(err, start, too_big);
+        }
+
+        value = n;
+
+        return true;
+    }
+
+    /* Find the '/' that ends the address */
+    static bool findSlash(const char * text, size_t len, size_t & slash,
+                          ParseError & err)
+    {
+        const char * p_slash = (const char *) memchr(text, '/', len);
+
+        if (p_slash == 0)
+        {
+            return fail(err, len, "missing '/' and prefix length");
+        }
+
+        slash = p_slash - text;
+
+        if (slash == 0)
+        {
+            return fail(err, 0, "missing address");
+        }
+
+        return true;
+    }
+
+    /* Parse the prefix length and optional metric after the '/' */
+    static bool parseSuffix(const char * text, size_t len, size_t slash,
+                            uint32_t max_plen, uint32_t & plen, int & metric,
+                            ParseError & err)
+    {
+        size_t pos = slash + 1;
+
+        if (parseNumber(text, len, pos, max_plen, plen, err,
+                        "missing prefix length",
+                        "prefix length out of range") == false)
+        {
+            return false;
+        }
+
+        metric = 0;
+
+        if (pos == len)
+        {
+            return true;
+        }
+
+        if (text[pos] != 'm')
+        {
+            return fail(err, pos, (text[pos] == '/') ?
+                                  "extra '/'" :
+                                  "unexpected character after prefix length");
+        }
+
+        pos++;
+        uint32_t value;
+
+        if (parseNumber(text, len, pos, Route::MAX_METRIC, value, err,
+                        "missing metric after 'm'",
+                        "metric out of range") == false)
+        {
+            return false;
+        }
+
+        if (pos != len)
+        {
+            return fail(err, pos, "unexpected character after metric");
+        }
+
+        metric = value;
+
+        return true;
+    }
+
+    bool parseAddr4(const char * text, size_t len, in_addr_t & addr,
+                    ParseError & err)
+    {
+        uint32_t value;
+
+        if (parseQuad(text, 0, len, value, err) == false)
+        {
+            return false;
+        }
+
+        addr = htonl(value);
+
+        return true;
+    }
+
+    bool parseAddr6(const char * text, size_t len, in6_addr & addr,
+                    ParseError & err)
+    {
+        uint8_t * bytes = addr.s6_addr;
+        size_t filled = 0;          /* Bytes written so far */
+        int gap = -1;               /* Where "::" was, in bytes */
+        size_t pos = 0;
+
+        if (len == 0)
+        {
+            return fail(err, 0, "missing address");
+        }
+
+        if (text[0] == ':')
+        {
+            if (len < 2 || text[1] != ':')
+            {
+                return fail(err, 0, "address starts with a single ':'");
+            }
+
+            pos++;
+        }
+
+        size_t group = pos;
+        uint32_t value = 0;
+        int digits = 0;
+
+        while (pos < len)
+        {
+            char c = text[pos];
+            int hex = hexValue(c);
+
+            if (hex >= 0)
+            {
+                if (digits == 4)
+                {
+                    return fail(err, group, "group has more than 4 digits");
+                }
+
+                value = (value << 4) | hex;
+                digits++;
+                pos++;
+                continue;
+            }
+
+            if (c == ':')
+            {
+                if (digits == 0)
+                {
+                    if (gap >= 0)
+                    {
+                        return fail(err, pos, "address has more than one "
+                                              "'::'");
+                    }
+
+                    gap = filled;
+                }
+                else
+                {
+                    if (pos + 1 == len)
+                    {
+                        return fail(err, pos, "address ends with a single "
+                                              "':'");
+                    }
+
+                    if (filled == 16)
+                    {
+                        return fail(err, group, "address has more than 8 "
+                                                "groups");
+                    }
+
+                    bytes[filled++] = value >> 8;
+                    bytes[filled++] = value & 0xff;
+                    value = 0;
+                    digits = 0;
+                }
+
+                pos++;
+                group = pos;
+                continue;
+            }
+
+            if (c == '.')
+            {
+                /* The group being read is the start of a dotted quad */
+                uint32_t quad;
+
+                if (filled > 12)
+                {
+                    return fail(err, group, "no room for an IPv4 tail");
+                }
+
+                if (parseQuad(text, group, len, quad, err) == false)
+                {
+                    return false;
+                }
+
+                bytes[filled++] = quad >> 24;
+                bytes[filled++] = (quad >> 16) & 0xff;
+                bytes[filled++] = (quad >> 8) & 0xff;
+                bytes[filled++] = quad & 0xff;
+                digits = 0;
+                pos = len;
+                break;
+            }
+
+            return fail(err, pos, "unexpected character in address");
+        }
+
+        if (digits > 0)
+        {
+            if (filled == 16)
+            {
+                return fail(err, group, "address has more than 8 groups");
+            }
+
+            bytes[filled++] = value >> 8;
+            bytes[filled++] = value & 0xff;
+        }
+
+        if (gap >= 0)
+        {
+            if (filled == 16)
+            {
+                return fail(err, len, "'::' does not stand for any groups");
+            }
+
+            /* Move what followed "::" to the end and zero the gap */
+            size_t tail = filled - gap;
+            memmove(bytes + 16 - tail, bytes + gap, tail);
+            memset(bytes + gap, 0, 16 - filled);
+            filled = 16;
+        }
+
+        if (filled != 16)
+        {
+            return fail(err, len, "address has fewer than 8 groups");
+        }
+
+        return true;
+    }
+
+    bool parseCidr4(const char * text, size_t len, Cidr4 & cidr,
+                    ParseError & err)
+    {
+        size_t slash;
+
+        if (findSlash(text, len, slash, err) == false ||
+            parseAddr4(text, slash, cidr.addr, err) == false)
+        {
+            return false;
+        }
+
+        return parseSuffix(text, len, slash, MAX_PLEN4, cidr.plen,
+                           cidr.metric, err);
+    }
+
+    bool parseCidr6(const char * text, size_t len, Cidr6 & cidr,
+                    ParseError & err)
+    {
+        size_t slash;
+
+        if (findSlash(text, len, slash, err) == false ||
+            parseAddr6(text, slash, cidr.addr, err) == false)
+        {
+            return false;
+        }
+
+        return parseSuffix(text, len, slash, MAX_PLEN6, cidr.plen,
+                           cidr.metric, err);
+    }
+}
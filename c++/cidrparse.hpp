@@ -0,0 +1,76 @@
+/* cidrparse.hpp -- Allocation-free parser for ADDR/PLEN[mMETRIC] text
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CIDRPARSE_H
+#define CIDRPARSE_H
+
+#include <stddef.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <inttypes.h>
+
+namespace IP
+{
+    /* Why parsing failed, and the byte offset into the text where the
+     * problem was found
+     */
+    struct ParseError
+    {
+        size_t offset;
+        const char * reason;
+    };
+
+    /* A parsed IPv4 prefix. The address is in network byte order and
+     * keeps any host bits it was given with.
+     */
+    struct Cidr4
+    {
+        in_addr_t addr;
+        uint32_t plen;
+        int metric;         /* 0 if none was given */
+    };
+
+    /* A parsed IPv6 prefix, as above */
+    struct Cidr6
+    {
+        in6_addr addr;
+        uint32_t plen;
+        int metric;
+    };
+
+    /* Parse an address alone, with the same rules as inet_pton(): four
+     * decimal octets without leading zeros for IPv4, and hex groups with
+     * at most one "::" and an optional dotted quad tail for IPv6. The
+     * text is 'len' bytes long and need not be NUL-terminated.
+     */
+    bool parseAddr4(const char * text, size_t len, in_addr_t & addr,
+                    ParseError & err);
+    bool parseAddr6(const char * text, size_t len, in6_addr & addr,
+                    ParseError & err);
+
+    /* Parse ADDR/PLEN[mMETRIC]. The prefix length must fit the address
+     * family and the metric must be within Route's limits. Nothing is
+     * allocated and no locale or libc parsing routines are used.
+     */
+    bool parseCidr4(const char * text, size_t len, Cidr4 & cidr,
+                    ParseError & err);
+    bool parseCidr6(const char * text, size_t len, Cidr6 & cidr,
+                    ParseError & err);
+}
+
+#endif /* CIDRPARSE_H */
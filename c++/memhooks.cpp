@@ -0,0 +1,100 @@
+/* memhooks.cpp -- Counting replacements for operator new and delete
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Link this file in to let Acrs::MemProfile count allocations. While
+ * counting is enabled, every allocation through operator new is added to
+ * Acrs::allocCounters(). Memory comes from malloc() as before.
+ */
+
+#include <new>
+#include <cstdlib>
+
+#include "acrsmem.hpp"
+
+static bool s_hooked = (Acrs::allocCounters().hooked = true);
+
+static void * countedAlloc(size_t size)
+{
+    Acrs::AllocCounters & counters = Acrs::allocCounters();
+
+    if (counters.enabled.load(std::memory_order_relaxed) == true)
+    {
+        counters.count(size);
+    }
+
+    return malloc((size == 0) ? 1 : size);
+}
+
+static void countedFree(void * p)
+{
+    Acrs::AllocCounters & counters = Acrs::allocCounters();
+
+    if (p != NULL && counters.enabled.load(std::memory_order_relaxed) == true)
+    {
+        counters.frees.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    free(p);
+}
+
+void * operator new(size_t size)
+{
+    void * p = countedAlloc(size);
+
+    if (p == NULL)
+    {
+        throw std::bad_alloc();
+    }
+
+    return p;
+}
+
+void * operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void * operator new(size_t size, const std::nothrow_t &) throw()
+{
+    return countedAlloc(size);
+}
+
+void * operator new[](size_t size, const std::nothrow_t &) throw()
+{
+    return countedAlloc(size);
+}
+
+void operator delete(void * p) throw()
+{
+    countedFree(p);
+}
+
+void operator delete[](void * p) throw()
+{
+    countedFree(p);
+}
+
+void operator delete(void * p, const std::nothrow_t &) throw()
+{
+    countedFree(p);
+}
+
+void operator delete[](void * p, const std::nothrow_t &) throw()
+{
+    countedFree(p);
+}
@@ -0,0 +1,418 @@
+/* mrtreader.cpp -- Streaming reader for MRT TABLE_DUMP_V2 RIB dumps
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "route.hpp"
+#include "mrtreader.hpp"
+
+namespace IP
+{
+    enum
+    {
+        MRT_TABLE_DUMP_V2 = 13
+    };
+
+    /* TABLE_DUMP_V2 subtypes (RFC 6396 4.3, RFC 8050) */
+    enum
+    {
+        RIB_IPV4_UNICAST = 2,
+        RIB_IPV6_UNICAST = 4,
+        RIB_GENERIC = 6,
+        RIB_IPV4_UNICAST_ADDPATH = 8,
+        RIB_IPV6_UNICAST_ADDPATH = 10,
+        RIB_GENERIC_ADDPATH = 12
+    };
+
+    /* BGP path attributes (RFC 4271 4.3) */
+    enum
+    {
+        ATTR_EXTENDED_LENGTH = 0x10,
+        ATTR_AS_PATH = 2,
+        ATTR_MED = 4,
+        AS_SET = 1,
+        AS_SEQUENCE = 2
+    };
+
+    enum
+    {
+        AFI_IPV4 = 1,
+        AFI_IPV6 = 2,
+        SAFI_UNICAST = 1
+    };
+
+    /* Bounds checked reads of big endian fields through a record */
+    struct MrtCursor
+    {
+        const uint8_t * p;
+        const uint8_t * p_end;
+
+        bool has(size_t n) const
+        {
+            return (size_t) (p_end - p) >= n;
+        };
+
+        uint8_t get8()
+        {
+            return *p++;
+        };
+
+        uint16_t get16()
+        {
+            uint16_t value = (p[0] << 8) | p[1];
+            p += 2;
+
+            return value;
+        };
+
+        uint32_t get32()
+        {
+            uint32_t value = ((uint32_t) p[0] << 24) | (p[1] << 16) |
+                             (p[2] << 8) | p[3];
+            p += 4;
+
+            return value;
+        };
+    };
+
+    bool MrtReader::fail(const char * p_error)
+    {
+        m_error = p_error;
+
+        return false;
+    }
+
+    bool MrtReader::fill(size_t need)
+    {
+        if (m_end - m_pos >= need)
+        {
+            return true;
+        }
+
+        if (m_pos > 0)
+        {
+            memmove(&m_buffer[0], &m_buffer[m_pos], m_end - m_pos);
+            m_offset += m_pos;
+            m_end -= m_pos;
+            m_pos = 0;
+        }
+
+        if (need > m_buffer.size())
+        {
+            m_buffer.resize(need);
+        }
+
+        while (m_end < need)
+        {
+            ssize_t got = read(m_fd, &m_buffer[m_end],
+                               m_buffer.size() - m_end);
+
+            if (got < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                return fail(strerror(errno));
+            }
+            else if (got == 0)
+            {
+                return false;
+            }
+
+            m_end += got;
+        }
+
+        return true;
+    }
+
+    bool MrtReader::entryMetric(const uint8_t * p_attrs, size_t len,
+                                uint32_t & metric)
+    {
+        MrtCursor attrs = { p_attrs, p_attrs + len };
+        metric = 0;
+
+        while (attrs.p < attrs.p_end)
+        {
+            if (attrs.has(3) == false)
+            {
+                return false;
+            }
+
+            uint8_t flags = attrs.get8();
+            uint8_t type = attrs.get8();
+            size_t attr_len;
+
+            if ((flags & ATTR_EXTENDED_LENGTH) != 0)
+            {
+                if (attrs.has(2) == false)
+                {
+                    return false;
+                }
+
+                attr_len = attrs.get16();
+            }
+            else
+            {
+                attr_len = attrs.get8();
+            }
+
+            if (attrs.has(attr_len) == false)
+            {
+                return false;
+            }
+
+            MrtCursor value = { attrs.p, attrs.p + attr_len };
+            attrs.p += attr_len;
+
+            if (m_source == METRIC_MED && type == ATTR_MED)
+            {
+                if (attr_len != 4)
+                {
+                    return false;
+                }
+
+                metric = value.get32();
+            }
+            else if (m_source == METRIC_AS_PATH && type == ATTR_AS_PATH)
+            {
+                /* TABLE_DUMP_V2 always uses four byte AS numbers. A set
+                 * counts as one AS, confederation segments as none, as
+                 * in BGP best path selection.
+                 */
+                while (value.p < value.p_end)
+                {
+                    if (value.has(2) == false)
+                    {
+                        return false;
+                    }
+
+                    uint8_t seg_type = value.get8();
+                    uint8_t seg_count = value.get8();
+
+                    if (value.has(seg_count * 4) == false)
+                    {
+                        return false;
+                    }
+
+                    value.p += seg_count * 4;
+
+                    if (seg_type == AS_SEQUENCE)
+                    {
+                        metric += seg_count;
+                    }
+                    else if (seg_type == AS_SET)
+                    {
+                        metric += 1;
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool MrtReader::nextRib(int family, uint8_t * p_addr, uint32_t & plen,
+                            int & metric)
+    {
+        while (fill(HEADER_SIZE) == true)
+        {
+            const uint8_t * p_record = &m_buffer[m_pos];
+            MrtCursor header = { p_record, p_record + HEADER_SIZE };
+            header.get32();         /* Timestamp */
+            uint16_t type = header.get16();
+            uint16_t subtype = header.get16();
+            uint32_t length = header.get32();
+
+            m_record_offset = m_offset + m_pos;
+
+            if (length > MAX_RECORD)
+            {
+                return fail("record too long");
+            }
+
+            if (fill(HEADER_SIZE + length) == false)
+            {
+                return failed() ? false : fail("truncated record");
+            }
+
+            MrtCursor rec = { &m_buffer[m_pos] + HEADER_SIZE,
+                           &m_buffer[m_pos] + HEADER_SIZE + length };
+            m_pos += HEADER_SIZE + length;
+            m_records++;
+
+            if (type != MRT_TABLE_DUMP_V2)
+            {
+                continue;
+            }
+
+            int rec_family;
+            bool addpath = (subtype == RIB_IPV4_UNICAST_ADDPATH ||
+                            subtype == RIB_IPV6_UNICAST_ADDPATH ||
+                            subtype == RIB_GENERIC_ADDPATH);
+
+            if (rec.has(4) == false)
+            {
+                return fail("truncated RIB entry");
+            }
+
+            rec.get32();            /* Sequence number */
+
+            if (subtype == RIB_IPV4_UNICAST ||
+                subtype == RIB_IPV4_UNICAST_ADDPATH)
+            {
+                rec_family = 4;
+            }
+            else if (subtype == RIB_IPV6_UNICAST ||
+                     subtype == RIB_IPV6_UNICAST_ADDPATH)
+            {
+                rec_family = 6;
+            }
+            else if (subtype == RIB_GENERIC || subtype == RIB_GENERIC_ADDPATH)
+            {
+                if (rec.has(3) == false)
+                {
+                    return fail("truncated RIB entry");
+                }
+
+                uint16_t afi = rec.get16();
+                uint8_t safi = rec.get8();
+
+                if (safi != SAFI_UNICAST ||
+                    (afi != AFI_IPV4 && afi != AFI_IPV6))
+                {
+                    continue;
+                }
+
+                rec_family = (afi == AFI_IPV4) ? 4 : 6;
+            }
+            else
+            {
+                continue;
+            }
+
+            if (rec_family != family)
+            {
+                continue;
+            }
+
+            size_t addr_size = (family == 4) ? 4 : 16;
+
+            if (rec.has(1) == false)
+            {
+                return fail("truncated RIB entry");
+            }
+
+            plen = rec.get8();
+
+            if (plen > addr_size * 8)
+            {
+                return fail("prefix length out of range");
+            }
+
+            size_t prefix_bytes = (plen + 7) / 8;
+
+            if (rec.has(prefix_bytes + 2) == false)
+            {
+                return fail("truncated RIB entry");
+            }
+
+            memset(p_addr, 0, addr_size);
+            memcpy(p_addr, rec.p, prefix_bytes);
+            rec.p += prefix_bytes;
+
+            uint16_t entries = rec.get16();
+            uint32_t best = Route::MAX_METRIC;
+
+            if (entries == 0)
+            {
+                continue;
+            }
+
+            for (uint16_t i = 0; i < entries && m_source != METRIC_NONE; i++)
+            {
+                /* Peer index, originated time and any path identifier */
+                size_t skip = addpath ? 10 : 6;
+
+                if (rec.has(skip + 2) == false)
+                {
+                    return fail("truncated RIB entry");
+                }
+
+                rec.p += skip;
+                uint16_t attr_len = rec.get16();
+                uint32_t value;
+
+                if (rec.has(attr_len) == false ||
+                    entryMetric(rec.p, attr_len, value) == false)
+                {
+                    return fail("malformed path attributes");
+                }
+
+                rec.p += attr_len;
+
+                if (value < best)
+                {
+                    best = value;
+                }
+            }
+
+            metric = (m_source == METRIC_NONE) ? 0 : best;
+
+            return true;
+        }
+
+        if (failed() == false && m_end > m_pos)
+        {
+            m_record_offset = m_offset + m_pos;
+            fail("truncated record header");
+        }
+
+        return false;
+    }
+
+    bool MrtReader::next(Cidr4 & cidr)
+    {
+        uint8_t addr[4];
+
+        if (nextRib(4, addr, cidr.plen, cidr.metric) == false)
+        {
+            return false;
+        }
+
+        memcpy(&cidr.addr, addr, sizeof(addr));
+
+        return true;
+    }
+
+    bool MrtReader::next(Cidr6 & cidr)
+    {
+        return nextRib(6, cidr.addr.s6_addr, cidr.plen, cidr.metric);
+    }
+
+    MrtReader::MrtReader(int fd, MetricSource source)
+                :
+                m_fd(fd), m_source(source), m_buffer(BUFFER_SIZE), m_pos(0),
+                m_end(0), m_offset(0), m_record_offset(0), m_records(0),
+                m_error(NULL)
+    {
+    }
+}
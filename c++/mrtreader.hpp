@@ -0,0 +1,114 @@
+/* mrtreader.hpp -- Streaming reader for MRT TABLE_DUMP_V2 RIB dumps
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MRTREADER_H
+#define MRTREADER_H
+
+#include <vector>
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#include "cidrparse.hpp"
+
+namespace IP
+{
+    /* Reads the unicast RIB entries of an MRT dump (RFC 6396) from a file
+     * descriptor, one prefix at a time. Records are read into a buffer
+     * that only grows to hold the largest record, so memory use does not
+     * depend on the size of the dump.
+     *
+     * Records other than TABLE_DUMP_V2 RIB_IPV4_UNICAST, RIB_IPV6_UNICAST,
+     * their ADDPATH forms (RFC 8050) and RIB_GENERIC unicast are skipped,
+     * as are prefixes of the family not asked for. A prefix seen from
+     * several peers is given once, with the lowest metric of its entries.
+     * Compressed dumps must be decompressed first, e.g. through a pipe.
+     */
+    class MrtReader
+    {
+        public:
+            /* What the metric of each prefix is taken from. Values above
+             * Route::MAX_METRIC are clamped to it.
+             */
+            enum MetricSource
+            {
+                METRIC_NONE,        /* Always 0 */
+                METRIC_MED,         /* MULTI_EXIT_DISC, 0 if absent */
+                METRIC_AS_PATH      /* AS_PATH length, sets counting 1 */
+            };
+
+            enum
+            {
+                BUFFER_SIZE = 1024 * 1024,
+                HEADER_SIZE = 12,
+                MAX_RECORD = 64 * 1024 * 1024
+            };
+
+            /* The next prefix of the family, with its address in network
+             * byte order. Returns false at the end of the dump or on an
+             * error, which failed() tells apart.
+             */
+            bool next(Cidr4 & cidr);
+            bool next(Cidr6 & cidr);
+
+            bool failed() const { return m_error != NULL; };
+            const char * getError() const { return m_error; };
+
+            /* File offset of the last record read, or of the problem if
+             * reading failed
+             */
+            uint64_t getOffset() const { return m_record_offset; };
+
+            /* MRT records read so far, of any type */
+            uint64_t getRecords() const { return m_records; };
+
+            /* Constructor */
+            MrtReader(int fd, MetricSource source);
+
+        private:
+            int m_fd;
+            MetricSource m_source;
+            std::vector<uint8_t> m_buffer;
+            size_t m_pos;               /* Start of unread data */
+            size_t m_end;               /* End of data in the buffer */
+            uint64_t m_offset;          /* File offset of m_buffer[0] */
+            uint64_t m_record_offset;
+            uint64_t m_records;
+            const char * m_error;
+
+            /* Have at least 'need' unread bytes buffered. Returns false
+             * if the file ends (or a read fails) first.
+             */
+            bool fill(size_t need);
+
+            /* The next RIB record for 'family', its prefix and the
+             * metric of its entries. Returns false at the end or on an
+             * error.
+             */
+            bool nextRib(int family, uint8_t * p_addr, uint32_t & plen,
+                         int & metric);
+
+            /* Metric of one RIB entry from its path attributes */
+            bool entryMetric(const uint8_t * p_attrs, size_t len,
+                             uint32_t & metric);
+
+            bool fail(const char * p_error);
+    };
+}
+
+#endif /* MRTREADER_H */
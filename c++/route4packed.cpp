@@ -0,0 +1,136 @@
+/* route4packed.cpp -- Compact IPv4 route value type
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <sstream>
+#include <type_traits>
+
+#include <arpa/inet.h>
+#include <inttypes.h>
+
+#include "route.hpp"
+#include "route4.hpp"
+#include "route4packed.hpp"
+
+namespace IP
+{
+    static_assert(sizeof(Route4Packed) == 8,
+                  "Route4Packed should be 8 bytes");
+    static_assert(std::is_trivially_copyable<Route4Packed>::value,
+                  "Route4Packed should be trivially copyable");
+
+    bool Route4Packed::setPlen(const uint32_t plen)
+    {
+        if (plen > MAX_PLEN)
+        {
+            return false;
+        }
+
+        m_plen = plen;
+        return true;
+    }
+
+    bool Route4Packed::setMetric(const int metric)
+    {
+        if (metric < Route::MIN_METRIC || metric > Route::MAX_METRIC)
+        {
+            return false;
+        }
+
+        m_metric = metric;
+        return true;
+    }
+
+    Addr4NetForm Route4Packed::getAddrN() const
+    {
+        return Addr4NetForm(htonl(m_addr));
+    }
+
+    Addr4NetForm Route4Packed::getMaskN() const
+    {
+        return Addr4NetForm(htonl(maskH()));
+    }
+
+    Addr4NetForm Route4Packed::getNetworkN() const
+    {
+        return Addr4NetForm(htonl(getNetworkH()));
+    }
+
+    Addr4NetForm Route4Packed::getBroadcastN() const
+    {
+        return Addr4NetForm(htonl(m_addr | ~maskH()));
+    }
+
+    Addr4NetForm Route4Packed::getHostmaskN() const
+    {
+        return Addr4NetForm(htonl(~maskH()));
+    }
+
+    std::string Route4Packed::getAddrP() const
+    {
+        char buf[INET_ADDRSTRLEN];
+        in_addr_t addr = htonl(m_addr);
+
+        inet_ntop(AF_INET, &addr, buf, sizeof(buf));
+
+        return std::string(buf);
+    }
+
+    std::string Route4Packed::getNetworkP() const
+    {
+        char buf[INET_ADDRSTRLEN];
+        in_addr_t addr = htonl(getNetworkH());
+
+        inet_ntop(AF_INET, &addr, buf, sizeof(buf));
+
+        return std::string(buf);
+    }
+
+    /* Same format as Route::str() */
+    std::string Route4Packed::str() const
+    {
+        std::stringstream ss;
+        ss << getNetworkP() << "/" << getPlen() << " in " << getMetric();
+
+        return ss.str();
+    }
+
+    Route4 Route4Packed::toRoute() const
+    {
+        return Route4(htonl(m_addr), getPlen(), PLEN, getMetric());
+    }
+
+    Route4Packed::Route4Packed(const in_addr_t addr, const uint32_t plen,
+                               const int metric)
+                               :
+                               m_addr(ntohl(addr)), m_metric(0), m_plen(0),
+                               m_reserved(0)
+    {
+        setPlen(plen);
+        setMetric(metric);
+    }
+
+    Route4Packed::Route4Packed(const Route4 & rt)
+                               :
+                               m_addr(ntohl(rt.getAddrN().getAddr())),
+                               m_metric(0), m_plen(0), m_reserved(0)
+    {
+        setPlen(rt.getPlen());
+        setMetric(rt.getMetric());
+    }
+}
@@ -0,0 +1,97 @@
+/* route4packed.hpp -- Compact IPv4 route value type
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IPROUTE4PACKED_H
+#define IPROUTE4PACKED_H
+
+#include <string>
+
+#include <arpa/inet.h>
+#include <inttypes.h>
+
+#include "addr4netform.hpp"
+#include "route4.hpp"
+
+namespace IP
+{
+    /* An IPv4 route in 8 bytes: address, prefix length and metric, with
+     * no vtable, no strings and no validity flags. It is trivially
+     * copyable, so tables can be held in flat arrays and moved with
+     * memcpy(). It offers the part of the Route4 interface that
+     * Acrs::summarize uses.
+     *
+     * The address is kept as given (host bits included) in host byte
+     * order. Use Route4 to parse and validate input and convert the
+     * result; setPlen() and setMetric() still refuse out of range values.
+     */
+    class Route4Packed
+    {
+        private:
+            enum
+            {
+                MAX_PLEN = 32
+            };
+
+            uint32_t m_addr;
+            uint16_t m_metric;
+            uint8_t m_plen;
+            uint8_t m_reserved;
+
+            uint32_t maskH() const
+            {
+                return (m_plen == 0) ? 0 : ~((uint32_t) 0) << (MAX_PLEN - m_plen);
+            };
+
+        public:
+            int getMaxPlen() const { return MAX_PLEN; };
+            uint32_t getPlen() const { return m_plen; };
+            int getMetric() const { return m_metric; };
+
+            bool setPlen(const uint32_t plen);
+            bool setMetric(const int metric);
+            void setAddr(const in_addr_t addr) { m_addr = ntohl(addr); };
+
+            /* Host byte order forms, without building net form objects */
+            uint32_t getAddrH() const { return m_addr; };
+            uint32_t getNetworkH() const { return m_addr & maskH(); };
+
+            Addr4NetForm getAddrN() const;
+            Addr4NetForm getMaskN() const;
+            Addr4NetForm getNetworkN() const;
+            Addr4NetForm getBroadcastN() const;
+            Addr4NetForm getHostmaskN() const;
+
+            std::string getAddrP() const;
+            std::string getNetworkP() const;
+            std::string str() const;
+
+            /* Conversion to the full route class */
+            Route4 toRoute() const;
+
+            /* Constructors
+             *
+             * The address is in network byte order, as with Route4.
+             */
+            Route4Packed() : m_addr(0), m_metric(0), m_plen(0), m_reserved(0) {};
+            Route4Packed(const in_addr_t addr, const uint32_t plen,
+                         const int metric = 0);
+            explicit Route4Packed(const Route4 & rt);
+    };
+}
+
+#endif /* IPROUTE4PACKED_H */
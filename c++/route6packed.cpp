@@ -0,0 +1,170 @@
+/* route6packed.cpp -- Compact IPv6 route value type
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <sstream>
+#include <cstring>
+#include <endian.h>
+#include <type_traits>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <inttypes.h>
+
+#include "route.hpp"
+#include "route6.hpp"
+#include "route6packed.hpp"
+
+namespace IP
+{
+    static_assert(sizeof(Route6Packed) == 24,
+                  "Route6Packed should be 24 bytes");
+    static_assert(std::is_trivially_copyable<Route6Packed>::value,
+                  "Route6Packed should be trivially copyable");
+
+    /* Build an in6_addr from two host order words */
+    static in6_addr wordsToAddr(uint64_t hi, uint64_t lo)
+    {
+        uint64_t words[2] = { htobe64(hi), htobe64(lo) };
+        in6_addr addr;
+
+        memcpy(&addr, words, sizeof(addr));
+
+        return addr;
+    }
+
+    static std::string wordsToString(uint64_t hi, uint64_t lo)
+    {
+        char buf[INET6_ADDRSTRLEN];
+        in6_addr addr = wordsToAddr(hi, lo);
+
+        inet_ntop(AF_INET6, &addr, buf, sizeof(buf));
+
+        return std::string(buf);
+    }
+
+    bool Route6Packed::setPlen(const uint32_t plen)
+    {
+        if (plen > MAX_PLEN)
+        {
+            return false;
+        }
+
+        m_plen = plen;
+        return true;
+    }
+
+    bool Route6Packed::setMetric(const int metric)
+    {
+        if (metric < Route::MIN_METRIC || metric > Route::MAX_METRIC)
+        {
+            return false;
+        }
+
+        m_metric = metric;
+        return true;
+    }
+
+    void Route6Packed::setAddr(const in6_addr & addr)
+    {
+        Addr6NetForm words(addr);
+
+        m_addr_hi = words.getHighWord();
+        m_addr_lo = words.getLowWord();
+    }
+
+    Addr6NetForm Route6Packed::getAddrN() const
+    {
+        return Addr6NetForm(wordsToAddr(m_addr_hi, m_addr_lo));
+    }
+
+    Addr6NetForm Route6Packed::getMaskN() const
+    {
+        return Addr6NetForm(wordsToAddr(maskHi(), maskLo()));
+    }
+
+    Addr6NetForm Route6Packed::getNetworkN() const
+    {
+        return Addr6NetForm(wordsToAddr(getNetworkHi(), getNetworkLo()));
+    }
+
+    Addr6NetForm Route6Packed::getBroadcastN() const
+    {
+        return Addr6NetForm(wordsToAddr(m_addr_hi | ~maskHi(),
+                                        m_addr_lo | ~maskLo()));
+    }
+
+    Addr6NetForm Route6Packed::getHostmaskN() const
+    {
+        return Addr6NetForm(wordsToAddr(~maskHi(), ~maskLo()));
+    }
+
+    std::string Route6Packed::getAddrP() const
+    {
+        return wordsToString(m_addr_hi, m_addr_lo);
+    }
+
+    std::string Route6Packed::getNetworkP() const
+    {
+        return wordsToString(getNetworkHi(), getNetworkLo());
+    }
+
+    /* Same format as Route::str() */
+    std::string Route6Packed::str() const
+    {
+        std::stringstream ss;
+        ss << getNetworkP() << "/" << getPlen() << " in " << getMetric();
+
+        return ss.str();
+    }
+
+    Route6 Route6Packed::toRoute() const
+    {
+        return Route6(wordsToAddr(m_addr_hi, m_addr_lo), getPlen(), PLEN,
+                      getMetric());
+    }
+
+    Route6Packed::Route6Packed()
+                               :
+                               m_addr_hi(0), m_addr_lo(0), m_metric(0),
+                               m_plen(0)
+    {
+        memset(m_reserved, 0, sizeof(m_reserved));
+    }
+
+    Route6Packed::Route6Packed(const in6_addr & addr, const uint32_t plen,
+                               const int metric)
+                               :
+                               m_metric(0), m_plen(0)
+    {
+        memset(m_reserved, 0, sizeof(m_reserved));
+        setAddr(addr);
+        setPlen(plen);
+        setMetric(metric);
+    }
+
+    Route6Packed::Route6Packed(const Route6 & rt)
+                               :
+                               m_metric(0), m_plen(0)
+    {
+        memset(m_reserved, 0, sizeof(m_reserved));
+        setAddr(rt.getAddrN().getAddr());
+        setPlen(rt.getPlen());
+        setMetric(rt.getMetric());
+    }
+}
@@ -0,0 +1,110 @@
+/* route6packed.hpp -- Compact IPv6 route value type
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IPROUTE6PACKED_H
+#define IPROUTE6PACKED_H
+
+#include <string>
+
+#include <netinet/in.h>
+#include <inttypes.h>
+
+#include "addr6netform.hpp"
+#include "route6.hpp"
+
+namespace IP
+{
+    /* The IPv6 counterpart of Route4Packed: address, prefix length and
+     * metric in 24 bytes, trivially copyable. The address is kept as two
+     * host order words, most significant first, host bits included.
+     */
+    class Route6Packed
+    {
+        private:
+            enum
+            {
+                MAX_PLEN = 128
+            };
+
+            uint64_t m_addr_hi;
+            uint64_t m_addr_lo;
+            uint16_t m_metric;
+            uint8_t m_plen;
+            uint8_t m_reserved[5];
+
+            uint64_t maskHi() const
+            {
+                if (m_plen == 0)
+                {
+                    return 0;
+                }
+                else if (m_plen >= 64)
+                {
+                    return ~((uint64_t) 0);
+                }
+
+                return ~((uint64_t) 0) << (64 - m_plen);
+            };
+
+            uint64_t maskLo() const
+            {
+                if (m_plen <= 64)
+                {
+                    return 0;
+                }
+
+                return ~((uint64_t) 0) << (MAX_PLEN - m_plen);
+            };
+
+        public:
+            int getMaxPlen() const { return MAX_PLEN; };
+            uint32_t getPlen() const { return m_plen; };
+            int getMetric() const { return m_metric; };
+
+            bool setPlen(const uint32_t plen);
+            bool setMetric(const int metric);
+            void setAddr(const in6_addr & addr);
+
+            /* Host order words, without building net form objects */
+            uint64_t getAddrHi() const { return m_addr_hi; };
+            uint64_t getAddrLo() const { return m_addr_lo; };
+            uint64_t getNetworkHi() const { return m_addr_hi & maskHi(); };
+            uint64_t getNetworkLo() const { return m_addr_lo & maskLo(); };
+
+            Addr6NetForm getAddrN() const;
+            Addr6NetForm getMaskN() const;
+            Addr6NetForm getNetworkN() const;
+            Addr6NetForm getBroadcastN() const;
+            Addr6NetForm getHostmaskN() const;
+
+            std::string getAddrP() const;
+            std::string getNetworkP() const;
+            std::string str() const;
+
+            /* Conversion to the full route class */
+            Route6 toRoute() const;
+
+            /* Constructors */
+            Route6Packed();
+            Route6Packed(const in6_addr & addr, const uint32_t plen,
+                         const int metric = 0);
+            explicit Route6Packed(const Route6 & rt);
+    };
+}
+
+#endif /* IPROUTE6PACKED_H */
@@ -0,0 +1,349 @@
+/* routegen.cpp -- Reproducible synthetic route tables
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "routegen.hpp"
+
+namespace IP
+{
+    /* Prefix lengths of a full table, in routes per thousand */
+    struct PlenWeight
+    {
+        uint32_t plen;
+        uint32_t weight;
+    };
+
+    static const PlenWeight FULL_PLENS4[] =
+    {
+        { 8, 1 }, { 11, 1 }, { 12, 2 }, { 13, 3 }, { 14, 5 }, { 15, 5 },
+        { 16, 25 }, { 17, 12 }, { 18, 20 }, { 19, 40 }, { 20, 50 },
+        { 21, 50 }, { 22, 110 }, { 23, 90 }, { 24, 570 }, { 25, 3 },
+        { 26, 3 }, { 27, 3 }, { 28, 2 }, { 29, 2 }, { 30, 1 }, { 32, 2 }
+    };
+
+    static const PlenWeight FULL_PLENS6[] =
+    {
+        { 16, 1 }, { 19, 1 }, { 20, 3 }, { 24, 5 }, { 28, 6 }, { 29, 25 },
+        { 30, 4 }, { 32, 110 }, { 33, 8 }, { 34, 8 }, { 35, 6 },
+        { 36, 30 }, { 38, 6 }, { 40, 60 }, { 42, 15 }, { 44, 60 },
+        { 45, 10 }, { 46, 30 }, { 47, 25 }, { 48, 560 }, { 52, 5 },
+        { 56, 10 }, { 64, 12 }
+    };
+
+    static const uint32_t TOTAL_WEIGHT = 1000;
+
+    /* Addresses of a FULL block share this many leading bits */
+    static const uint32_t BLOCK_PLEN4 = 12;
+    static const uint32_t BLOCK_PLEN6 = 32;
+
+    /* The longest runs of SIBLINGS are 2^MAX_RUN_BITS routes */
+    static const uint32_t MAX_RUN_BITS = 16;
+
+    /* Bits of a 128 bit address within the first 'plen', in two words */
+    static uint64_t maskHi(uint32_t plen)
+    {
+        if (plen == 0)
+        {
+            return 0;
+        }
+
+        return (plen >= 64) ? ~(uint64_t) 0 : ~(uint64_t) 0 << (64 - plen);
+    }
+
+    static uint64_t maskLo(uint32_t plen)
+    {
+        if (plen <= 64)
+        {
+            return 0;
+        }
+
+        return (plen >= 128) ? ~(uint64_t) 0 : ~(uint64_t) 0 << (128 - plen);
+    }
+
+    static void makeRoute(uint64_t hi, uint64_t /* lo */, uint32_t plen,
+                          int metric, Route4Packed & rt)
+    {
+        rt = Route4Packed(htonl(hi >> 32), plen, metric);
+    }
+
+    static void makeRoute(uint64_t hi, uint64_t lo, uint32_t plen,
+                          int metric, Route6Packed & rt)
+    {
+        in6_addr addr;
+
+        for (int i = 0; i < 8; i++)
+        {
+            addr.s6_addr[i] = hi >> (56 - i * 8);
+            addr.s6_addr[8 + i] = lo >> (56 - i * 8);
+        }
+
+        rt = Route6Packed(addr, plen, metric);
+    }
+
+    /* splitmix64, which gives the same sequence everywhere */
+    uint64_t RouteGenerator::nextRand()
+    {
+        uint64_t z = (m_state += 0x9e3779b97f4a7c15ULL);
+
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+        return z ^ (z >> 31);
+    }
+
+    /* A number from 0 to bound - 1 */
+    uint64_t RouteGenerator::nextRand(uint64_t bound)
+    {
+        return nextRand() % bound;
+    }
+
+    int RouteGenerator::randomMetric()
+    {
+        return nextRand(m_metrics);
+    }
+
+    uint32_t RouteGenerator::fullPlen(uint32_t max_plen)
+    {
+        const PlenWeight * p_plens = FULL_PLENS4;
+        size_t count = sizeof(FULL_PLENS4) / sizeof(FULL_PLENS4[0]);
+
+        if (max_plen == 128)
+        {
+            p_plens = FULL_PLENS6;
+            count = sizeof(FULL_PLENS6) / sizeof(FULL_PLENS6[0]);
+        }
+
+        uint32_t roll = nextRand(TOTAL_WEIGHT);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (roll < p_plens[i].weight)
+            {
+                return p_plens[i].plen;
+            }
+
+            roll -= p_plens[i].weight;
+        }
+
+        /* The weights may not add up to quite TOTAL_WEIGHT */
+        return p_plens[count - 1].plen;
+    }
+
+    /* A random host address in unicast space: 1.0.0.0 to 223.255.255.255
+     * for IPv4, 2000::/3 for IPv6
+     */
+    void RouteGenerator::randomAddr(Prefix & prefix, uint32_t max_plen)
+    {
+        prefix.hi = nextRand();
+        prefix.lo = nextRand();
+        prefix.plen = max_plen;
+
+        if (max_plen == 32)
+        {
+            prefix.hi = ((1 + nextRand(223)) << 56) |
+                        (prefix.hi & 0x00ffffff00000000ULL);
+            prefix.lo = 0;
+        }
+        else
+        {
+            prefix.hi = (prefix.hi >> 3) | 0x2000000000000000ULL;
+        }
+    }
+
+    static void maskPrefix(uint64_t & hi, uint64_t & lo, uint32_t plen)
+    {
+        hi &= maskHi(plen);
+        lo &= maskLo(plen);
+    }
+
+    /* Move to the next prefix of the same length */
+    static void nextPrefix(uint64_t & hi, uint64_t & lo, uint32_t plen)
+    {
+        if (plen <= 64)
+        {
+            hi += (uint64_t) 1 << (64 - plen);
+        }
+        else
+        {
+            uint64_t old = lo;
+            lo += (uint64_t) 1 << (128 - plen);
+            hi += (lo < old);
+        }
+    }
+
+    /* Add a route, then perhaps a duplicate of an earlier one */
+    template <class P> void RouteGenerator::add(const Prefix & prefix,
+                                                std::vector<P> & routes)
+    {
+        P rt;
+        makeRoute(prefix.hi, prefix.lo, prefix.plen, prefix.metric, rt);
+        routes.push_back(rt);
+
+        if (m_duplicates == 0 || nextRand(100) >= m_duplicates)
+        {
+            return;
+        }
+
+        rt = routes[nextRand(routes.size())];
+
+        if (m_metrics > 1 && nextRand(2) == 0)
+        {
+            rt.setMetric((rt.getMetric() + 1 + nextRand(m_metrics - 1)) %
+                         m_metrics);
+        }
+
+        routes.push_back(rt);
+    }
+
+    /* A block of 1 to 128 routes, a third of them next to the one before */
+    template <class P> void RouteGenerator::addFull(uint32_t max_plen,
+                                                    std::vector<P> & routes)
+    {
+        uint32_t block_plen = (max_plen == 32) ? BLOCK_PLEN4 : BLOCK_PLEN6;
+        Prefix block;
+        Prefix prefix;
+
+        randomAddr(block, max_plen);
+        block.metric = randomMetric();
+
+        uint64_t run = 1 + nextRand(128);
+
+        for (uint64_t i = 0; i < run; i++)
+        {
+            if (i > 0 && nextRand(3) == 0)
+            {
+                nextPrefix(prefix.hi, prefix.lo, prefix.plen);
+            }
+            else
+            {
+                randomAddr(prefix, max_plen);
+                prefix.hi = (block.hi & maskHi(block_plen)) |
+                            (prefix.hi & ~maskHi(block_plen));
+                prefix.plen = fullPlen(max_plen);
+                maskPrefix(prefix.hi, prefix.lo, prefix.plen);
+            }
+
+            prefix.metric = (nextRand(4) != 0) ? block.metric :
+                                                 randomMetric();
+            add(prefix, routes);
+        }
+    }
+
+    template <class P> void RouteGenerator::addSiblings(uint32_t max_plen,
+                                                        std::vector<P> & routes)
+    {
+        uint32_t plen = (max_plen == 32) ? 24 : 48;
+        uint32_t bits = 1 + nextRand(MAX_RUN_BITS);
+        Prefix prefix;
+
+        randomAddr(prefix, max_plen);
+        maskPrefix(prefix.hi, prefix.lo, plen - bits);
+        prefix.plen = plen;
+        prefix.metric = randomMetric();
+
+        for (uint64_t i = 0; i < ((uint64_t) 1 << bits); i++)
+        {
+            add(prefix, routes);
+            nextPrefix(prefix.hi, prefix.lo, plen);
+        }
+    }
+
+    template <class P> void RouteGenerator::addNested(uint32_t max_plen,
+                                                      std::vector<P> & routes)
+    {
+        uint32_t first = (max_plen == 32) ? 8 + nextRand(8) :
+                                            16 + nextRand(16);
+        Prefix leaf;
+
+        randomAddr(leaf, max_plen);
+
+        for (uint32_t plen = first; plen <= max_plen; plen++)
+        {
+            Prefix prefix = leaf;
+            maskPrefix(prefix.hi, prefix.lo, plen);
+            prefix.plen = plen;
+            prefix.metric = randomMetric();
+
+            add(prefix, routes);
+        }
+    }
+
+    template <class P> void RouteGenerator::fill(size_t count,
+                                                 uint32_t max_plen,
+                                                 std::vector<P> & routes)
+    {
+        m_state = m_seed;
+        routes.clear();
+        routes.reserve(count);
+
+        while (routes.size() < count)
+        {
+            switch (m_shape)
+            {
+            case SHAPE_FULL:
+                addFull(max_plen, routes);
+                break;
+            case SHAPE_SIBLINGS:
+                addSiblings(max_plen, routes);
+                break;
+            case SHAPE_NESTED:
+                addNested(max_plen, routes);
+                break;
+            }
+        }
+
+        routes.resize(count);
+
+        if (m_shuffle == false)
+        {
+            return;
+        }
+
+        /* Fisher-Yates, rather than std::shuffle, whose results differ
+         * between libraries
+         */
+        for (size_t i = count; i > 1; i--)
+        {
+            size_t j = nextRand(i);
+            P rt = routes[i - 1];
+            routes[i - 1] = routes[j];
+            routes[j] = rt;
+        }
+    }
+
+    void RouteGenerator::generate(size_t count,
+                                  std::vector<Route4Packed> & routes)
+    {
+        fill(count, 32, routes);
+    }
+
+    void RouteGenerator::generate(size_t count,
+                                  std::vector<Route6Packed> & routes)
+    {
+        fill(count, 128, routes);
+    }
+
+    RouteGenerator::RouteGenerator()
+                   :
+                   m_shape(SHAPE_FULL), m_seed(1), m_metrics(1),
+                   m_duplicates(0), m_shuffle(false), m_state(1)
+    {
+    }
+}
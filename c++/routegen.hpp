@@ -0,0 +1,148 @@
+/* routegen.hpp -- Reproducible synthetic route tables
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ROUTEGEN_H
+#define ROUTEGEN_H
+
+#include <vector>
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#include "route4packed.hpp"
+#include "route6packed.hpp"
+
+namespace IP
+{
+    /* Generates route tables of a chosen shape for benchmarks. The same
+     * seed and settings always give the same routes, on any machine, so
+     * a table can be rebuilt from its settings instead of being shipped.
+     *
+     * Shapes:
+     *
+     *   SHAPE_FULL      Prefix lengths distributed as in a full BGP table
+     *                   (mostly /24 for IPv4, /48 for IPv6), clustered in
+     *                   address blocks that mostly share a metric, with
+     *                   some runs of adjacent prefixes.
+     *   SHAPE_SIBLINGS  Aligned runs of 2 to 2^16 adjacent /24s (IPv4) or
+     *                   /48s (IPv6) of one metric. A run of 2^k collapses
+     *                   to one route, taking k merge passes.
+     *   SHAPE_NESTED    Chains of prefixes each inside the last, from /8
+     *                   to /15 (IPv4) or /16 to /31 (IPv6) down to host
+     *                   routes, with random metrics, so most routes
+     *                   overlap many others.
+     *
+     * Metrics are drawn from 0 to getMetrics() - 1. Each route is followed
+     * by a duplicate of an earlier one with the chance set by
+     * setDuplicates(), half of them with another metric.
+     */
+    class RouteGenerator
+    {
+        public:
+            enum Shape
+            {
+                SHAPE_FULL,
+                SHAPE_SIBLINGS,
+                SHAPE_NESTED
+            };
+
+            /* Replace the contents of 'routes' with 'count' routes */
+            void generate(size_t count, std::vector<Route4Packed> & routes);
+            void generate(size_t count, std::vector<Route6Packed> & routes);
+
+            void setShape(Shape shape) { m_shape = shape; };
+            Shape getShape() const { return m_shape; };
+
+            /* Also restarts the stream nextRand() draws from */
+            void setSeed(uint64_t seed) { m_seed = seed; m_state = seed; };
+            uint64_t getSeed() const { return m_seed; };
+
+            /* Number of distinct metrics, at least 1 (the default) */
+            void setMetrics(int metrics)
+            {
+                m_metrics = (metrics < 1) ? 1 : metrics;
+            };
+
+            int getMetrics() const { return m_metrics; };
+
+            /* Chance of a duplicate after each route, in percent (default
+             * 0)
+             */
+            void setDuplicates(uint32_t percent)
+            {
+                m_duplicates = (percent > 100) ? 100 : percent;
+            };
+
+            uint32_t getDuplicates() const { return m_duplicates; };
+
+            /* Put the routes in random order rather than the order they
+             * were generated in, which keeps blocks, runs and chains
+             * together (default false)
+             */
+            void setShuffle(bool shuffle) { m_shuffle = shuffle; };
+            bool getShuffle() const { return m_shuffle; };
+
+            /* The next number of the stream the routes are drawn from,
+             * for benchmarks that need more than routes (addresses to
+             * look up, updates to replay) to follow from the seed too.
+             * generate() restarts the stream.
+             */
+            uint64_t nextRand();
+
+            /* A number from 0 to bound - 1 */
+            uint64_t nextRand(uint64_t bound);
+
+            /* Constructor */
+            RouteGenerator();
+
+        private:
+            /* A prefix being generated, IPv4 in the top bits of 'hi' */
+            struct Prefix
+            {
+                uint64_t hi;
+                uint64_t lo;
+                uint32_t plen;
+                int metric;
+            };
+
+            Shape m_shape;
+            uint64_t m_seed;
+            int m_metrics;
+            uint32_t m_duplicates;
+            bool m_shuffle;
+
+            uint64_t m_state;
+
+            int randomMetric();
+            uint32_t fullPlen(uint32_t max_plen);
+            void randomAddr(Prefix & prefix, uint32_t max_plen);
+
+            template <class P> void fill(size_t count, uint32_t max_plen,
+                                         std::vector<P> & routes);
+            template <class P> void add(const Prefix & prefix,
+                                        std::vector<P> & routes);
+            template <class P> void addFull(uint32_t max_plen,
+                                            std::vector<P> & routes);
+            template <class P> void addSiblings(uint32_t max_plen,
+                                                std::vector<P> & routes);
+            template <class P> void addNested(uint32_t max_plen,
+                                              std::vector<P> & routes);
+    };
+}
+
+#endif /* ROUTEGEN_H */
@@ -0,0 +1,444 @@
+/* routelookup.cpp -- Longest prefix match tables built from routes
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "routelookup.hpp"
+
+namespace IP
+{
+    /* Addresses looked up together in a batch */
+    static const size_t LOOKUP_GROUP = 16;
+    static const size_t LOOKUP_AHEAD = 16;
+
+    /* Order in which routes are written into the tables: shorter prefixes
+     * first so longer ones overwrite them, and for the same prefix the
+     * lowest metric (then the first added) last so it is what remains
+     */
+    struct FillOrder
+    {
+        const std::vector<Route4Packed> & routes;
+
+        bool operator()(uint32_t a, uint32_t b) const
+        {
+            if (routes[a].getPlen() != routes[b].getPlen())
+            {
+                return routes[a].getPlen() < routes[b].getPlen();
+            }
+            else if (routes[a].getMetric() != routes[b].getMetric())
+            {
+                return routes[a].getMetric() > routes[b].getMetric();
+            }
+
+            return a > b;
+        }
+    };
+
+    void RouteLookup4::add(const Route4 & rt)
+    {
+        m_routes.push_back(Route4Packed(rt));
+    }
+
+    void RouteLookup4::add(const Route4Packed & rt)
+    {
+        m_routes.push_back(rt);
+    }
+
+    void RouteLookup4::build()
+    {
+        std::vector<uint32_t> order(m_routes.size());
+        FillOrder fill_order = { m_routes };
+
+        for (uint32_t i = 0; i < order.size(); i++)
+        {
+            order[i] = i;
+        }
+
+        std::sort(order.begin(), order.end(), fill_order);
+
+        m_tbl24.assign(TBL24_SIZE, 0);
+        m_tbl8.clear();
+
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            const Route4Packed & rt = m_routes[order[i]];
+            uint32_t network = rt.getNetworkH();
+            uint32_t plen = rt.getPlen();
+            uint32_t value = order[i] + 1;
+
+            if (plen <= 24)
+            {
+                std::fill(m_tbl24.begin() + (network >> 8),
+                          m_tbl24.begin() + (network >> 8) +
+                          (1 << (24 - plen)), value);
+                continue;
+            }
+
+            /* Every shorter route is in place, so a new group starts out
+             * as the /24 it replaces
+             */
+            uint32_t & entry = m_tbl24[network >> 8];
+
+            if ((entry & EXTENDED) == 0)
+            {
+                uint32_t group = m_tbl8.size() >> 8;
+                m_tbl8.resize(m_tbl8.size() + 256, entry);
+                entry = EXTENDED | group;
+            }
+
+            size_t first = ((entry & ~EXTENDED) << 8) | (network & 0xff);
+
+            std::fill(m_tbl8.begin() + first,
+                      m_tbl8.begin() + first + (1 << (32 - plen)), value);
+        }
+    }
+
+    void RouteLookup4::lookup(const in_addr_t * p_addrs, size_t count,
+                              uint32_t * p_results) const
+    {
+        /* Start the tbl24 read for the address LOOKUP_AHEAD places on
+         * while resolving this one, so that many reads are in flight
+         */
+        for (size_t i = 0; i < count; i++)
+        {
+            if (i + LOOKUP_AHEAD < count)
+            {
+                __builtin_prefetch(
+                    &m_tbl24[ntohl(p_addrs[i + LOOKUP_AHEAD]) >> 8]);
+            }
+
+            p_results[i] = lookup(p_addrs[i]);
+        }
+    }
+
+    size_t RouteLookup4::memoryUsage() const
+    {
+        return (m_tbl24.size() + m_tbl8.size()) * sizeof(uint32_t);
+    }
+
+    void RouteLookup4::clear()
+    {
+        m_routes.clear();
+        m_tbl24.assign(TBL24_SIZE, 0);
+        m_tbl8.clear();
+    }
+
+    RouteLookup4::RouteLookup4() : m_tbl24(TBL24_SIZE, 0)
+    {
+    }
+
+    void RouteLookup6::add(const Route6 & rt)
+    {
+        m_routes.push_back(Route6Packed(rt));
+    }
+
+    void RouteLookup6::add(const Route6Packed & rt)
+    {
+        m_routes.push_back(rt);
+    }
+
+    /* Network order, then the same fill order as for IPv4 */
+    struct PrefixOrder
+    {
+        const std::vector<Route6Packed> & routes;
+
+        bool operator()(uint32_t a, uint32_t b) const
+        {
+            const Route6Packed & rt_a = routes[a];
+            const Route6Packed & rt_b = routes[b];
+
+            if (rt_a.getNetworkHi() != rt_b.getNetworkHi())
+            {
+                return rt_a.getNetworkHi() < rt_b.getNetworkHi();
+            }
+            else if (rt_a.getNetworkLo() != rt_b.getNetworkLo())
+            {
+                return rt_a.getNetworkLo() < rt_b.getNetworkLo();
+            }
+            else if (rt_a.getPlen() != rt_b.getPlen())
+            {
+                return rt_a.getPlen() < rt_b.getPlen();
+            }
+            else if (rt_a.getMetric() != rt_b.getMetric())
+            {
+                return rt_a.getMetric() > rt_b.getMetric();
+            }
+
+            return a > b;
+        }
+    };
+
+    void RouteLookup6::build()
+    {
+        std::vector<uint32_t> order(m_routes.size());
+        PrefixOrder prefix_order = { m_routes };
+
+        for (uint32_t i = 0; i < order.size(); i++)
+        {
+            order[i] = i;
+        }
+
+        std::sort(order.begin(), order.end(), prefix_order);
+
+        std::vector<Prefix> prefixes(order.size());
+
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            const Route6Packed & rt = m_routes[order[i]];
+
+            prefixes[i].hi = rt.getNetworkHi();
+            prefixes[i].lo = rt.getNetworkLo();
+            prefixes[i].plen = rt.getPlen();
+            prefixes[i].index = order[i];
+        }
+
+        m_direct.assign(1 << DIRECT_BITS, 0);
+        m_nodes.clear();
+        m_leaves.clear();
+
+        /* Prefixes up to DIRECT_BITS long go straight into the direct
+         * table, shortest first so longer ones overwrite them
+         */
+        for (uint32_t plen = 0; plen <= DIRECT_BITS; plen++)
+        {
+            for (size_t i = 0; i < prefixes.size(); i++)
+            {
+                if (prefixes[i].plen != plen)
+                {
+                    continue;
+                }
+
+                uint32_t first = prefixes[i].hi >> (64 - DIRECT_BITS);
+
+                std::fill(m_direct.begin() + first,
+                          m_direct.begin() + first +
+                          (1 << (DIRECT_BITS - plen)),
+                          prefixes[i].index + 1);
+            }
+        }
+
+        /* Each /16 holding longer prefixes gets a trie of its own, in
+         * which the /16's direct route is the default
+         */
+        for (size_t i = 0; i < prefixes.size(); )
+        {
+            uint32_t top = prefixes[i].hi >> (64 - DIRECT_BITS);
+            size_t end = i;
+            bool longer = false;
+
+            while (end < prefixes.size() &&
+                   prefixes[end].hi >> (64 - DIRECT_BITS) == top)
+            {
+                longer = longer || (prefixes[end].plen > DIRECT_BITS);
+                end++;
+            }
+
+            if (longer == true)
+            {
+                Node root = { 0, 0, 0, 0 };
+                uint32_t n = m_nodes.size();
+
+                m_nodes.push_back(root);
+                buildNode(n, DIRECT_BITS, &prefixes[i], &prefixes[0] + end,
+                          m_direct[top] - 1);
+                m_direct[top] = DIRECT_NODE | n;
+            }
+
+            i = end;
+        }
+    }
+
+    /* Fill in node 'n', which covers the addresses whose first 'pos' bits
+     * are those of the prefixes in [first, last). Prefixes no longer than
+     * 'pos' were dealt with above and resolve to 'inherited'. Those ending
+     * within the node's STRIDE bits become leaves, spread over every slot
+     * they cover; longer ones go to the children.
+     */
+    void RouteLookup6::buildNode(uint32_t n, uint32_t pos,
+                                 const Prefix * first, const Prefix * last,
+                                 uint32_t inherited)
+    {
+        uint32_t leaf[SLOTS];
+        uint64_t children = 0;
+
+        std::fill(leaf, leaf + SLOTS, inherited);
+
+        /* In fill order within each slot; shorter prefixes covering many
+         * slots are applied first by going through lengths in turn.
+         */
+        for (uint32_t plen = pos + 1; plen <= pos + STRIDE; plen++)
+        {
+            for (const Prefix * p = first; p != last; p++)
+            {
+                if (p->plen != plen)
+                {
+                    continue;
+                }
+
+                uint32_t s = slot(p->hi, p->lo, pos);
+                uint32_t span = 1 << (pos + STRIDE - plen);
+
+                std::fill(leaf + s, leaf + s + span, p->index);
+            }
+        }
+
+        for (const Prefix * p = first; p != last; p++)
+        {
+            if (p->plen > pos + STRIDE)
+            {
+                children |= (uint64_t) 1 << slot(p->hi, p->lo, pos);
+            }
+        }
+
+        Node node;
+        node.children = children;
+        node.leaves = 0;
+        node.leaf_base = m_leaves.size();
+        node.child_base = m_nodes.size();
+
+        for (uint32_t s = 0; s < SLOTS; s++)
+        {
+            if (((children >> s) & 1) != 0)
+            {
+                continue;
+            }
+
+            if (node.leaves == 0 || leaf[s] != m_leaves.back())
+            {
+                node.leaves |= (uint64_t) 1 << s;
+                m_leaves.push_back(leaf[s]);
+            }
+        }
+
+        m_nodes[n] = node;
+        m_nodes.resize(m_nodes.size() + popcount(children));
+
+        /* Prefixes are in network order, so those under each slot are
+         * next to each other
+         */
+        const Prefix * p = first;
+        uint32_t child = node.child_base;
+
+        for (uint32_t s = 0; s < SLOTS; s++)
+        {
+            if (((children >> s) & 1) == 0)
+            {
+                continue;
+            }
+
+            while (slot(p->hi, p->lo, pos) < s)
+            {
+                p++;
+            }
+
+            const Prefix * group = p;
+
+            while (p != last && slot(p->hi, p->lo, pos) == s)
+            {
+                p++;
+            }
+
+            buildNode(child++, pos + STRIDE, group, p, leaf[s]);
+        }
+    }
+
+    void RouteLookup6::lookup(const in6_addr * p_addrs, size_t count,
+                              uint32_t * p_results) const
+    {
+        uint64_t hi[LOOKUP_GROUP];
+        uint64_t lo[LOOKUP_GROUP];
+        uint32_t node[LOOKUP_GROUP];
+
+        for (size_t base = 0; base < count; base += LOOKUP_GROUP)
+        {
+            size_t group = std::min(LOOKUP_GROUP, count - base);
+            size_t left = group;
+
+            for (size_t i = 0; i < group; i++)
+            {
+                uint64_t words[2];
+                memcpy(words, &p_addrs[base + i], sizeof(words));
+
+                hi[i] = be64toh(words[0]);
+                lo[i] = be64toh(words[1]);
+                node[i] = m_direct[hi[i] >> (64 - DIRECT_BITS)];
+
+                if ((node[i] & DIRECT_NODE) == 0)
+                {
+                    p_results[base + i] = node[i] - 1;
+                    node[i] = NONE;
+                    left--;
+                    continue;
+                }
+
+                node[i] &= ~DIRECT_NODE;
+                __builtin_prefetch(&m_nodes[node[i]]);
+            }
+
+            /* A level at a time, so each address's next node is being
+             * fetched while the others are worked on
+             */
+            for (uint32_t pos = DIRECT_BITS; left > 0; pos += STRIDE)
+            {
+                for (size_t i = 0; i < group; i++)
+                {
+                    if (node[i] == NONE)
+                    {
+                        continue;
+                    }
+
+                    const Node & cur = m_nodes[node[i]];
+                    uint32_t s = slot(hi[i], lo[i], pos);
+                    uint64_t upto = slotMask(s);
+
+                    if (((cur.children >> s) & 1) == 0)
+                    {
+                        p_results[base + i] =
+                            m_leaves[cur.leaf_base +
+                                     popcount(cur.leaves & upto) - 1];
+                        node[i] = NONE;
+                        left--;
+                        continue;
+                    }
+
+                    node[i] = cur.child_base +
+                              popcount(cur.children & upto) - 1;
+                    __builtin_prefetch(&m_nodes[node[i]]);
+                }
+            }
+        }
+    }
+
+    size_t RouteLookup6::memoryUsage() const
+    {
+        return m_nodes.size() * sizeof(Node) +
+               (m_leaves.size() + m_direct.size()) * sizeof(uint32_t);
+    }
+
+    void RouteLookup6::clear()
+    {
+        m_routes.clear();
+        m_nodes.clear();
+        m_leaves.clear();
+        m_direct.assign(1 << DIRECT_BITS, 0);
+    }
+
+    RouteLookup6::RouteLookup6() : m_direct(1 << DIRECT_BITS, 0)
+    {
+    }
+}
@@ -0,0 +1,254 @@
+/* routelookup.hpp -- Longest prefix match tables built from routes
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ROUTELOOKUP_H
+#define ROUTELOOKUP_H
+
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <inttypes.h>
+#include <endian.h>
+#include <string.h>
+
+#include "route4.hpp"
+#include "route6.hpp"
+#include "route4packed.hpp"
+#include "route6packed.hpp"
+
+namespace IP
+{
+    /* Answers longest prefix match lookups over a set of IPv4 routes, such
+     * as a summarized table, with a DIR-24-8 table: one entry for every
+     * /24, and for /24s holding longer prefixes a group of 256 entries,
+     * one per address. A lookup reads one or two entries.
+     *
+     * Routes are added, then build() compiles the table. A lookup returns
+     * the index of the matching route in the order routes were added, or
+     * NONE. Where a prefix was added with several metrics, the lowest
+     * wins. Addresses are in network byte order, as with Route4Packed.
+     */
+    class RouteLookup4
+    {
+        public:
+            enum
+            {
+                NONE = 0xffffffff
+            };
+
+            void add(const Route4 & rt);
+            void add(const Route4Packed & rt);
+
+            /* Compile the table from the routes added so far */
+            void build();
+
+            uint32_t lookup(in_addr_t addr) const
+            {
+                uint32_t host = ntohl(addr);
+                uint32_t entry = m_tbl24[host >> 8];
+
+                if ((entry & EXTENDED) != 0)
+                {
+                    entry = m_tbl8[((entry & ~EXTENDED) << 8) |
+                                   (host & 0xff)];
+                }
+
+                /* Entries hold the index plus one, zero for no route */
+                return entry - 1;
+            };
+
+            /* Look up 'count' addresses, prefetching ahead, and store the
+             * route indexes in p_results
+             */
+            void lookup(const in_addr_t * p_addrs, size_t count,
+                        uint32_t * p_results) const;
+
+            const Route4Packed & getRoute(uint32_t index) const
+            {
+                return m_routes[index];
+            };
+
+            size_t size() const { return m_routes.size(); };
+
+            /* Bytes held by the compiled table */
+            size_t memoryUsage() const;
+
+            void clear();
+
+            /* Constructor */
+            RouteLookup4();
+
+        private:
+            enum
+            {
+                EXTENDED = 0x80000000,      /* Entry refers to a tbl8 group */
+                TBL24_SIZE = 1 << 24
+            };
+
+            std::vector<Route4Packed> m_routes;
+            std::vector<uint32_t> m_tbl24;
+            std::vector<uint32_t> m_tbl8;
+    };
+
+    /* The IPv6 counterpart of RouteLookup4: a multibit trie in the style
+     * of Poptrie. The first 16 bits of the address index a table directly,
+     * whose entries hold either the route or the trie node for that /16.
+     * Each node splits the next 6 bits of the address 64 ways. A bitmap
+     * marks which of the 64 slots lead to a child node, and another marks
+     * where a run of slots resolving to the same route begins, so a node
+     * holds one leaf per run rather than one per slot. Children and leaves
+     * of a node are kept together and found by counting bits, so a node is
+     * 24 bytes however full it is. A lookup visits one node per 6 bits of
+     * the longest prefix on its path past the first 16.
+     */
+    class RouteLookup6
+    {
+        public:
+            enum
+            {
+                NONE = 0xffffffff
+            };
+
+            void add(const Route6 & rt);
+            void add(const Route6Packed & rt);
+
+            /* Compile the trie from the routes added so far */
+            void build();
+
+            uint32_t lookup(const in6_addr & addr) const
+            {
+                uint64_t words[2];
+                memcpy(words, &addr, sizeof(words));
+
+                uint64_t hi = be64toh(words[0]);
+                uint64_t lo = be64toh(words[1]);
+                uint32_t n = m_direct[hi >> (64 - DIRECT_BITS)];
+
+                /* Direct entries hold a node, or the index plus one */
+                if ((n & DIRECT_NODE) == 0)
+                {
+                    return n - 1;
+                }
+
+                n &= ~DIRECT_NODE;
+
+                for (uint32_t pos = DIRECT_BITS; ; pos += STRIDE)
+                {
+                    const Node & node = m_nodes[n];
+                    uint32_t s = slot(hi, lo, pos);
+                    uint64_t upto = slotMask(s);
+
+                    if (((node.children >> s) & 1) == 0)
+                    {
+                        return m_leaves[node.leaf_base +
+                                        popcount(node.leaves & upto) - 1];
+                    }
+
+                    n = node.child_base + popcount(node.children & upto) - 1;
+                }
+            };
+
+            /* Look up 'count' addresses, walking several at once level by
+             * level and prefetching each one's next node
+             */
+            void lookup(const in6_addr * p_addrs, size_t count,
+                        uint32_t * p_results) const;
+
+            const Route6Packed & getRoute(uint32_t index) const
+            {
+                return m_routes[index];
+            };
+
+            size_t size() const { return m_routes.size(); };
+
+            /* Bytes held by the compiled trie */
+            size_t memoryUsage() const;
+
+            void clear();
+
+            /* Constructor */
+            RouteLookup6();
+
+        private:
+            enum
+            {
+                STRIDE = 6,
+                SLOTS = 1 << STRIDE,
+                DIRECT_BITS = 16,
+                DIRECT_NODE = 0x80000000    /* Direct entry is a node */
+            };
+
+            struct Node
+            {
+                uint64_t children;      /* Slots with a child node */
+                uint64_t leaves;        /* Slots starting a run of leaves */
+                uint32_t child_base;
+                uint32_t leaf_base;
+            };
+
+            /* A route being compiled */
+            struct Prefix
+            {
+                uint64_t hi;
+                uint64_t lo;
+                uint32_t plen;
+                uint32_t index;
+            };
+
+            std::vector<Route6Packed> m_routes;
+            std::vector<Node> m_nodes;
+            std::vector<uint32_t> m_leaves;
+            std::vector<uint32_t> m_direct;
+
+            static int popcount(uint64_t bits)
+            {
+                return __builtin_popcountll(bits);
+            };
+
+            /* The STRIDE bits of the address at 'pos', zero past the end */
+            static uint32_t slot(uint64_t hi, uint64_t lo, uint32_t pos)
+            {
+                uint32_t end = pos + STRIDE;
+
+                if (end <= 64)
+                {
+                    return (hi >> (64 - end)) & (SLOTS - 1);
+                }
+                else if (pos >= 64)
+                {
+                    return (end <= 128 ? lo >> (128 - end) :
+                                         lo << (end - 128)) & (SLOTS - 1);
+                }
+
+                return ((hi << (end - 64)) | (lo >> (128 - end))) &
+                       (SLOTS - 1);
+            };
+
+            /* Bits for slots 0 to 'slot' */
+            static uint64_t slotMask(uint32_t slot)
+            {
+                return (~(uint64_t) 0) >> (SLOTS - 1 - slot);
+            };
+
+            void buildNode(uint32_t n, uint32_t pos, const Prefix * first,
+                           const Prefix * last, uint32_t inherited);
+    };
+}
+
+#endif /* ROUTELOOKUP_H */
@@ -0,0 +1,367 @@
+/* routetable.cpp -- Binary route table files
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "routetable.hpp"
+
+namespace IP
+{
+    static_assert(sizeof(RouteTableHeader) == RouteTable::HEADER_SIZE,
+                  "route table header must be 64 bytes");
+    static_assert(sizeof(Route4Packed) == 8, "Route4Packed must be 8 bytes");
+    static_assert(sizeof(Route6Packed) == 24, "Route6Packed must be 24 bytes");
+
+    const char RouteTable::MAGIC[8] = { 'A', 'C', 'R', 'S', 'T', 'B', 'L',
+                                        '\0' };
+
+    static const uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL;
+    static const uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+    /* Overlap order: network, then prefix length, then metric. The
+     * address breaks any remaining tie so the order is total.
+     */
+    static bool tableLess(const Route4Packed & a, const Route4Packed & b)
+    {
+        if (a.getNetworkH() != b.getNetworkH())
+        {
+            return a.getNetworkH() < b.getNetworkH();
+        }
+        else if (a.getPlen() != b.getPlen())
+        {
+            return a.getPlen() < b.getPlen();
+        }
+        else if (a.getMetric() != b.getMetric())
+        {
+            return a.getMetric() < b.getMetric();
+        }
+
+        return a.getAddrH() < b.getAddrH();
+    }
+
+    static bool tableLess(const Route6Packed & a, const Route6Packed & b)
+    {
+        if (a.getNetworkHi() != b.getNetworkHi())
+        {
+            return a.getNetworkHi() < b.getNetworkHi();
+        }
+        else if (a.getNetworkLo() != b.getNetworkLo())
+        {
+            return a.getNetworkLo() < b.getNetworkLo();
+        }
+        else if (a.getPlen() != b.getPlen())
+        {
+            return a.getPlen() < b.getPlen();
+        }
+        else if (a.getMetric() != b.getMetric())
+        {
+            return a.getMetric() < b.getMetric();
+        }
+        else if (a.getAddrHi() != b.getAddrHi())
+        {
+            return a.getAddrHi() < b.getAddrHi();
+        }
+
+        return a.getAddrLo() < b.getAddrLo();
+    }
+
+    /* Write all of [p_buf, p_buf + size), retrying short writes */
+    static bool writeAll(int fd, const void * p_buf, size_t size)
+    {
+        const char * p = (const char *) p_buf;
+
+        while (size > 0)
+        {
+            ssize_t wrote = ::write(fd, p, size);
+
+            if (wrote < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                return false;
+            }
+
+            p += wrote;
+            size -= wrote;
+        }
+
+        return true;
+    }
+
+    /* Sort if needed, then write the header and records */
+    template <class P> static bool writeTable(int fd, std::vector<P> & routes,
+                                              uint8_t family)
+    {
+        if (std::is_sorted(routes.begin(), routes.end(),
+                           (bool (*)(const P &, const P &)) tableLess) == false)
+        {
+            std::sort(routes.begin(), routes.end(),
+                      (bool (*)(const P &, const P &)) tableLess);
+        }
+
+        size_t size = routes.size() * sizeof(P);
+        const void * p_records = routes.empty() ? NULL : &routes[0];
+        RouteTableHeader header;
+
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, RouteTable::MAGIC, sizeof(header.magic));
+        header.byte_order = RouteTable::BYTE_ORDER_MARK;
+        header.version = RouteTable::VERSION;
+        header.family = family;
+        header.record_size = sizeof(P);
+        header.count = routes.size();
+        header.checksum = RouteTable::checksum(p_records, size);
+
+        return writeAll(fd, &header, sizeof(header)) &&
+               writeAll(fd, p_records, size);
+    }
+
+    uint64_t RouteTable::checksum(const void * p_records, size_t size)
+    {
+        const uint64_t * p = (const uint64_t *) p_records;
+        const uint64_t * p_end = p + size / sizeof(uint64_t);
+        uint64_t hash = FNV_OFFSET;
+
+        for (; p < p_end; p++)
+        {
+            hash = (hash ^ *p) * FNV_PRIME;
+        }
+
+        return hash;
+    }
+
+    bool RouteTable::fail(const char * p_error)
+    {
+        close();
+        m_error = p_error;
+
+        return false;
+    }
+
+    bool RouteTable::load(const char * p_path)
+    {
+        close();
+
+        int fd = open(p_path, O_RDONLY);
+        struct stat st;
+
+        if (fd < 0)
+        {
+            return fail(strerror(errno));
+        }
+
+        if (fstat(fd, &st) != 0 || S_ISREG(st.st_mode) == false)
+        {
+            ::close(fd);
+            return fail("not a regular file");
+        }
+
+        if ((size_t) st.st_size < (size_t) HEADER_SIZE)
+        {
+            ::close(fd);
+            return fail("too short for a route table header");
+        }
+
+        m_map = mmap(0, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                     0);
+        ::close(fd);
+
+        if (m_map == MAP_FAILED)
+        {
+            m_map = NULL;
+            return fail(strerror(errno));
+        }
+
+        m_map_size = st.st_size;
+
+        const RouteTableHeader * p_header = (const RouteTableHeader *) m_map;
+        size_t record_size;
+
+        if (memcmp(p_header->magic, MAGIC, sizeof(MAGIC)) != 0)
+        {
+            return fail("not a route table");
+        }
+        else if (p_header->byte_order != BYTE_ORDER_MARK)
+        {
+            return fail("written with a different byte order");
+        }
+        else if (p_header->version != VERSION)
+        {
+            return fail("unsupported version");
+        }
+
+        if (p_header->family == 4)
+        {
+            record_size = sizeof(Route4Packed);
+        }
+        else if (p_header->family == 6)
+        {
+            record_size = sizeof(Route6Packed);
+        }
+        else
+        {
+            return fail("unknown address family");
+        }
+
+        size_t records = m_map_size - HEADER_SIZE;
+
+        if (p_header->record_size != record_size ||
+            p_header->count != records / record_size ||
+            records % record_size != 0)
+        {
+            return fail("size does not match the header");
+        }
+
+        const char * p_records = (const char *) m_map + HEADER_SIZE;
+
+        madvise(m_map, m_map_size, MADV_WILLNEED);
+
+        if (checksum(p_records, records) != p_header->checksum)
+        {
+            return fail("checksum mismatch");
+        }
+
+        m_family = p_header->family;
+        m_count = p_header->count;
+        m_error = NULL;
+
+        return true;
+    }
+
+    void RouteTable::close()
+    {
+        if (m_map != NULL)
+        {
+            munmap(m_map, m_map_size);
+        }
+
+        m_map = NULL;
+        m_map_size = 0;
+        m_family = 0;
+        m_count = 0;
+    }
+
+    bool RouteTable::getRoutes(Route4Packed * & p_routes, size_t & count) const
+    {
+        if (m_family != 4)
+        {
+            return false;
+        }
+
+        p_routes = (Route4Packed *) ((char *) m_map + HEADER_SIZE);
+        count = m_count;
+
+        return true;
+    }
+
+    bool RouteTable::getRoutes(Route6Packed * & p_routes, size_t & count) const
+    {
+        if (m_family != 6)
+        {
+            return false;
+        }
+
+        p_routes = (Route6Packed *) ((char *) m_map + HEADER_SIZE);
+        count = m_count;
+
+        return true;
+    }
+
+    RouteTable::RouteTable()
+                :
+                m_map(NULL), m_map_size(0), m_family(0), m_count(0),
+                m_error(NULL)
+    {
+    }
+
+    RouteTable::~RouteTable()
+    {
+        close();
+    }
+
+    void RouteTableWriter::add(const Route4 & rt)
+    {
+        m_routes4.push_back(Route4Packed(rt));
+    }
+
+    void RouteTableWriter::add(const Route6 & rt)
+    {
+        m_routes6.push_back(Route6Packed(rt));
+    }
+
+    void RouteTableWriter::add(const Route4Packed & rt)
+    {
+        m_routes4.push_back(rt);
+    }
+
+    void RouteTableWriter::add(const Route6Packed & rt)
+    {
+        m_routes6.push_back(rt);
+    }
+
+    size_t RouteTableWriter::size() const
+    {
+        return m_routes4.size() + m_routes6.size();
+    }
+
+    bool RouteTableWriter::write(int fd)
+    {
+        int family = m_family;
+
+        if (family == 0)
+        {
+            family = (m_routes6.empty() == false) ? 6 : 4;
+        }
+
+        if ((family == 4 && m_routes6.empty() == false) ||
+            (family == 6 && m_routes4.empty() == false) ||
+            (family != 4 && family != 6))
+        {
+            errno = EINVAL;
+            return false;
+        }
+        else if (family == 6)
+        {
+            return writeTable(fd, m_routes6, 6);
+        }
+
+        return writeTable(fd, m_routes4, 4);
+    }
+
+    void RouteTableWriter::clear()
+    {
+        m_routes4.clear();
+        m_routes6.clear();
+    }
+
+    RouteTableWriter::RouteTableWriter()
+                      :
+                      m_family(0)
+    {
+    }
+}
@@ -0,0 +1,160 @@
+/* routetable.hpp -- Binary route table files
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ROUTETABLE_H
+#define ROUTETABLE_H
+
+#include <vector>
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#include "route4.hpp"
+#include "route6.hpp"
+#include "route4packed.hpp"
+#include "route6packed.hpp"
+
+namespace IP
+{
+    /* A route table file is a 64 byte header followed by fixed-width
+     * records, each a Route4Packed (8 bytes) or a Route6Packed (24 bytes)
+     * exactly as held in memory. Records are sorted by network address,
+     * then prefix length, then metric, which is the order Acrs::summarize
+     * leaves routes in.
+     *
+     * Records and header fields are in the byte order of the machine that
+     * wrote the file. 'byte_order' holds BYTE_ORDER_MARK as written, so a
+     * file from a machine of the other byte order is recognised and
+     * refused rather than misread.
+     */
+    struct RouteTableHeader
+    {
+        char magic[8];          /* MAGIC, NUL padded */
+        uint32_t byte_order;
+        uint16_t version;
+        uint8_t family;         /* 4 or 6 */
+        uint8_t record_size;
+        uint64_t count;         /* Number of records */
+        uint64_t checksum;      /* RouteTable::checksum() of the records */
+        uint8_t reserved[32];   /* Zero */
+    };
+
+    /* Loads a route table file by mapping it. The records are used where
+     * they lie in the mapping, with no copy and no parsing. The mapping
+     * is private and writable, so the routes can be summarized in place
+     * without changing the file; only pages written to are copied.
+     */
+    class RouteTable
+    {
+        public:
+            enum
+            {
+                VERSION = 1,
+                HEADER_SIZE = 64,
+                BYTE_ORDER_MARK = 0x01020304
+            };
+
+            static const char MAGIC[8];
+
+            /* 64-bit FNV-1a taken a word at a time over 'size' bytes of
+             * records. 'size' is a multiple of 8.
+             */
+            static uint64_t checksum(const void * p_records, size_t size);
+
+            /* Map the file at 'p_path' and check its header, size and
+             * checksum. Returns false if it is not a valid table, and
+             * getError() says why.
+             */
+            bool load(const char * p_path);
+
+            /* Unmap the file. Routes obtained from the table are no longer
+             * valid.
+             */
+            void close();
+
+            const char * getError() const { return m_error; };
+            int getFamily() const { return m_family; };
+            size_t size() const { return m_count; };
+
+            /* The records, if the table holds routes of this family.
+             * Returns false otherwise.
+             */
+            bool getRoutes(Route4Packed * & p_routes, size_t & count) const;
+            bool getRoutes(Route6Packed * & p_routes, size_t & count) const;
+
+            /* Constructor */
+            RouteTable();
+
+            /* Destructor */
+            ~RouteTable();
+
+        private:
+            void * m_map;
+            size_t m_map_size;
+            int m_family;
+            size_t m_count;
+            const char * m_error;
+
+            bool fail(const char * p_error);
+
+            /* Not copyable, the mapping is owned */
+            RouteTable(const RouteTable &);
+            RouteTable & operator=(const RouteTable &);
+    };
+
+    /* Collects routes of one family and writes them out as a route table
+     * file, sorting them first if they are not already in order.
+     */
+    class RouteTableWriter
+    {
+        public:
+            void add(const Route4 & rt);
+            void add(const Route6 & rt);
+            void add(const Route4Packed & rt);
+            void add(const Route6Packed & rt);
+
+            size_t size() const;
+
+            /* The family written in the header, 4 or 6. If not set, it is
+             * taken from the routes added, which says nothing for an empty
+             * table, so IPv4 is assumed.
+             */
+            void setFamily(int family) { m_family = family; };
+            int getFamily() const { return m_family; };
+
+            /* Write the header and records to 'fd' with write(2). Returns
+             * false with errno set if a write failed, or with errno set to
+             * EINVAL if routes of both families were added, or routes of
+             * the other family to the one set.
+             */
+            bool write(int fd);
+
+            /* Remove the routes, keeping the family */
+            void clear();
+
+            /* Constructor */
+            RouteTableWriter();
+
+        private:
+            std::vector<Route4Packed> m_routes4;
+            std::vector<Route6Packed> m_routes6;
+            int m_family;       /* 0 if not set */
+    };
+}
+
+#endif /* ROUTETABLE_H */
@@ -0,0 +1,317 @@
+/* routewriter.cpp -- Buffered text output of routes
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <inttypes.h>
+
+#include "routewriter.hpp"
+
+namespace IP
+{
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+
+    /* Unsigned decimal, returning the new end */
+    static char * putDecimal(char * p, uint32_t value)
+    {
+        char digits[10];
+        int count = 0;
+
+        do
+        {
+            digits[count++] = '0' + value % 10;
+            value /= 10;
+        }
+        while (value != 0);
+
+        while (count > 0)
+        {
+            *p++ = digits[--count];
+        }
+
+        return p;
+    }
+
+    /* Hex without leading zeros, as inet_ntop() writes a group */
+    static char * putHexGroup(char * p, uint32_t group)
+    {
+        int shift = 12;
+
+        while (shift > 0 && (group >> shift) == 0)
+        {
+            shift -= 4;
+        }
+
+        for (; shift >= 0; shift -= 4)
+        {
+            *p++ = HEX_DIGITS[(group >> shift) & 0xf];
+        }
+
+        return p;
+    }
+
+    size_t RouteWriter::formatAddr4(char * buf, uint32_t addr)
+    {
+        char * p = buf;
+
+        for (int shift = 24; shift >= 0; shift -= 8)
+        {
+            p = putDecimal(p, (addr >> shift) & 0xff);
+
+            if (shift > 0)
+            {
+                *p++ = '.';
+            }
+        }
+
+        return p - buf;
+    }
+
+    /* The zero run compression and embedded IPv4 rules follow
+     * inet_ntop(), so output is the same as the routes' getAddrP().
+     */
+    size_t RouteWriter::formatAddr6(char * buf, uint64_t hi, uint64_t lo)
+    {
+        uint32_t words[8];
+
+        for (int i = 0; i < 4; i++)
+        {
+            words[i] = (hi >> (48 - 16 * i)) & 0xffff;
+            words[i + 4] = (lo >> (48 - 16 * i)) & 0xffff;
+        }
+
+        /* Longest run of zero groups, the first if there's a tie */
+        int best_base = -1;
+        int best_len = 0;
+        int cur_base = -1;
+        int cur_len = 0;
+
+        for (int i = 0; i <= 8; i++)
+        {
+            if (i < 8 && words[i] == 0)
+            {
+                if (cur_base == -1)
+                {
+                    cur_base = i;
+                    cur_len = 0;
+                }
+
+                cur_len++;
+            }
+            else if (cur_base != -1)
+            {
+                if (cur_len > best_len)
+                {
+                    best_base = cur_base;
+                    best_len = cur_len;
+                }
+
+                cur_base = -1;
+            }
+        }
+
+        if (best_len < 2)
+        {
+            best_base = -1;
+        }
+
+        char * p = buf;
+
+        for (int i = 0; i < 8; i++)
+        {
+            if (best_base != -1 && i >= best_base && i < best_base + best_len)
+            {
+                if (i == best_base)
+                {
+                    *p++ = ':';
+                }
+
+                continue;
+            }
+
+            if (i != 0)
+            {
+                *p++ = ':';
+            }
+
+            /* IPv4-compatible and IPv4-mapped addresses end in a quad */
+            if (i == 6 && best_base == 0 &&
+                (best_len == 6 || (best_len == 5 && words[5] == 0xffff)))
+            {
+                p += formatAddr4(p, (uint32_t) lo);
+                return p - buf;
+            }
+
+            p = putHexGroup(p, words[i]);
+        }
+
+        if (best_base != -1 && best_base + best_len == 8)
+        {
+            *p++ = ':';
+        }
+
+        return p - buf;
+    }
+
+    char * RouteWriter::reserve()
+    {
+        if (m_used + MAX_LINE > m_buffer.size())
+        {
+            flush();
+        }
+
+        char * p = &m_buffer[m_used];
+
+        if (m_mark != '\0')
+        {
+            *p++ = m_mark;
+            *p++ = ' ';
+        }
+
+        return p;
+    }
+
+    void RouteWriter::finish(char * p, uint32_t plen, int metric)
+    {
+        *p++ = '/';
+        p = putDecimal(p, plen);
+
+        switch (m_style)
+        {
+        case METRIC_FULL:
+            memcpy(p, " in ", 4);
+            p = putDecimal(p + 4, metric);
+            break;
+        case METRIC_BRIEF:
+            *p++ = 'm';
+            p = putDecimal(p, metric);
+            break;
+        default:
+            break;
+        }
+
+        *p++ = '\n';
+        m_used = p - &m_buffer[0];
+    }
+
+    void RouteWriter::write(const Route4 & rt)
+    {
+        char * p = reserve();
+        Addr4NetForm addr = (m_style == METRIC_BRIEF) ? rt.getAddrN() :
+                                                        rt.getNetworkN();
+
+        p += formatAddr4(p, ntohl(addr.getAddr()));
+        finish(p, rt.getPlen(), rt.getMetric());
+    }
+
+    void RouteWriter::write(const Route6 & rt)
+    {
+        char * p = reserve();
+        Addr6NetForm addr = (m_style == METRIC_BRIEF) ? rt.getAddrN() :
+                                                        rt.getNetworkN();
+
+        p += formatAddr6(p, addr.getHighWord(), addr.getLowWord());
+        finish(p, rt.getPlen(), rt.getMetric());
+    }
+
+    void RouteWriter::write(const Route4Packed & rt)
+    {
+        char * p = reserve();
+        uint32_t addr = (m_style == METRIC_BRIEF) ? rt.getAddrH() :
+                                                    rt.getNetworkH();
+
+        p += formatAddr4(p, addr);
+        finish(p, rt.getPlen(), rt.getMetric());
+    }
+
+    void RouteWriter::write(const Route6Packed & rt)
+    {
+        char * p = reserve();
+
+        if (m_style == METRIC_BRIEF)
+        {
+            p += formatAddr6(p, rt.getAddrHi(), rt.getAddrLo());
+        }
+        else
+        {
+            p += formatAddr6(p, rt.getNetworkHi(), rt.getNetworkLo());
+        }
+
+        finish(p, rt.getPlen(), rt.getMetric());
+    }
+
+    void RouteWriter::writeText(const char * p_text, size_t len)
+    {
+        while (len > 0)
+        {
+            if (m_used == m_buffer.size())
+            {
+                flush();
+            }
+
+            size_t room = m_buffer.size() - m_used;
+            size_t count = (len < room) ? len : room;
+
+            memcpy(&m_buffer[m_used], p_text, count);
+            m_used += count;
+            p_text += count;
+            len -= count;
+        }
+    }
+
+    bool RouteWriter::flush()
+    {
+        size_t done = 0;
+
+        while (m_failed == false && done < m_used)
+        {
+            ssize_t wrote = ::write(m_fd, &m_buffer[done], m_used - done);
+
+            if (wrote < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                m_failed = true;
+                break;
+            }
+
+            done += wrote;
+        }
+
+        m_used = 0;
+
+        return (m_failed == false);
+    }
+
+    RouteWriter::RouteWriter(int fd, Style style)
+        :
+        m_fd(fd), m_style(style), m_buffer(BUFFER_SIZE), m_used(0),
+        m_failed(false), m_mark('\0')
+    {
+    }
+
+    RouteWriter::~RouteWriter()
+    {
+        flush();
+    }
+}
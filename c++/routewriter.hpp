@@ -0,0 +1,108 @@
+/* routewriter.hpp -- Buffered text output of routes
+ *
+ * Copyright 2011 Patrick F. Allen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ROUTEWRITER_H
+#define ROUTEWRITER_H
+
+#include <vector>
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#include "route4.hpp"
+#include "route6.hpp"
+#include "route4packed.hpp"
+#include "route6packed.hpp"
+
+namespace IP
+{
+    /* Formats routes one per line into a reusable buffer and writes the
+     * buffer to a file descriptor with write(2) whenever it fills, and on
+     * flush(). Addresses and numbers are converted to text by hand, so
+     * nothing is allocated per route. The text is the same as the
+     * routes' own string forms.
+     */
+    class RouteWriter
+    {
+        public:
+            enum Style
+            {
+                METRIC_NONE,    /* NETWORK/PLEN, as Addr::str() */
+                METRIC_FULL,    /* NETWORK/PLEN in METRIC, as Route::str() */
+                METRIC_BRIEF    /* ADDRESS/PLENmMETRIC, host bits kept */
+            };
+
+            enum
+            {
+                BUFFER_SIZE = 1024 * 1024,
+                MAX_LINE = 64      /* Longest line any style can produce,
+                                    * mark included */
+            };
+
+            /* Address text without a terminating NUL, returning its
+             * length. 'buf' must have room for 15 (IPv4) or 39 (IPv6)
+             * characters. The IPv6 form matches inet_ntop().
+             */
+            static size_t formatAddr4(char * buf, uint32_t addr);
+            static size_t formatAddr6(char * buf, uint64_t hi, uint64_t lo);
+
+            void write(const Route4 & rt);
+            void write(const Route6 & rt);
+            void write(const Route4Packed & rt);
+            void write(const Route6Packed & rt);
+
+            /* Copy 'len' bytes of text as they are, such as the start of
+             * a line a route ends
+             */
+            void writeText(const char * p_text, size_t len);
+
+            /* Write out everything buffered. Returns false if a write
+             * failed, in which case all later output is discarded.
+             */
+            bool flush();
+
+            bool failed() const { return m_failed; };
+
+            /* Start every line written from now on with 'mark' and a
+             * space, as in "+ 10.0.0.0/8". A mark of '\0' stops this.
+             */
+            void setMark(char mark) { m_mark = mark; };
+
+            /* Constructor */
+            RouteWriter(int fd, Style style);
+
+            /* Destructor */
+            ~RouteWriter();
+
+        private:
+            int m_fd;
+            Style m_style;
+            std::vector<char> m_buffer;
+            size_t m_used;
+            bool m_failed;
+            char m_mark;
+
+            /* Room for one more line, flushing first if needed */
+            char * reserve();
+
+            /* End the line the caller has written an address into */
+            void finish(char * p, uint32_t plen, int metric);
+    };
+}
+
+#endif /* ROUTEWRITER_H */
@@ -0,0 +1,798 @@
+/* acrs-test.cpp */
+
+#include <list>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <sstream>
+
+#include "../acrs.hpp"
+#include "../acrsincremental.hpp"
+#include "../route4.hpp"
+#include "../route6.hpp"
+#include "acrs-test.hpp"
+
+void AcrsTest::mainSummary()
+{
+    std::list<IP::Route4> rt_list;
+    rt_list.push_back(IP::Route4("10.0.0.0", 24, IP::PLEN));
+    rt_list.push_back(IP::Route4("10.0.1.0", 24, IP::PLEN));
+    rt_list.push_back(IP::Route4("10.0.2.0", 24, IP::PLEN));
+    rt_list.push_back(IP::Route4("10.0.3.0", 24, IP::PLEN));
+    rt_list.push_back(IP::Route4("10.0.4.0", 24, IP::PLEN, 1));
+
+    Acrs::Acrs summary;
+    TEST_ASSERT(summary.summarize(rt_list) == true);
+    TEST_ASSERT(listStr(rt_list) == "10.0.0.0/22 in 0\n"
+                                    "10.0.4.0/24 in 1\n");
+}
+
+void AcrsTest::overlapSummary()
+{
+    std::list<IP::Route4> rt_list;
+    rt_list.push_back(IP::Route4("10.1.0.0", 16, IP::PLEN, 1));
+    rt_list.push_back(IP::Route4("10.0.0.0", 8, IP::PLEN, 1));
+    rt_list.push_back(IP::Route4("10.2.0.0", 16, IP::PLEN, 0));
+
+    Acrs::Acrs summary;
+    TEST_ASSERT(summary.summarize(rt_list) == true);
+    TEST_ASSERT(listStr(rt_list) == "10.0.0.0/8 in 1\n"
+                                    "10.2.0.0/16 in 0\n");
+}
+
+void AcrsTest::nestedOverlap()
+{
+    std::list<IP::Route4> rt_list;
+    rt_list.push_back(IP::Route4("10.0.0.0", 8, IP::PLEN, 1));
+    rt_list.push_back(IP::Route4("10.0.0.0", 16, IP::PLEN, 0));
+    rt_list.push_back(IP::Route4("10.0.1.0", 24, IP::PLEN, 1));
+    rt_list.push_back(IP::Route4("10.1.0.0", 16, IP::PLEN, 1));
+    rt_list.push_back(IP::Route4("10.2.0.0", 16, IP::PLEN, 0));
+    rt_list.push_back(IP::Route4("10.2.3.0", 24, IP::PLEN, 1));
+    rt_list.push_back(IP::Route4("10.3.0.0", 24, IP::PLEN, 1));
+
+    /* 10.1.0.0/16 and 10.3.0.0/24 follow routes that don't contain them,
+     * but still fall within 10.0.0.0/8.
+     */
+    std::string expected = "10.0.0.0/8 in 1\n"
+                           "10.0.0.0/16 in 0\n"
+                           "10.2.0.0/16 in 0\n";
+
+    Acrs::Acrs summary;
+    TEST_ASSERT(enginesAgree(rt_list) == true);
+    TEST_ASSERT(summary.summarize(rt_list) == true);
+    TEST_ASSERT(listStr(rt_list) == expected);
+}
+
+void AcrsTest::duplicates()
+{
+    std::list<IP::Route4> rt_list;
+    rt_list.push_back(IP::Route4("10.0.0.0", 24, IP::PLEN));
+    rt_list.push_back(IP::Route4("10.0.1.0", 24, IP::PLEN));
+    rt_list.push_back(IP::Route4("10.0.1.0", 24, IP::PLEN));
+
+    Acrs::Acrs summary;
+    TEST_ASSERT(summary.summarize(rt_list) == true);
+    TEST_ASSERT(listStr(rt_list) == "10.0.0.0/23 in 0\n");
+}
+
+void AcrsTest::enginesAgree4()
+{
+    std::list<IP::Route4> rt_list;
+    rt_list.push_back(IP::Route4("192.168.0.0", 25, IP::PLEN));
+    rt_list.push_back(IP::Route4("192.168.0.128", 25, IP::PLEN));
+    rt_list.push_back(IP::Route4("192.168.1.0", 24, IP::PLEN));
+    rt_list.push_back(IP::Route4("192.168.2.0", 23, IP::PLEN, 2));
+    rt_list.push_back(IP::Route4("192.168.3.7", 32, IP::PLEN, 1));
+    rt_list.push_back(IP::Route4("192.168.3.6", 32, IP::PLEN, 1));
+    rt_list.push_back(IP::Route4("192.168.0.0", 16, IP::PLEN, 3));
+    rt_list.push_back(IP::Route4("0.0.0.0", 0, IP::PLEN, 4));
+
+    TEST_ASSERT(enginesAgree(rt_list) == true);
+}
+
+void AcrsTest::enginesAgree6()
+{
+    std::list<IP::Route6> rt_list;
+    rt_list.push_back(IP::Route6("2001:db8::", 128, IP::PLEN));
+    rt_list.push_back(IP::Route6("2001:db8::1", 128, IP::PLEN));
+    rt_list.push_back(IP::Route6("2001:db8::2", 127, IP::PLEN));
+    rt_list.push_back(IP::Route6("2001:db8:1::", 48, IP::PLEN, 1));
+    rt_list.push_back(IP::Route6("2001:db8::", 48, IP::PLEN, 1));
+    rt_list.push_back(IP::Route6("2001:db8:1:2::", 64, IP::PLEN, 5));
+
+    TEST_ASSERT(enginesAgree(rt_list) == true);
+}
+
+void AcrsTest::vectorSummary()
+{
+    std::vector<IP::Route4> rt_vector;
+    rt_vector.push_back(IP::Route4("10.0.4.0", 24, IP::PLEN, 1));
+    rt_vector.push_back(IP::Route4("10.0.3.0", 24, IP::PLEN));
+    rt_vector.push_back(IP::Route4("10.0.0.0", 8, IP::PLEN, 2));
+    rt_vector.push_back(IP::Route4("10.0.1.0", 24, IP::PLEN));
+    rt_vector.push_back(IP::Route4("10.0.1.0", 24, IP::PLEN));
+    rt_vector.push_back(IP::Route4("10.0.2.0", 24, IP::PLEN));
+    rt_vector.push_back(IP::Route4("10.0.0.0", 24, IP::PLEN));
+
+    std::list<IP::Route4> rt_list(rt_vector.begin(), rt_vector.end());
+
+    Acrs::Acrs summary;
+    TEST_ASSERT(summary.summarize(rt_vector) == true);
+    TEST_ASSERT(summary.summarize(rt_list) == true);
+    TEST_ASSERT(listStr(rt_vector) == listStr(rt_list));
+
+    std::vector<IP::Route4> trie_vector(rt_vector);
+    summary.setEngine(Acrs::Acrs::ENGINE_TRIE);
+    TEST_ASSERT(summary.summarize(trie_vector) == false);
+    TEST_ASSERT(listStr(trie_vector) == listStr(rt_vector));
+}
+
+void AcrsTest::arraySummary()
+{
+    IP::Route6 routes[] =
+    {
+        IP::Route6("2001:db8::1", 128, IP::PLEN),
+        IP::Route6("2001:db8:1::", 48, IP::PLEN, 1),
+        IP::Route6("2001:db8::", 128, IP::PLEN),
+        IP::Route6("2001:db8::", 48, IP::PLEN, 1),
+        IP::Route6("2001:db8::2", 127, IP::PLEN)
+    };
+    const size_t count = sizeof(routes) / sizeof(routes[0]);
+
+    Acrs::Acrs summary;
+    IP::Route6 * last = summary.summarize(routes, routes + count);
+
+    TEST_ASSERT(listStr(std::vector<IP::Route6>(routes, last)) ==
+                "2001:db8::/47 in 1\n"
+                "2001:db8::/126 in 0\n");
+}
+
+void AcrsTest::packedSummary4()
+{
+    std::list<IP::Route4> rt_list;
+    rt_list.push_back(IP::Route4("192.168.0.1", 25, IP::PLEN));
+    rt_list.push_back(IP::Route4("192.168.0.128", 25, IP::PLEN));
+    rt_list.push_back(IP::Route4("192.168.1.0", 24, IP::PLEN));
+    rt_list.push_back(IP::Route4("192.168.1.0", 24, IP::PLEN));
+    rt_list.push_back(IP::Route4("192.168.2.0", 23, IP::PLEN, 2));
+    rt_list.push_back(IP::Route4("192.168.3.7", 32, IP::PLEN, 1));
+    rt_list.push_back(IP::Route4("192.168.3.6", 32, IP::PLEN, 1));
+    rt_list.push_back(IP::Route4("192.168.0.0", 16, IP::PLEN, 3));
+    rt_list.push_back(IP::Route4("0.0.0.0", 0, IP::PLEN, 4));
+
+    TEST_ASSERT(packedAgree<IP::Route4Packed>(rt_list) == true);
+}
+
+void AcrsTest::packedSummary6()
+{
+    std::list<IP::Route6> rt_list;
+    rt_list.push_back(IP::Route6("2001:db8::", 128, IP::PLEN));
+    rt_list.push_back(IP::Route6("2001:db8::1", 128, IP::PLEN));
+    rt_list.push_back(IP::Route6("2001:db8::3", 127, IP::PLEN));
+    rt_list.push_back(IP::Route6("2001:db8:1::", 48, IP::PLEN, 1));
+    rt_list.push_back(IP::Route6("2001:db8::", 48, IP::PLEN, 1));
+    rt_list.push_back(IP::Route6("2001:db8:1:2::", 64, IP::PLEN, 5));
+    rt_list.push_back(IP::Route6("::", 0, IP::PLEN, 7));
+
+    TEST_ASSERT(packedAgree<IP::Route6Packed>(rt_list) == true);
+}
+
+void AcrsTest::parallelSummary4()
+{
+    /* The /8s only merge across shards, in the boundary fix-up */
+    std::list<IP::Route4> rt_list;
+    rt_list.push_back(IP::Route4("10.0.0.0", 9, IP::PLEN));
+    rt_list.push_back(IP::Route4("10.128.0.0", 9, IP::PLEN));
+    rt_list.push_back(IP::Route4("11.0.0.0", 8, IP::PLEN));
+    rt_list.push_back(IP::Route4("10.1.0.0", 16, IP::PLEN, 2));
+    rt_list.push_back(IP::Route4("192.168.0.0", 25, IP::PLEN, 1));
+    rt_list.push_back(IP::Route4("192.168.0.128", 25, IP::PLEN, 1));
+    rt_list.push_back(IP::Route4("192.168.1.0", 24, IP::PLEN, 1));
+    rt_list.push_back(IP::Route4("192.168.3.0", 24, IP::PLEN, 3));
+    rt_list.push_back(IP::Route4("172.16.0.0", 12, IP::PLEN, 3));
+    rt_list.push_back(IP::Route4("128.0.0.0", 2, IP::PLEN, 2));
+    rt_list.push_back(IP::Route4("0.0.0.0", 0, IP::PLEN, 4));
+
+    std::string expected = "0.0.0.0/0 in 4\n"
+                           "10.0.0.0/7 in 0\n"
+                           "128.0.0.0/2 in 2\n"
+                           "192.168.0.0/23 in 1\n"
+                           "192.168.3.0/24 in 3\n";
+
+    Acrs::Acrs summary;
+    summary.setThreads(4);
+
+    TEST_ASSERT(threadsAgree(rt_list) == true);
+    TEST_ASSERT(summary.summarize(rt_list) == true);
+    TEST_ASSERT(listStr(rt_list) == expected);
+}
+
+void AcrsTest::parallelSummary6()
+{
+    std::list<IP::Route6> rt_list;
+    rt_list.push_back(IP::Route6("2001:db8::", 33, IP::PLEN));
+    rt_list.push_back(IP::Route6("2001:db8:8000::", 33, IP::PLEN));
+    rt_list.push_back(IP::Route6("2001:db9::", 32, IP::PLEN));
+    rt_list.push_back(IP::Route6("2001:db8:1::", 48, IP::PLEN, 1));
+    rt_list.push_back(IP::Route6("2001:db8:1::", 64, IP::PLEN));
+    rt_list.push_back(IP::Route6("2001:db8:1:1::", 64, IP::PLEN));
+    rt_list.push_back(IP::Route6("2001::", 16, IP::PLEN, 2));
+    rt_list.push_back(IP::Route6("::", 0, IP::PLEN, 7));
+
+    TEST_ASSERT(threadsAgree(rt_list) == true);
+}
+
+void AcrsTest::summaryStats()
+{
+    std::list<IP::Route4> rt_list;
+    rt_list.push_back(IP::Route4("10.0.0.0", 24, IP::PLEN));
+    rt_list.push_back(IP::Route4("10.0.1.0", 24, IP::PLEN));
+    rt_list.push_back(IP::Route4("10.0.2.0", 24, IP::PLEN));
+    rt_list.push_back(IP::Route4("10.0.3.0", 24, IP::PLEN));
+    rt_list.push_back(IP::Route4("10.0.3.0", 24, IP::PLEN));
+    rt_list.push_back(IP::Route4("10.0.4.0", 24, IP::PLEN, 1));
+    rt_list.push_back(IP::Route4("10.0.5.0", 24, IP::PLEN, 2));
+    rt_list.push_back(IP::Route4("10.0.0.0", 16, IP::PLEN, 1));
+
+    /* Every engine and thread count does the same work */
+    for (int engine = 0; engine < 2; engine++)
+    {
+        for (unsigned int threads = 1; threads <= 2; threads++)
+        {
+            std::list<IP::Route4> result = rt_list;
+            Acrs::Stats stats;
+
+            Acrs::Acrs summary;
+            summary.setEngine(static_cast<Acrs::Acrs::Engine>(engine));
+            summary.setThreads(threads);
+            summary.setStats(&stats);
+
+            TEST_ASSERT(summary.summarize(result) == true);
+            TEST_ASSERT(stats.merges == 3);
+            TEST_ASSERT(stats.duplicates == 1);
+            TEST_ASSERT(stats.overlaps == 2);
+            TEST_ASSERT(stats.input_routes == 8);
+            TEST_ASSERT(stats.input_plen[24] == 7);
+            TEST_ASSERT(stats.input_metric[0] == 5);
+            TEST_ASSERT(stats.output_routes == 2);
+            TEST_ASSERT(stats.output_plen[16] == 1);
+            TEST_ASSERT(stats.output_plen[22] == 1);
+            TEST_ASSERT(stats.output_metric[1] == 1);
+            TEST_ASSERT(stats.passes > 0);
+            TEST_ASSERT(stats.total.wall >= 0);
+        }
+    }
+}
+
+void AcrsTest::radixSort4()
+{
+    std::list<IP::Route4> rt_list;
+    rt_list.push_back(IP::Route4("10.0.1.0", 24, IP::PLEN, 2));
+    rt_list.push_back(IP::Route4("10.0.0.7", 24, IP::PLEN));
+    rt_list.push_back(IP::Route4("192.168.3.7", 32, IP::PLEN, 65535));
+    rt_list.push_back(IP::Route4("10.0.0.9", 24, IP::PLEN));
+    rt_list.push_back(IP::Route4("0.0.0.0", 0, IP::PLEN, 65535));
+    rt_list.push_back(IP::Route4("10.0.0.0", 8, IP::PLEN, 2));
+    rt_list.push_back(IP::Route4("10.0.0.3", 24, IP::PLEN));
+    rt_list.push_back(IP::Route4("255.255.255.255", 32, IP::PLEN));
+    rt_list.push_back(IP::Route4("10.0.0.0", 24, IP::PLEN, 1));
+    rt_list.push_back(IP::Route4("1.2.3.4", 0, IP::PLEN));
+
+    /* The three 10.0.0.0/24 in 0 differ only in host bits */
+    TEST_ASSERT(sortsAgree(rt_list, Acrs::ORDER_ACRS) == true);
+    TEST_ASSERT(sortsAgree(rt_list, Acrs::ORDER_OVERLAP) == true);
+
+    Acrs::radixSort(rt_list, Acrs::ORDER_OVERLAP);
+    TEST_ASSERT(rt_list.front().getPlen() == 0);
+    TEST_ASSERT(rt_list.front().getMetric() == 0);
+    TEST_ASSERT(rt_list.back().getPlen() == 32);
+    TEST_ASSERT(rt_list.back().getMetric() == 0);
+}
+
+void AcrsTest::radixSort6()
+{
+    std::list<IP::Route6> rt_list;
+    rt_list.push_back(IP::Route6("2001:db8::1", 64, IP::PLEN, 65535));
+    rt_list.push_back(IP::Route6("ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff",
+                                 128, IP::PLEN));
+    rt_list.push_back(IP::Route6("2001:db8::2", 64, IP::PLEN, 65535));
+    rt_list.push_back(IP::Route6("::", 0, IP::PLEN, 3));
+    rt_list.push_back(IP::Route6("2001:db8::", 128, IP::PLEN));
+    rt_list.push_back(IP::Route6("2001:db8::1:0:0:1", 127, IP::PLEN));
+    rt_list.push_back(IP::Route6("2001:db8::", 32, IP::PLEN, 65535));
+    rt_list.push_back(IP::Route6("2001:db8::3", 64, IP::PLEN, 65535));
+    rt_list.push_back(IP::Route6("::1", 0, IP::PLEN));
+    rt_list.push_back(IP::Route6("2001:db8:0:1::", 64, IP::PLEN));
+
+    /* The three 2001:db8::/64 in 65535 differ only in host bits, and
+     * only the low 64 bits of the network tell some routes apart
+     */
+    TEST_ASSERT(sortsAgree(rt_list, Acrs::ORDER_ACRS) == true);
+    TEST_ASSERT(sortsAgree(rt_list, Acrs::ORDER_OVERLAP) == true);
+
+    Acrs::radixSort(rt_list, Acrs::ORDER_ACRS);
+    TEST_ASSERT(rt_list.front().getPlen() == 128);
+    TEST_ASSERT(rt_list.back().getPlen() == 32);
+    TEST_ASSERT(rt_list.back().getMetric() == 65535);
+}
+
+void AcrsTest::incrementalDelta()
+{
+    Acrs::IncrementalSummary<IP::Route4> summary;
+    std::vector<IP::Route4> added;
+    std::vector<IP::Route4> removed;
+
+    summary.add(IP::Route4("10.0.0.0", 24, IP::PLEN));
+    summary.add(IP::Route4("10.0.1.0", 24, IP::PLEN));
+    summary.add(IP::Route4("10.0.2.0", 24, IP::PLEN, 1));
+    summary.flush(added, removed);
+
+    TEST_ASSERT(listStr(added) == "10.0.0.0/23 in 0\n"
+                                  "10.0.2.0/24 in 1\n");
+    TEST_ASSERT(removed.empty() == true);
+
+    /* Completing the /22 replaces both summaries */
+    added.clear();
+    summary.add(IP::Route4("10.0.2.0", 24, IP::PLEN));
+    summary.add(IP::Route4("10.0.3.0", 24, IP::PLEN));
+    summary.flush(added, removed);
+
+    TEST_ASSERT(listStr(added) == "10.0.0.0/22 in 0\n");
+    TEST_ASSERT(listStr(removed) == "10.0.0.0/23 in 0\n"
+                                    "10.0.2.0/24 in 1\n");
+
+    /* A change undone before the flush is not reported */
+    added.clear();
+    removed.clear();
+    summary.add(IP::Route4("10.0.4.0", 24, IP::PLEN, 3));
+    TEST_ASSERT(summary.withdraw(IP::Route4("10.0.4.0", 24, IP::PLEN,
+                                            3)) == true);
+    summary.flush(added, removed);
+
+    TEST_ASSERT(added.empty() == true && removed.empty() == true);
+
+    /* Only routes that were added can be withdrawn */
+    TEST_ASSERT(summary.withdraw(IP::Route4("10.0.4.0", 24, IP::PLEN,
+                                            3)) == false);
+    TEST_ASSERT(summary.withdraw(IP::Route4("10.0.3.0", 24, IP::PLEN,
+                                            1)) == false);
+    TEST_ASSERT(summary.size() == 5);
+
+    /* Withdrawing one half uncovers the route of metric 1 again */
+    TEST_ASSERT(summary.withdraw(IP::Route4("10.0.3.0", 24, IP::PLEN)));
+    summary.flush(added, removed);
+
+    TEST_ASSERT(listStr(added) == "10.0.0.0/23 in 0\n"
+                                  "10.0.2.0/24 in 0\n");
+    TEST_ASSERT(listStr(removed) == "10.0.0.0/22 in 0\n");
+
+    std::vector<IP::Route4> current;
+    summary.getSummary(current);
+
+    TEST_ASSERT(listStr(current) == listStr(added));
+}
+
+void AcrsTest::incrementalChurn()
+{
+    Acrs::IncrementalSummary<IP::Route4Packed> summary;
+    std::vector<IP::Route4Packed> routes;
+    std::vector<IP::Route4Packed> added;
+    std::vector<IP::Route4Packed> removed;
+    uint32_t seed = 12345;
+    bool agree = true;
+
+    for (int step = 0; step < 3000 && agree; step++)
+    {
+        seed = seed * 1103515245 + 12345;
+        uint32_t bits = seed >> 8;
+
+        if (routes.empty() == true || (bits & 3) != 0)
+        {
+            /* Prefixes of 10.0/16 between /18 and /24, metrics 0 to 2 */
+            IP::Route4Packed rt(htonl(0x0a000000 | (bits & 0xffff) << 8),
+                                18 + (bits >> 16) % 7, (bits >> 20) % 3);
+            summary.add(rt);
+            routes.push_back(rt);
+        }
+        else
+        {
+            size_t i = (bits >> 2) % routes.size();
+            agree = summary.withdraw(routes[i]);
+            routes.erase(routes.begin() + i);
+        }
+
+        if (step % 50 != 49)
+        {
+            continue;
+        }
+
+        /* Flushed deltas and a full summary must both match */
+        std::vector<IP::Route4Packed> full = routes;
+        std::vector<IP::Route4Packed> current;
+
+        Acrs::Acrs acrs;
+        acrs.summarize(full);
+        summary.getSummary(current);
+        summary.flush(added, removed);
+
+        agree = agree && (listStr(full) == listStr(current)) &&
+                (summary.size() == routes.size());
+    }
+
+    TEST_ASSERT(agree == true);
+
+    /* Applying every delta in turn leaves the current summary */
+    std::list<std::string> applied;
+
+    for (size_t i = 0; i < added.size(); i++)
+    {
+        applied.push_back(added[i].str());
+    }
+
+    for (size_t i = 0; i < removed.size(); i++)
+    {
+        std::list<std::string>::iterator iter =
+            std::find(applied.begin(), applied.end(), removed[i].str());
+
+        TEST_ASSERT(iter != applied.end());
+
+        if (iter != applied.end())
+        {
+            applied.erase(iter);
+        }
+    }
+
+    std::vector<IP::Route4Packed> current;
+    summary.getSummary(current);
+
+    TEST_ASSERT(applied.size() == current.size());
+}
+
+void AcrsTest::diffPrefixes()
+{
+    std::list<IP::Route4> old_list;
+    std::vector<IP::Route4Packed> new_list;
+    Acrs::RouteDiff<IP::Route4> diff;
+
+    old_list.push_back(IP::Route4("10.0.0.0", 24, IP::PLEN));
+    old_list.push_back(IP::Route4("10.0.1.0", 24, IP::PLEN, 1));
+    old_list.push_back(IP::Route4("192.168.0.0", 16, IP::PLEN));
+
+    /* Out of order, so it is sorted first */
+    new_list.push_back(IP::Route4Packed(inet_addr("192.168.0.0"), 16));
+    new_list.push_back(IP::Route4Packed(inet_addr("10.0.1.0"), 24, 2));
+    new_list.push_back(IP::Route4Packed(inet_addr("10.0.0.1"), 23));
+
+    diff.diffPrefixes(old_list.begin(), old_list.end(), new_list.begin(),
+                      new_list.end());
+
+    TEST_ASSERT(listStr(diff.removed) == "10.0.0.0/24 in 0\n");
+    TEST_ASSERT(listStr(diff.added) == "10.0.0.0/23 in 0\n");
+    TEST_ASSERT(diff.changed.size() == 1);
+
+    if (diff.changed.size() == 1)
+    {
+        TEST_ASSERT(diff.changed[0].first.str() == "10.0.1.0/24 in 1");
+        TEST_ASSERT(diff.changed[0].second.str() == "10.0.1.0/24 in 2");
+    }
+
+    /* Host bits don't count */
+    diff.diffPrefixes(new_list.begin(), new_list.end(), new_list.begin(),
+                      new_list.end());
+    TEST_ASSERT(diff.empty() == true);
+}
+
+void AcrsTest::diffSpace()
+{
+    std::list<IP::Route6> old_list;
+    std::list<IP::Route6> new_list;
+    Acrs::RouteDiff<IP::Route6Packed> diff;
+
+    old_list.push_back(IP::Route6("2001:db8::", 32, IP::PLEN));
+    old_list.push_back(IP::Route6("2001:db8:1::", 48, IP::PLEN, 1));
+
+    new_list.push_back(IP::Route6("2001:db8::", 33, IP::PLEN));
+    new_list.push_back(IP::Route6("2001:db8:8000::", 33, IP::PLEN));
+    new_list.push_back(IP::Route6("2001:db8:1::", 48, IP::PLEN, 1));
+
+    /* The same space split differently is no change */
+    diff.diffSpace(old_list.begin(), old_list.end(), new_list.begin(),
+                   new_list.end());
+    TEST_ASSERT(diff.empty() == true);
+
+    /* A default route covers all but 2001:db8::/32, and the first
+     * quarter of that, less the /48, now falls to it
+     */
+    new_list.pop_front();
+    new_list.push_front(IP::Route6("2001:db8:4000::", 34, IP::PLEN));
+    new_list.push_front(IP::Route6("::", 0, IP::PLEN, 5));
+
+    diff.diffSpace(old_list.begin(), old_list.end(), new_list.begin(),
+                   new_list.end());
+
+    TEST_ASSERT(diff.removed.empty() == true);
+    TEST_ASSERT(diff.added.size() == 32);
+    TEST_ASSERT(diff.changed.size() == 14);
+
+    if (diff.added.size() == 32 && diff.changed.size() == 14)
+    {
+        TEST_ASSERT(diff.added[0].str() == "::/3 in 5");
+        TEST_ASSERT(diff.added[31].str() == "8000::/1 in 5");
+        TEST_ASSERT(diff.changed[0].first.str() == "2001:db8::/48 in 0");
+        TEST_ASSERT(diff.changed[0].second.str() == "2001:db8::/48 in 5");
+        TEST_ASSERT(diff.changed[1].second.str() ==
+                    "2001:db8:2::/47 in 5");
+        TEST_ASSERT(diff.changed[13].second.str() ==
+                    "2001:db8:2000::/35 in 5");
+    }
+}
+
+void AcrsTest::verifySummary()
+{
+    std::list<IP::Route4> rt_list;
+    rt_list.push_back(IP::Route4("10.0.0.0", 24, IP::PLEN, 1));
+    rt_list.push_back(IP::Route4("10.0.1.0", 24, IP::PLEN, 1));
+    rt_list.push_back(IP::Route4("10.0.0.128", 25, IP::PLEN, 2));
+    rt_list.push_back(IP::Route4("10.0.2.0", 23, IP::PLEN));
+    rt_list.push_back(IP::Route4("10.0.0.0", 8, IP::PLEN, 3));
+    rt_list.push_back(IP::Route4("255.255.255.255", 32, IP::PLEN));
+
+    for (int engine = 0; engine < 2; engine++)
+    {
+        std::list<IP::Route4> result = rt_list;
+        Acrs::Verifier verifier;
+        Acrs::Acrs acrs;
+        acrs.setEngine(static_cast<Acrs::Acrs::Engine>(engine));
+
+        verifier.setInput(result.begin(), result.end());
+        acrs.summarize(result);
+        TEST_ASSERT(verifier.check(result.begin(), result.end()) == true);
+    }
+
+    /* Nothing routed past the last route */
+    std::vector<IP::Route6Packed> input;
+    std::vector<IP::Route6Packed> output;
+    Acrs::Verifier verifier;
+
+    in6_addr addr;
+    inet_pton(AF_INET6, "2001:db8::", &addr);
+    input.push_back(IP::Route6Packed(addr, 32, 1));
+    inet_pton(AF_INET6, "2001:db8:8000::", &addr);
+    input.push_back(IP::Route6Packed(addr, 33));
+    output.push_back(IP::Route6Packed(addr, 33));
+
+    verifier.setInput(input.begin(), input.end());
+    TEST_ASSERT(verifier.check(output.begin(), output.end()) == false);
+    TEST_ASSERT(verifier.input_metric == 1);
+    TEST_ASSERT(verifier.output_metric == Acrs::Verifier::NO_METRIC);
+    TEST_ASSERT(IP::Route6Packed(Acrs::keyAddr6(verifier.start), 128)
+                    .getAddrP() == "2001:db8::");
+    TEST_ASSERT(IP::Route6Packed(Acrs::keyAddr6(verifier.end), 128)
+                    .getAddrP() == "2001:db8:7fff:ffff:ffff:ffff:ffff:ffff");
+
+    /* A worse metric over part of the space */
+    inet_pton(AF_INET6, "2001:db8::", &addr);
+    output.push_back(IP::Route6Packed(addr, 34, 2));
+    inet_pton(AF_INET6, "2001:db8:4000::", &addr);
+    output.push_back(IP::Route6Packed(addr, 34, 1));
+
+    TEST_ASSERT(verifier.check(output.begin(), output.end()) == false);
+    TEST_ASSERT(verifier.input_metric == 1);
+    TEST_ASSERT(verifier.output_metric == 2);
+    TEST_ASSERT(IP::Route6Packed(Acrs::keyAddr6(verifier.end), 128)
+                    .getAddrP() == "2001:db8:3fff:ffff:ffff:ffff:ffff:ffff");
+
+    /* Covered by a better route, the worse metric no longer counts */
+    inet_pton(AF_INET6, "2001:db8::", &addr);
+    output.push_back(IP::Route6Packed(addr, 32, 1));
+    TEST_ASSERT(verifier.check(output.begin(), output.end()) == true);
+}
+
+void AcrsTest::budgetSummary()
+{
+    std::list<IP::Route4> rt_list;
+    rt_list.push_back(IP::Route4("10.0.0.0", 24, IP::PLEN, 1));
+    rt_list.push_back(IP::Route4("10.0.2.0", 24, IP::PLEN, 1));
+    rt_list.push_back(IP::Route4("10.0.3.0", 24, IP::PLEN, 2));
+    rt_list.push_back(IP::Route4("10.0.5.0", 24, IP::PLEN, 1));
+    rt_list.push_back(IP::Route4("10.0.1.0", 25, IP::PLEN));
+
+    for (int engine = 0; engine < 2; engine++)
+    {
+        std::list<IP::Route4> result = rt_list;
+        Acrs::Acrs acrs;
+        acrs.setEngine(static_cast<Acrs::Acrs::Engine>(engine));
+
+        /* Exact summarization already fits */
+        acrs.setMaxRoutes(5);
+        TEST_ASSERT(acrs.summarize(result) == false);
+        TEST_ASSERT(acrs.getExtraSpace() == 0);
+
+        /* The /22 adds the least space, the half of 10.0.1.0/24 no route
+         * covered. It drops the /24 with a higher metric and keeps the
+         * /25 with a lower one.
+         */
+        acrs.setMaxRoutes(3);
+        TEST_ASSERT(acrs.summarize(result) == true);
+        TEST_ASSERT(listStr(result) == "10.0.0.0/22 in 1\n"
+                                      "10.0.1.0/25 in 0\n"
+                                      "10.0.5.0/24 in 1\n");
+        TEST_ASSERT(acrs.getExtraSpace() == 128);
+
+        /* The extra space fails an exact check, but no address the input
+         * routed has a worse metric. The other way round, addresses are
+         * left unrouted.
+         */
+        Acrs::Verifier verifier;
+        verifier.setInput(rt_list.begin(), rt_list.end());
+        TEST_ASSERT(verifier.check(result.begin(), result.end()) == false);
+
+        verifier.setCompare(Acrs::Verifier::COMPARE_NO_WORSE);
+        TEST_ASSERT(verifier.check(result.begin(), result.end()) == true);
+
+        verifier.setInput(result.begin(), result.end());
+        TEST_ASSERT(verifier.check(rt_list.begin(), rt_list.end()) == false);
+        TEST_ASSERT(verifier.output_metric == Acrs::Verifier::NO_METRIC);
+
+        /* Only one route of metric 1 can be left */
+        acrs.setMaxRoutes(1);
+        TEST_ASSERT(acrs.summarize(result) == true);
+        TEST_ASSERT(listStr(result) == "10.0.0.0/21 in 1\n"
+                                      "10.0.1.0/25 in 0\n");
+        TEST_ASSERT(acrs.getExtraSpace() == 768);
+
+        /* Space routed at another metric is not extra */
+        std::list<IP::Route4> covered;
+        covered.push_back(IP::Route4("10.0.0.0", 24, IP::PLEN, 1));
+        covered.push_back(IP::Route4("10.0.3.0", 24, IP::PLEN, 1));
+        covered.push_back(IP::Route4("10.0.1.0", 24, IP::PLEN, 2));
+        covered.push_back(IP::Route4("10.0.2.0", 24, IP::PLEN, 2));
+
+        acrs.setMaxRoutes(3);
+        TEST_ASSERT(acrs.summarize(covered) == true);
+        TEST_ASSERT(listStr(covered) == "10.0.0.0/22 in 1\n");
+        TEST_ASSERT(acrs.getExtraSpace() == 0);
+    }
+}
+
+void AcrsTest::ortcSummary()
+{
+    std::list<IP::Route4> rt_list;
+    rt_list.push_back(IP::Route4("10.0.0.0", 24, IP::PLEN, 1));
+    rt_list.push_back(IP::Route4("10.0.1.0", 24, IP::PLEN, 1));
+    rt_list.push_back(IP::Route4("10.0.2.0", 24, IP::PLEN, 2));
+    rt_list.push_back(IP::Route4("10.0.3.0", 24, IP::PLEN, 1));
+
+    std::list<IP::Route4> result = rt_list;
+    Acrs::Verifier verifier;
+    Acrs::Acrs acrs;
+    acrs.setEngine(Acrs::Acrs::ENGINE_ORTC);
+    verifier.setMatch(Acrs::Verifier::MATCH_LONGEST);
+
+    /* The /24 with another next hop punches a hole in the /22 */
+    verifier.setInput(result.begin(), result.end());
+    TEST_ASSERT(acrs.summarize(result) == true);
+    TEST_ASSERT(listStr(result) == "10.0.0.0/22 in 1\n"
+                                  "10.0.2.0/24 in 2\n");
+    TEST_ASSERT(verifier.check(result.begin(), result.end()) == true);
+
+    /* A longer prefix with a higher metric still forwards its addresses,
+     * and the lowest metric given for a prefix wins
+     */
+    rt_list.push_back(IP::Route4("10.0.0.0", 8, IP::PLEN, 2));
+    rt_list.push_back(IP::Route4("10.1.0.0", 16, IP::PLEN, 3));
+    rt_list.push_back(IP::Route4("10.1.0.0", 16, IP::PLEN, 4));
+
+    result = rt_list;
+    verifier.setInput(result.begin(), result.end());
+    TEST_ASSERT(acrs.summarize(result) == true);
+    TEST_ASSERT(listStr(result) == "10.0.0.0/8 in 2\n"
+                                  "10.0.0.0/22 in 1\n"
+                                  "10.0.2.0/24 in 2\n"
+                                  "10.1.0.0/16 in 3\n");
+    TEST_ASSERT(verifier.check(result.begin(), result.end()) == true);
+
+    /* By best metric the /22 would win over the hole punched in it */
+    verifier.setMatch(Acrs::Verifier::MATCH_BEST);
+    verifier.setInput(rt_list.begin(), rt_list.end());
+    TEST_ASSERT(verifier.check(result.begin(), result.end()) == false);
+    TEST_ASSERT(verifier.input_metric == 2);
+    TEST_ASSERT(verifier.output_metric == 1);
+}
+
+void AcrsTest::arenaSummary()
+{
+    typedef Acrs::ArenaAllocator<IP::Route4> Allocator;
+
+    const char * prefixes[] = { "10.0.0.0", "10.0.1.0", "10.0.2.0",
+                                "10.0.3.0", "10.0.4.0" };
+
+    for (int engine = 0; engine < 3; engine++)
+    {
+        Acrs::Arena arena(Acrs::Arena::BACK_ARENA);
+        std::list<IP::Route4, Allocator> rt_list((Allocator(&arena)));
+        std::list<IP::Route4> expected;
+        Acrs::Acrs acrs;
+        acrs.setEngine(static_cast<Acrs::Acrs::Engine>(engine));
+
+        for (int i = 0; i < 5; i++)
+        {
+            rt_list.push_back(IP::Route4(prefixes[i], 24, IP::PLEN));
+            expected.push_back(rt_list.back());
+        }
+
+        acrs.summarize(rt_list);
+        acrs.summarize(expected);
+        TEST_ASSERT(listStr(rt_list) == listStr(expected));
+
+        /* Every route came from one block, and freed routes are reused */
+        const Acrs::ArenaCounts & counts = arena.getCounts();
+        size_t freed = counts.frees;
+
+        TEST_ASSERT(counts.system == 1);
+        TEST_ASSERT(freed >= 3);
+
+        for (size_t i = 0; i < freed; i++)
+        {
+            rt_list.push_back(IP::Route4("10.0.8.0", 24, IP::PLEN));
+        }
+
+        TEST_ASSERT(counts.reused == freed);
+        TEST_ASSERT(counts.system == 1);
+    }
+
+    /* On the heap, every allocation goes to the system */
+    Acrs::Arena arena;
+    std::list<IP::Route4, Allocator> rt_list((Allocator(&arena)));
+    rt_list.push_back(IP::Route4("10.0.0.0", 24, IP::PLEN));
+    rt_list.push_back(IP::Route4("10.0.1.0", 24, IP::PLEN));
+    rt_list.pop_back();
+    rt_list.push_back(IP::Route4("10.0.1.0", 24, IP::PLEN));
+
+    TEST_ASSERT(arena.getCounts().allocations == 3);
+    TEST_ASSERT(arena.getCounts().frees == 1);
+    TEST_ASSERT(arena.getCounts().system == 3);
+}
+
+void AcrsTest::memoryProfile()
+{
+    Acrs::MemProfile profile;
+    std::list<IP::Route4> rt_list;
+
+    profile.start("parse");
+    rt_list.push_back(IP::Route4("10.0.0.0", 24, IP::PLEN));
+    rt_list.push_back(IP::Route4("10.0.1.0", 24, IP::PLEN));
+
+    /* The hooks are linked into the tests */
+    Acrs::MemUsage usage = Acrs::MemUsage::now();
+    TEST_ASSERT(Acrs::allocCounters().hooked == true);
+    TEST_ASSERT(usage.allocations >= 2);
+    TEST_ASSERT(usage.rss > 0);
+    TEST_ASSERT(usage.peak_rss >= usage.rss);
+
+    /* Summarizing records what it allocated */
+    Acrs::Stats stats;
+    Acrs::Acrs acrs;
+    acrs.setStats(&stats);
+
+    profile.start("summarize");
+    acrs.summarize(rt_list);
+    TEST_ASSERT(stats.allocations > 0);
+    TEST_ASSERT(stats.allocated_bytes > 0);
+    TEST_ASSERT(stats.peak_rss > 0);
+
+    std::ostringstream json;
+    profile.writeJson(json, 2, "parse");
+    TEST_ASSERT(json.str().find("\"routes\": 2,") != std::string::npos);
+    TEST_ASSERT(json.str().find("\"summarize\": {\"allocations\": ") !=
+                std::string::npos);
+    TEST_ASSERT(json.str().find("\"bytes_per_route\": ") !=
+                std::string::npos);
+
+    /* Size classes are named by the largest size they hold */
+    TEST_ASSERT(Acrs::AllocCounters::sizeClass(8) == 0);
+    TEST_ASSERT(Acrs::AllocCounters::sizeClass(9) == 1);
+    TEST_ASSERT(Acrs::AllocCounters::sizeClass((size_t) 1 << 40) ==
+                Acrs::AllocCounters::SIZE_CLASSES - 1);
+}
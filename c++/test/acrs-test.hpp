@@ -0,0 +1,241 @@
+/* acrs-test.hpp */
+
+#ifndef ACRSTEST_H
+#define ACRSTEST_H
+
+#include <list>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <cpptest.h>
+
+#include "../acrs.hpp"
+#include "../acrsdiff.hpp"
+#include "../acrsverify.hpp"
+#include "../acrsarena.hpp"
+#include "../acrsmem.hpp"
+#include "../acrsincremental.hpp"
+#include "../route4.hpp"
+#include "../route6.hpp"
+#include "../route4packed.hpp"
+#include "../route6packed.hpp"
+
+class AcrsTest : public Test::Suite
+{
+private:
+    /* Tests */
+    void mainSummary();
+    void overlapSummary();
+    void nestedOverlap();
+    void duplicates();
+    void enginesAgree4();
+    void enginesAgree6();
+    void vectorSummary();
+    void arraySummary();
+    void packedSummary4();
+    void packedSummary6();
+    void parallelSummary4();
+    void parallelSummary6();
+    void summaryStats();
+    void radixSort4();
+    void radixSort6();
+    void incrementalDelta();
+    void incrementalChurn();
+    void diffPrefixes();
+    void diffSpace();
+    void verifySummary();
+    void budgetSummary();
+    void ortcSummary();
+    void arenaSummary();
+    void memoryProfile();
+
+    /* Helper functions */
+    template <class T> static std::string listStr(const T & rt_list)
+    {
+        std::string s;
+
+        for (typename T::const_iterator iter = rt_list.begin();
+             iter != rt_list.end();
+             iter++)
+        {
+            s += iter->str() + "\n";
+        }
+
+        return s;
+    }
+
+    template <class T> static bool enginesAgree(const T & rt_list)
+    {
+        T pass_list = rt_list;
+        T trie_list = rt_list;
+
+        Acrs::Acrs pass_acrs;
+        Acrs::Acrs trie_acrs;
+        trie_acrs.setEngine(Acrs::Acrs::ENGINE_TRIE);
+
+        bool pass_sum = pass_acrs.summarize(pass_list);
+        bool trie_sum = trie_acrs.summarize(trie_list);
+
+        return (pass_sum == trie_sum) &&
+               (listStr(pass_list) == listStr(trie_list));
+    }
+
+    /* Sort a copy of a list with radixSort(), a vector with
+     * radixSortRange() and another copy with std::list::sort() and the
+     * comparator for the order. All three must match, host bits included,
+     * so routes with equal keys keep their order as in a stable sort. Each
+     * pair of keys must also compare as the comparator does.
+     */
+    template <class T> static bool sortsAgree(const T & rt_list,
+                                              Acrs::SortOrder order)
+    {
+        typedef typename T::value_type Route;
+
+        bool (*cmp)(const Route &, const Route &) =
+            (order == Acrs::ORDER_ACRS) ? &Acrs::Acrs::acrsCmp<Route> :
+                                          &Acrs::Acrs::overlapCmp<Route>;
+
+        T expected = rt_list;
+        T radix_list = rt_list;
+        std::vector<Route> radix_vector(rt_list.begin(), rt_list.end());
+
+        expected.sort(cmp);
+        Acrs::radixSort(radix_list, order);
+        Acrs::radixSortRange(radix_vector.begin(), radix_vector.end(), order);
+
+        bool agree = (listStr(radix_list) == listStr(expected)) &&
+                     (listStr(radix_vector) == listStr(expected));
+
+        typename T::const_iterator exp_iter = expected.begin();
+        typename T::const_iterator list_iter = radix_list.begin();
+
+        for (size_t i = 0; i < radix_vector.size() && agree; i++)
+        {
+            agree = (exp_iter->getAddrP() == list_iter->getAddrP()) &&
+                    (exp_iter->getAddrP() == radix_vector[i].getAddrP());
+            exp_iter++;
+            list_iter++;
+        }
+
+        for (typename T::const_iterator a = rt_list.begin();
+             a != rt_list.end() && agree;
+             a++)
+        {
+            Acrs::SortKey a_key = Acrs::makeSortKey(*a, order);
+
+            for (typename T::const_iterator b = rt_list.begin();
+                 b != rt_list.end() && agree;
+                 b++)
+            {
+                Acrs::SortKey b_key = Acrs::makeSortKey(*b, order);
+
+                agree = (std::lexicographical_compare(a_key.word,
+                             a_key.word + Acrs::SortKey::WORDS, b_key.word,
+                             b_key.word + Acrs::SortKey::WORDS) ==
+                         cmp(*a, *b));
+            }
+        }
+
+        return agree;
+    }
+
+    /* Summarize a list of full routes and a vector of packed copies with
+     * both engines. All four results must match, host bits included.
+     */
+    template <class P, class T> static bool packedAgree(const T & rt_list)
+    {
+        bool agree = true;
+
+        for (int engine = 0; engine < 2; engine++)
+        {
+            T full = rt_list;
+            std::vector<P> packed;
+
+            for (typename T::const_iterator iter = rt_list.begin();
+                 iter != rt_list.end();
+                 iter++)
+            {
+                packed.push_back(P(*iter));
+            }
+
+            Acrs::Acrs acrs;
+            acrs.setEngine(static_cast<Acrs::Acrs::Engine>(engine));
+
+            agree = agree &&
+                    (acrs.summarize(full) == acrs.summarize(packed)) &&
+                    (listStr(full) == listStr(packed));
+
+            typename T::const_iterator iter = full.begin();
+
+            for (size_t i = 0; i < packed.size() && agree; i++, iter++)
+            {
+                agree = (packed[i].getAddrP() == iter->getAddrP());
+            }
+        }
+
+        return agree;
+    }
+
+    /* Summarize on one thread and on several with both engines. All
+     * results must match.
+     */
+    template <class T> static bool threadsAgree(const T & rt_list)
+    {
+        bool agree = true;
+        std::string expected;
+
+        for (int engine = 0; engine < 2; engine++)
+        {
+            for (unsigned int threads = 1; threads <= 4; threads += 3)
+            {
+                T result = rt_list;
+
+                Acrs::Acrs acrs;
+                acrs.setEngine(static_cast<Acrs::Acrs::Engine>(engine));
+                acrs.setThreads(threads);
+                acrs.summarize(result);
+
+                if (expected.empty() == true)
+                {
+                    expected = listStr(result);
+                }
+
+                agree = agree && (listStr(result) == expected);
+            }
+        }
+
+        return agree;
+    }
+
+public:
+    AcrsTest()
+    {
+        TEST_ADD(AcrsTest::mainSummary);
+        TEST_ADD(AcrsTest::overlapSummary);
+        TEST_ADD(AcrsTest::nestedOverlap);
+        TEST_ADD(AcrsTest::duplicates);
+        TEST_ADD(AcrsTest::enginesAgree4);
+        TEST_ADD(AcrsTest::enginesAgree6);
+        TEST_ADD(AcrsTest::vectorSummary);
+        TEST_ADD(AcrsTest::arraySummary);
+        TEST_ADD(AcrsTest::packedSummary4);
+        TEST_ADD(AcrsTest::packedSummary6);
+        TEST_ADD(AcrsTest::parallelSummary4);
+        TEST_ADD(AcrsTest::parallelSummary6);
+        TEST_ADD(AcrsTest::summaryStats);
+        TEST_ADD(AcrsTest::radixSort4);
+        TEST_ADD(AcrsTest::radixSort6);
+        TEST_ADD(AcrsTest::incrementalDelta);
+        TEST_ADD(AcrsTest::incrementalChurn);
+        TEST_ADD(AcrsTest::diffPrefixes);
+        TEST_ADD(AcrsTest::diffSpace);
+        TEST_ADD(AcrsTest::verifySummary);
+        TEST_ADD(AcrsTest::budgetSummary);
+        TEST_ADD(AcrsTest::ortcSummary);
+        TEST_ADD(AcrsTest::arenaSummary);
+        TEST_ADD(AcrsTest::memoryProfile);
+    }
+};
+
+#endif /* ACRSTEST_H */
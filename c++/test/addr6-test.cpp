@@ -47,3 +47,32 @@ void Addr6Test::getFuncs()
     TEST_ASSERT(addr.getHostmaskP() == "::7f");
     TEST_ASSERT(addr.getPlen() == 121);
 }
+
+void Addr6Test::setMaskFuncs()
+{
+    IP::Addr6 addr("2001:db8::1", 128);
+
+    TEST_ASSERT(addr.setMask("ffff:ffff::") == true);
+    TEST_ASSERT(addr.getPlen() == 32);
+
+    TEST_ASSERT(addr.setMask("ffff:ffff:ffff:ffff:8000::") == true);
+    TEST_ASSERT(addr.getPlen() == 65);
+    TEST_ASSERT(addr.getMaskP() == "ffff:ffff:ffff:ffff:8000::");
+
+    TEST_ASSERT(addr.setMask("ffff:ffff:ffff:ffff:ffff:ffff:ffff:fffe") == true);
+    TEST_ASSERT(addr.getPlen() == 127);
+
+    TEST_ASSERT(addr.setMask("::") == true);
+    TEST_ASSERT(addr.getPlen() == 0);
+
+    /* Holes in the mask, including in the last byte */
+    TEST_ASSERT(addr.setMask("ffff:0:ffff::") == false);
+    TEST_ASSERT(addr.setMask("ffff:ffff:ffff:ffff:ffff:ffff:ffff:fff1") == false);
+    TEST_ASSERT(addr.setMask("7fff::") == false);
+
+    for (uint32_t plen = 0; plen <= 128; plen++)
+    {
+        TEST_ASSERT(addr.setPlen(plen) == true);
+        TEST_ASSERT(addr.getPlen() == plen);
+    }
+}
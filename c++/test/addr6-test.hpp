@@ -17,6 +17,7 @@ private:
     void opOr();
     void opLessThan();
     void getFuncs();
+    void setMaskFuncs();
 
     /* Helper functions */
     static bool addr_equals(const IP::Addr6 & addr1,
@@ -28,6 +29,7 @@ public:
         TEST_ADD(Addr6Test::setAddrGood);
         TEST_ADD(Addr6Test::opLessThan);
         TEST_ADD(Addr6Test::getFuncs);
+        TEST_ADD(Addr6Test::setMaskFuncs);
     }
 };
 
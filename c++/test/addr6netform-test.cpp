@@ -72,6 +72,38 @@ void Addr6NetFormTest::op1Complement()
     TEST_ASSERT(addr_equals((~addr).getAddr(), base_addr) == true);
 }
 
+void Addr6NetFormTest::opCompare()
+{
+    in6_addr base_addr;
+
+    memset(base_addr.s6_addr, 0, sizeof(base_addr));
+    base_addr.s6_addr[7] = 0x01;
+    base_addr.s6_addr[15] = 0xff;
+
+    IP::Addr6NetForm low_addr(base_addr);
+
+    /* Differs only in the low half */
+    base_addr.s6_addr[8] = 0x01;
+    IP::Addr6NetForm mid_addr(base_addr);
+
+    /* Higher in the high half, lower in the low half */
+    base_addr.s6_addr[0] = 0x01;
+    base_addr.s6_addr[8] = 0x00;
+    base_addr.s6_addr[15] = 0x00;
+    IP::Addr6NetForm high_addr(base_addr);
+
+    TEST_ASSERT((low_addr < mid_addr) == true);
+    TEST_ASSERT((mid_addr < high_addr) == true);
+    TEST_ASSERT((low_addr < high_addr) == true);
+    TEST_ASSERT((high_addr < low_addr) == false);
+    TEST_ASSERT((high_addr > mid_addr) == true);
+    TEST_ASSERT((mid_addr > mid_addr) == false);
+    TEST_ASSERT((mid_addr < mid_addr) == false);
+    TEST_ASSERT((mid_addr == mid_addr) == true);
+    TEST_ASSERT((mid_addr == low_addr) == false);
+    TEST_ASSERT((mid_addr != high_addr) == true);
+}
+
 void Addr6NetFormTest::setAddrGood()
 {
     in6_addr addr;
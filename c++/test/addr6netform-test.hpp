@@ -16,6 +16,7 @@ private:
     void opAnd();
     void opOr();
     void op1Complement();
+    void opCompare();
 
     /* Helper functions */
     static bool addr_equals(const in6_addr & addr1, const in6_addr & addr2);
@@ -27,6 +28,7 @@ public:
         TEST_ADD(Addr6NetFormTest::opAnd);
         TEST_ADD(Addr6NetFormTest::opOr);
         TEST_ADD(Addr6NetFormTest::op1Complement);
+        TEST_ADD(Addr6NetFormTest::opCompare);
     }
 };
 
@@ -0,0 +1,111 @@
+/* cidrparse-test.cpp */
+
+#include <cstring>
+
+#include <arpa/inet.h>
+
+#include "../cidrparse.hpp"
+#include "cidrparse-test.hpp"
+
+void CidrParseTest::parse4()
+{
+    IP::Cidr4 cidr;
+    IP::ParseError err;
+    const char * text = "192.168.1.77/24m10";
+
+    TEST_ASSERT(IP::parseCidr4(text, strlen(text), cidr, err) == true);
+    TEST_ASSERT(cidr.addr == inet_addr("192.168.1.77"));
+    TEST_ASSERT(cidr.plen == 24);
+    TEST_ASSERT(cidr.metric == 10);
+
+    /* Only 'len' bytes are looked at */
+    TEST_ASSERT(IP::parseCidr4(text, 15, cidr, err) == true);
+    TEST_ASSERT(cidr.plen == 24);
+    TEST_ASSERT(cidr.metric == 0);
+
+    TEST_ASSERT(errorAt4("0.0.0.0/0") == -1);
+    TEST_ASSERT(errorAt4("255.255.255.255/32m65535") == -1);
+}
+
+void CidrParseTest::parse6()
+{
+    IP::Cidr6 cidr;
+    IP::ParseError err;
+    in6_addr expected;
+    const char * text = "2001:DB8::ffff:10.1.2.3/127m5";
+
+    inet_pton(AF_INET6, "2001:db8::ffff:a01:203", &expected);
+
+    TEST_ASSERT(IP::parseCidr6(text, strlen(text), cidr, err) == true);
+    TEST_ASSERT(memcmp(&cidr.addr, &expected, sizeof(expected)) == 0);
+    TEST_ASSERT(cidr.plen == 127);
+    TEST_ASSERT(cidr.metric == 5);
+
+    TEST_ASSERT(errorAt6("::/0") == -1);
+    TEST_ASSERT(errorAt6("::1/128") == -1);
+    TEST_ASSERT(errorAt6("1:2:3:4:5:6:7:8/64") == -1);
+}
+
+void CidrParseTest::errors()
+{
+    /* Offsets point at the first byte that is wrong */
+    TEST_ASSERT(errorAt4("10.0.0.0") == 8);
+    TEST_ASSERT(errorAt4("/24") == 0);
+    TEST_ASSERT(errorAt4("10.0.0.256/24") == 7);
+    TEST_ASSERT(errorAt4("10.0.00.0/24") == 5);
+    TEST_ASSERT(errorAt4("10.0.0/24") == 6);
+    TEST_ASSERT(errorAt4("10.0.0.0.0/24") == 8);
+    TEST_ASSERT(errorAt4("10.0.0.0/33") == 9);
+    TEST_ASSERT(errorAt4("10.0.0.0/") == 9);
+    TEST_ASSERT(errorAt4("10.0.0.0/m1") == 9);
+    TEST_ASSERT(errorAt4("10.0.0.0/24m") == 12);
+    TEST_ASSERT(errorAt4("10.0.0.0/24m1m") == 13);
+    TEST_ASSERT(errorAt4("10.0.0.0/24m65536") == 12);
+    TEST_ASSERT(errorAt4("10.0.0.0/24/1") == 11);
+    TEST_ASSERT(errorAt4("10.0.0.0/99999999999") == 9);
+
+    TEST_ASSERT(errorAt6("2001:db8:::/48") == 10);
+    TEST_ASSERT(errorAt6(":1::/48") == 0);
+    TEST_ASSERT(errorAt6("1::2::/48") == 5);
+    TEST_ASSERT(errorAt6("12345::/48") == 0);
+    TEST_ASSERT(errorAt6("1:2:3:4:5:6:7/64") == 13);
+    TEST_ASSERT(errorAt6("1:2:3:4:5:6:7:8:9/64") == 16);
+    TEST_ASSERT(errorAt6("2001:db8::g/64") == 10);
+    TEST_ASSERT(errorAt6("2001:db8::/129") == 11);
+}
+
+void CidrParseTest::matchesInetPton()
+{
+    const char * addrs[] =
+    {
+        "0.0.0.0", "1.2.3.4", "01.2.3.4", "1.2.3", "1.2.3.4.5", "256.1.1.1",
+        "1..2.3", "::", "::1", "1::", "1:2:3:4:5:6:7:8", "1:2:3:4:5:6:7::",
+        "::ffff:1.2.3.4", "1:2:3:4:5:6:1.2.3.4", "1:2:3:4:5:6:7:1.2.3.4",
+        "::1.2.3", "1:::2", "1:", ":1", "abcd:EF01::", "12345::"
+    };
+
+    for (unsigned int i = 0; i < sizeof(addrs) / sizeof(addrs[0]); i++)
+    {
+        in_addr_t addr4;
+        in6_addr addr6;
+        in6_addr expected;
+        IP::ParseError err;
+        size_t len = strlen(addrs[i]);
+
+        bool ok4 = IP::parseAddr4(addrs[i], len, addr4, err);
+        TEST_ASSERT(ok4 == (inet_pton(AF_INET, addrs[i], &expected) == 1));
+
+        if (ok4 == true)
+        {
+            TEST_ASSERT(memcmp(&addr4, &expected, sizeof(addr4)) == 0);
+        }
+
+        bool ok6 = IP::parseAddr6(addrs[i], len, addr6, err);
+        TEST_ASSERT(ok6 == (inet_pton(AF_INET6, addrs[i], &expected) == 1));
+
+        if (ok6 == true)
+        {
+            TEST_ASSERT(memcmp(&addr6, &expected, sizeof(addr6)) == 0);
+        }
+    }
+}
@@ -0,0 +1,60 @@
+/* cidrparse-test.hpp */
+
+#ifndef CIDRPARSETEST_H
+#define CIDRPARSETEST_H
+
+#include <cstring>
+
+#include <cpptest.h>
+
+#include "../cidrparse.hpp"
+
+class CidrParseTest : public Test::Suite
+{
+private:
+    /* Tests */
+    void parse4();
+    void parse6();
+    void errors();
+    void matchesInetPton();
+
+    /* Helper functions */
+
+    /* Offset of the error in 'text', or -1 if it parsed */
+    static long errorAt4(const char * text)
+    {
+        IP::Cidr4 cidr;
+        IP::ParseError err;
+
+        if (IP::parseCidr4(text, strlen(text), cidr, err) == true)
+        {
+            return -1;
+        }
+
+        return err.offset;
+    }
+
+    static long errorAt6(const char * text)
+    {
+        IP::Cidr6 cidr;
+        IP::ParseError err;
+
+        if (IP::parseCidr6(text, strlen(text), cidr, err) == true)
+        {
+            return -1;
+        }
+
+        return err.offset;
+    }
+
+public:
+    CidrParseTest()
+    {
+        TEST_ADD(CidrParseTest::parse4);
+        TEST_ADD(CidrParseTest::parse6);
+        TEST_ADD(CidrParseTest::errors);
+        TEST_ADD(CidrParseTest::matchesInetPton);
+    }
+};
+
+#endif /* CIDRPARSETEST_H */
@@ -0,0 +1,306 @@
+/* mrtreader-test.cpp */
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#include "../cidrparse.hpp"
+#include "../mrtreader.hpp"
+#include "mrtreader-test.hpp"
+
+enum
+{
+    TABLE_DUMP_V2 = 13,
+    PEER_INDEX_TABLE = 1,
+    RIB_IPV4_UNICAST = 2,
+    RIB_IPV4_MULTICAST = 3,
+    RIB_IPV6_UNICAST = 4,
+    RIB_GENERIC = 6,
+    RIB_IPV4_UNICAST_ADDPATH = 8,
+    BGP4MP = 16
+};
+
+void MrtReaderTest::put16(std::string & out, uint16_t value)
+{
+    out += (char) (value >> 8);
+    out += (char) value;
+}
+
+void MrtReaderTest::put32(std::string & out, uint32_t value)
+{
+    put16(out, value >> 16);
+    put16(out, value);
+}
+
+std::string MrtReaderTest::record(uint16_t type, uint16_t subtype,
+                                  const std::string & body)
+{
+    std::string out;
+
+    put32(out, 1300000000);
+    put16(out, type);
+    put16(out, subtype);
+    put32(out, body.size());
+
+    return out + body;
+}
+
+std::string MrtReaderTest::rib(uint16_t subtype, const char * prefix,
+                               const std::vector<std::string> & attrs)
+{
+    const char * p_slash = strchr(prefix, '/');
+    std::string addr(prefix, p_slash - prefix);
+    uint8_t plen = atoi(p_slash + 1);
+    unsigned char bytes[16];
+    std::string body;
+
+    bool ipv6 = (addr.find(':') != std::string::npos);
+    inet_pton(ipv6 ? AF_INET6 : AF_INET, addr.c_str(), bytes);
+
+    put32(body, 7);             /* Sequence number */
+
+    if (subtype == RIB_GENERIC)
+    {
+        put16(body, ipv6 ? 2 : 1);
+        body += (char) 1;       /* Unicast */
+    }
+
+    body += (char) plen;
+    body.append((const char *) bytes, (plen + 7) / 8);
+    put16(body, attrs.size());
+
+    for (size_t i = 0; i < attrs.size(); i++)
+    {
+        put16(body, i);         /* Peer index */
+        put32(body, 1300000000);
+
+        if (subtype == RIB_IPV4_UNICAST_ADDPATH)
+        {
+            put32(body, i + 1);
+        }
+
+        put16(body, attrs[i].size());
+        body += attrs[i];
+    }
+
+    return record(TABLE_DUMP_V2, subtype, body);
+}
+
+std::string MrtReaderTest::attrs(uint32_t med, uint8_t seg_type,
+                                 uint8_t seg_count)
+{
+    std::string out;
+
+    /* ORIGIN */
+    out += (char) 0x40;
+    out += (char) 1;
+    out += (char) 1;
+    out += (char) 0;
+
+    /* MULTI_EXIT_DISC */
+    out += (char) 0x80;
+    out += (char) 4;
+    out += (char) 4;
+    put32(out, med);
+
+    /* AS_PATH, with an extended length to check both forms */
+    out += (char) 0x50;
+    out += (char) 2;
+    put16(out, 2 + seg_count * 4);
+    out += (char) seg_type;
+    out += (char) seg_count;
+
+    for (uint8_t i = 0; i < seg_count; i++)
+    {
+        put32(out, 64512 + i);
+    }
+
+    return out;
+}
+
+std::vector<std::string> MrtReaderTest::readAll(
+                                const std::string & dump, int family,
+                                IP::MrtReader::MetricSource source)
+{
+    std::vector<std::string> found;
+    int fds[2];
+
+    /* Test dumps are small enough to fit in the pipe */
+    if (pipe(fds) != 0 ||
+        write(fds[1], dump.data(), dump.size()) != (ssize_t) dump.size())
+    {
+        found.push_back("error");
+        return found;
+    }
+
+    close(fds[1]);
+
+    IP::MrtReader reader(fds[0], source);
+    char buf[INET6_ADDRSTRLEN + 16];
+    char addr[INET6_ADDRSTRLEN];
+
+    while (true)
+    {
+        IP::Cidr4 cidr4;
+        IP::Cidr6 cidr6;
+        bool got;
+
+        if (family == 4)
+        {
+            got = reader.next(cidr4);
+            inet_ntop(AF_INET, &cidr4.addr, addr, sizeof(addr));
+        }
+        else
+        {
+            got = reader.next(cidr6);
+            cidr4.plen = cidr6.plen;
+            cidr4.metric = cidr6.metric;
+            inet_ntop(AF_INET6, &cidr6.addr, addr, sizeof(addr));
+        }
+
+        if (got == false)
+        {
+            break;
+        }
+
+        snprintf(buf, sizeof(buf), "%s/%um%d", addr, cidr4.plen,
+                 cidr4.metric);
+        found.push_back(buf);
+    }
+
+    if (reader.failed() == true)
+    {
+        found.push_back("error");
+    }
+
+    close(fds[0]);
+
+    return found;
+}
+
+void MrtReaderTest::ribEntries4()
+{
+    std::vector<std::string> one(1, attrs(0, 2, 1));
+    std::string dump;
+
+    dump += record(TABLE_DUMP_V2, PEER_INDEX_TABLE, std::string(16, '\0'));
+    dump += rib(RIB_IPV4_UNICAST, "10.0.0.0/8", one);
+    dump += record(BGP4MP, 4, std::string(40, '\0'));
+    dump += rib(RIB_IPV6_UNICAST, "2001:db8::/32", one);
+    dump += rib(RIB_IPV4_MULTICAST, "224.0.0.0/4", one);
+    dump += rib(RIB_IPV4_UNICAST_ADDPATH, "192.168.1.0/24", one);
+    dump += rib(RIB_GENERIC, "172.16.0.0/12", one);
+    dump += rib(RIB_IPV4_UNICAST, "0.0.0.0/0", one);
+    dump += rib(RIB_IPV4_UNICAST, "10.9.9.9/32", one);
+
+    /* A prefix with no entries has no route */
+    dump += rib(RIB_IPV4_UNICAST, "10.1.0.0/16", std::vector<std::string>());
+
+    std::vector<std::string> found = readAll(dump, 4,
+                                             IP::MrtReader::METRIC_NONE);
+
+    TEST_ASSERT(found.size() == 5);
+
+    if (found.size() == 5)
+    {
+        TEST_ASSERT(found[0] == "10.0.0.0/8m0");
+        TEST_ASSERT(found[1] == "192.168.1.0/24m0");
+        TEST_ASSERT(found[2] == "172.16.0.0/12m0");
+        TEST_ASSERT(found[3] == "0.0.0.0/0m0");
+        TEST_ASSERT(found[4] == "10.9.9.9/32m0");
+    }
+}
+
+void MrtReaderTest::ribEntries6()
+{
+    std::vector<std::string> one(1, attrs(5, 2, 3));
+    std::string dump;
+
+    dump += rib(RIB_IPV4_UNICAST, "10.0.0.0/8", one);
+    dump += rib(RIB_IPV6_UNICAST, "2001:db8::/32", one);
+    dump += rib(RIB_GENERIC, "2001:db8:1::/48", one);
+    dump += rib(RIB_IPV6_UNICAST, "::/0", one);
+    dump += rib(RIB_IPV6_UNICAST, "2001:db8::1/128", one);
+
+    std::vector<std::string> found = readAll(dump, 6,
+                                             IP::MrtReader::METRIC_MED);
+
+    TEST_ASSERT(found.size() == 4);
+
+    if (found.size() == 4)
+    {
+        TEST_ASSERT(found[0] == "2001:db8::/32m5");
+        TEST_ASSERT(found[1] == "2001:db8:1::/48m5");
+        TEST_ASSERT(found[2] == "::/0m5");
+        TEST_ASSERT(found[3] == "2001:db8::1/128m5");
+    }
+}
+
+void MrtReaderTest::metrics()
+{
+    std::vector<std::string> entries;
+    entries.push_back(attrs(300, 2, 4));        /* Sequence of 4 */
+    entries.push_back(attrs(20, 1, 5));         /* Set, counts as 1 */
+    entries.push_back(attrs(100, 2, 2));
+
+    std::vector<std::string> huge(1, attrs(0xffffffff, 2, 1));
+    std::string dump;
+
+    dump += rib(RIB_IPV4_UNICAST, "10.0.0.0/8", entries);
+    dump += rib(RIB_IPV4_UNICAST, "10.1.0.0/16", huge);
+
+    /* The lowest of the entries, clamped to the largest route metric */
+    std::vector<std::string> med = readAll(dump, 4,
+                                           IP::MrtReader::METRIC_MED);
+    std::vector<std::string> path = readAll(dump, 4,
+                                            IP::MrtReader::METRIC_AS_PATH);
+
+    TEST_ASSERT(med.size() == 2 && path.size() == 2);
+
+    if (med.size() == 2 && path.size() == 2)
+    {
+        TEST_ASSERT(med[0] == "10.0.0.0/8m20");
+        TEST_ASSERT(med[1] == "10.1.0.0/16m65535");
+        TEST_ASSERT(path[0] == "10.0.0.0/8m1");
+        TEST_ASSERT(path[1] == "10.1.0.0/16m1");
+    }
+}
+
+void MrtReaderTest::errors()
+{
+    std::vector<std::string> one(1, attrs(0, 2, 1));
+    std::string good = rib(RIB_IPV4_UNICAST, "10.0.0.0/8", one);
+    std::vector<std::string> found;
+
+    /* Cut off inside the header, and inside the body */
+    found = readAll(good + good.substr(0, 5), 4, IP::MrtReader::METRIC_NONE);
+    TEST_ASSERT(found.size() == 2 && found[1] == "error");
+
+    found = readAll(good + good.substr(0, 20), 4, IP::MrtReader::METRIC_NONE);
+    TEST_ASSERT(found.size() == 2 && found[1] == "error");
+
+    /* Prefix length 33 */
+    std::string bad = good;
+    bad[12 + 4] = 33;
+    found = readAll(bad, 4, IP::MrtReader::METRIC_NONE);
+    TEST_ASSERT(found.size() == 1 && found[0] == "error");
+
+    /* ORIGIN's length running past the entry, only noticed when the
+     * attributes are used. The attributes start after the 12 byte header,
+     * sequence number, prefix, entry count, peer index, time and length.
+     */
+    bad = good;
+    bad[12 + 4 + 2 + 2 + 2 + 4 + 2 + 2] = 0x30;
+    found = readAll(bad, 4, IP::MrtReader::METRIC_NONE);
+    TEST_ASSERT(found.size() == 1 && found[0] == "10.0.0.0/8m0");
+    found = readAll(bad, 4, IP::MrtReader::METRIC_MED);
+    TEST_ASSERT(found.size() == 1 && found[0] == "error");
+
+    found = readAll("", 4, IP::MrtReader::METRIC_NONE);
+    TEST_ASSERT(found.empty() == true);
+}
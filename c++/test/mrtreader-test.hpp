@@ -0,0 +1,60 @@
+/* mrtreader-test.hpp */
+
+#ifndef MRTREADERTEST_H
+#define MRTREADERTEST_H
+
+#include <string>
+#include <vector>
+
+#include <inttypes.h>
+#include <cpptest.h>
+
+#include "../mrtreader.hpp"
+
+class MrtReaderTest : public Test::Suite
+{
+private:
+    /* Tests */
+    void ribEntries4();
+    void ribEntries6();
+    void metrics();
+    void errors();
+
+    /* Helper functions */
+
+    /* Big endian fields appended to 'out' */
+    static void put16(std::string & out, uint16_t value);
+    static void put32(std::string & out, uint32_t value);
+
+    /* An MRT record of 'type' and 'subtype' around 'body' */
+    static std::string record(uint16_t type, uint16_t subtype,
+                              const std::string & body);
+
+    /* A TABLE_DUMP_V2 RIB record for 'prefix' (in ADDR/PLEN form) with one
+     * entry per element of 'attrs', the entries' path attributes
+     */
+    static std::string rib(uint16_t subtype, const char * prefix,
+                           const std::vector<std::string> & attrs);
+
+    /* Path attributes holding a MED and an AS_PATH of one segment */
+    static std::string attrs(uint32_t med, uint8_t seg_type,
+                             uint8_t seg_count);
+
+    /* Every prefix of 'family' read from 'dump', as ADDR/PLENmMETRIC, or
+     * "error" if the reader failed
+     */
+    static std::vector<std::string> readAll(const std::string & dump,
+                                            int family,
+                                            IP::MrtReader::MetricSource source);
+
+public:
+    MrtReaderTest()
+    {
+        TEST_ADD(MrtReaderTest::ribEntries4);
+        TEST_ADD(MrtReaderTest::ribEntries6);
+        TEST_ADD(MrtReaderTest::metrics);
+        TEST_ADD(MrtReaderTest::errors);
+    }
+};
+
+#endif /* MRTREADERTEST_H */
@@ -0,0 +1,215 @@
+/* routegen-test.cpp */
+
+#include <vector>
+#include <set>
+#include <cstring>
+#include <utility>
+
+#include "../route4packed.hpp"
+#include "../route6packed.hpp"
+#include "../routegen.hpp"
+#include "routegen-test.hpp"
+
+typedef std::pair<uint32_t, uint32_t> Prefix4;
+
+static Prefix4 prefix(const IP::Route4Packed & rt)
+{
+    return Prefix4(rt.getNetworkH(), rt.getPlen());
+}
+
+void RouteGenTest::repeatable()
+{
+    IP::RouteGenerator generator;
+    std::vector<IP::Route4Packed> first;
+    std::vector<IP::Route4Packed> second;
+
+    generator.setSeed(42);
+    generator.setMetrics(4);
+    generator.setDuplicates(10);
+    generator.generate(10000, first);
+    generator.generate(10000, second);
+
+    TEST_ASSERT(first.size() == 10000);
+    TEST_ASSERT(memcmp(&first[0], &second[0],
+                       first.size() * sizeof(first[0])) == 0);
+
+    /* Shuffled, the same routes in another order */
+    std::vector<IP::Route4Packed> shuffled;
+    std::multiset<std::pair<Prefix4, int> > before;
+    std::multiset<std::pair<Prefix4, int> > after;
+
+    generator.setShuffle(true);
+    generator.generate(10000, shuffled);
+
+    for (size_t i = 0; i < first.size(); i++)
+    {
+        before.insert(std::make_pair(prefix(first[i]), first[i].getMetric()));
+        after.insert(std::make_pair(prefix(shuffled[i]),
+                                    shuffled[i].getMetric()));
+    }
+
+    TEST_ASSERT(before == after);
+    TEST_ASSERT(memcmp(&first[0], &shuffled[0],
+                       first.size() * sizeof(first[0])) != 0);
+
+    /* Another seed, another table */
+    generator.setShuffle(false);
+    generator.setSeed(43);
+    generator.generate(10000, second);
+
+    TEST_ASSERT(memcmp(&first[0], &second[0],
+                       first.size() * sizeof(first[0])) != 0);
+}
+
+void RouteGenTest::full()
+{
+    IP::RouteGenerator generator;
+    std::vector<IP::Route4Packed> routes4;
+    std::vector<IP::Route6Packed> routes6;
+    size_t slash24 = 0;
+    size_t slash48 = 0;
+
+    generator.setMetrics(3);
+    generator.generate(20000, routes4);
+    generator.generate(20000, routes6);
+
+    TEST_ASSERT(routes4.size() == 20000);
+    TEST_ASSERT(routes6.size() == 20000);
+
+    for (size_t i = 0; i < routes4.size(); i++)
+    {
+        uint32_t first_octet = routes4[i].getAddrH() >> 24;
+
+        /* Unicast networks without host bits */
+        TEST_ASSERT(first_octet >= 1 && first_octet <= 223);
+        TEST_ASSERT(routes4[i].getAddrH() == routes4[i].getNetworkH());
+        TEST_ASSERT(routes4[i].getPlen() >= 8);
+        TEST_ASSERT(routes4[i].getMetric() >= 0 &&
+                    routes4[i].getMetric() < 3);
+
+        slash24 += (routes4[i].getPlen() == 24);
+    }
+
+    for (size_t i = 0; i < routes6.size(); i++)
+    {
+        TEST_ASSERT((routes6[i].getAddrHi() >> 61) == 1);
+        TEST_ASSERT(routes6[i].getAddrHi() == routes6[i].getNetworkHi());
+        TEST_ASSERT(routes6[i].getAddrLo() == 0);
+
+        slash48 += (routes6[i].getPlen() == 48);
+    }
+
+    /* Over half are /24s or /48s, as in a full table */
+    TEST_ASSERT(slash24 > 10000 && slash24 < 13000);
+    TEST_ASSERT(slash48 > 10000 && slash48 < 13000);
+}
+
+void RouteGenTest::siblings()
+{
+    IP::RouteGenerator generator;
+    std::vector<IP::Route4Packed> routes;
+    size_t adjacent = 0;
+
+    generator.setShape(IP::RouteGenerator::SHAPE_SIBLINGS);
+    generator.setMetrics(8);
+    generator.generate(100000, routes);
+
+    for (size_t i = 0; i < routes.size(); i++)
+    {
+        TEST_ASSERT(routes[i].getPlen() == 24);
+
+        if (i > 0 &&
+            routes[i].getAddrH() == routes[i - 1].getAddrH() + 256)
+        {
+            TEST_ASSERT(routes[i].getMetric() == routes[i - 1].getMetric());
+            adjacent++;
+        }
+    }
+
+    /* Runs of up to 65536, so few routes start one */
+    TEST_ASSERT(adjacent > 99000);
+
+    /* Runs start on a boundary of their own size */
+    std::vector<IP::Route6Packed> routes6;
+    generator.setSeed(2);
+    generator.generate(3, routes6);
+
+    TEST_ASSERT(routes6[0].getPlen() == 48);
+    TEST_ASSERT(((routes6[0].getAddrHi() >> 16) & 1) == 0);
+}
+
+void RouteGenTest::nested()
+{
+    IP::RouteGenerator generator;
+    std::vector<IP::Route4Packed> routes;
+
+    generator.setShape(IP::RouteGenerator::SHAPE_NESTED);
+    generator.generate(10000, routes);
+
+    /* Each route is inside the one before, or starts a chain */
+    size_t chains = 0;
+
+    for (size_t i = 0; i < routes.size(); i++)
+    {
+        if (i > 0 && routes[i].getPlen() == routes[i - 1].getPlen() + 1)
+        {
+            uint32_t mask = ~(uint32_t) 0 << (32 - routes[i - 1].getPlen());
+
+            TEST_ASSERT((routes[i].getAddrH() & mask) ==
+                        routes[i - 1].getAddrH());
+        }
+        else
+        {
+            TEST_ASSERT(routes[i].getPlen() >= 8 &&
+                        routes[i].getPlen() < 16);
+            TEST_ASSERT(i == 0 || routes[i - 1].getPlen() == 32);
+            chains++;
+        }
+    }
+
+    TEST_ASSERT(chains >= 10000 / 25);
+}
+
+void RouteGenTest::duplicates()
+{
+    IP::RouteGenerator generator;
+    std::vector<IP::Route4Packed> routes;
+    std::set<Prefix4> seen;
+    size_t other_metric = 0;
+
+    generator.setMetrics(2);
+    generator.setDuplicates(100);
+    generator.generate(10000, routes);
+
+    /* Every other route repeats an earlier prefix */
+    for (size_t i = 0; i < routes.size(); i += 2)
+    {
+        seen.insert(prefix(routes[i]));
+
+        if (i + 1 < routes.size())
+        {
+            TEST_ASSERT(seen.count(prefix(routes[i + 1])) == 1);
+        }
+    }
+
+    for (size_t i = 1; i < routes.size(); i += 2)
+    {
+        for (size_t j = 0; j < i; j += 2)
+        {
+            if (prefix(routes[j]) == prefix(routes[i]))
+            {
+                other_metric += (routes[j].getMetric() !=
+                                 routes[i].getMetric());
+                break;
+            }
+        }
+
+        if (i > 2000)
+        {
+            break;
+        }
+    }
+
+    /* About half have another metric */
+    TEST_ASSERT(other_metric > 350 && other_metric < 650);
+}
@@ -0,0 +1,31 @@
+/* routegen-test.hpp */
+
+#ifndef ROUTEGENTEST_H
+#define ROUTEGENTEST_H
+
+#include <cpptest.h>
+
+#include "../routegen.hpp"
+
+class RouteGenTest : public Test::Suite
+{
+private:
+    /* Tests */
+    void repeatable();
+    void full();
+    void siblings();
+    void nested();
+    void duplicates();
+
+public:
+    RouteGenTest()
+    {
+        TEST_ADD(RouteGenTest::repeatable);
+        TEST_ADD(RouteGenTest::full);
+        TEST_ADD(RouteGenTest::siblings);
+        TEST_ADD(RouteGenTest::nested);
+        TEST_ADD(RouteGenTest::duplicates);
+    }
+};
+
+#endif /* ROUTEGENTEST_H */
@@ -0,0 +1,239 @@
+/* routelookup-test.cpp */
+
+#include <string>
+#include <vector>
+#include <cstring>
+
+#include <arpa/inet.h>
+
+#include "../route4packed.hpp"
+#include "../route6packed.hpp"
+#include "../routelookup.hpp"
+#include "routelookup-test.hpp"
+
+std::string RouteLookupTest::match(const IP::RouteLookup4 & lookup,
+                                   const char * addr)
+{
+    uint32_t index = lookup.lookup(inet_addr(addr));
+
+    return (index == IP::RouteLookup4::NONE) ? "none" :
+                                               lookup.getRoute(index).str();
+}
+
+std::string RouteLookupTest::match(const IP::RouteLookup6 & lookup,
+                                   const char * addr)
+{
+    in6_addr addr6;
+    inet_pton(AF_INET6, addr, &addr6);
+
+    uint32_t index = lookup.lookup(addr6);
+
+    return (index == IP::RouteLookup6::NONE) ? "none" :
+                                               lookup.getRoute(index).str();
+}
+
+void RouteLookupTest::lookup4()
+{
+    IP::RouteLookup4 lookup;
+
+    TEST_ASSERT(match(lookup, "10.0.0.1") == "none");
+
+    lookup.add(IP::Route4("10.0.0.0", 8, IP::PLEN, 2));
+    lookup.add(IP::Route4("10.1.0.0", 16, IP::PLEN));
+    lookup.add(IP::Route4("10.1.2.128", 25, IP::PLEN, 1));
+    lookup.add(IP::Route4("10.1.2.129", 32, IP::PLEN));
+    lookup.add(IP::Route4("192.168.0.0", 24, IP::PLEN, 3));
+    lookup.add(IP::Route4("192.168.0.0", 24, IP::PLEN, 1));
+    lookup.build();
+
+    TEST_ASSERT(match(lookup, "9.255.255.255") == "none");
+    TEST_ASSERT(match(lookup, "10.200.0.1") == "10.0.0.0/8 in 2");
+    TEST_ASSERT(match(lookup, "10.1.2.3") == "10.1.0.0/16 in 0");
+    TEST_ASSERT(match(lookup, "10.1.2.127") == "10.1.0.0/16 in 0");
+    TEST_ASSERT(match(lookup, "10.1.2.128") == "10.1.2.128/25 in 1");
+    TEST_ASSERT(match(lookup, "10.1.2.129") == "10.1.2.129/32 in 0");
+    TEST_ASSERT(match(lookup, "10.1.2.255") == "10.1.2.128/25 in 1");
+
+    /* The lowest metric wins for a prefix given twice */
+    TEST_ASSERT(match(lookup, "192.168.0.77") == "192.168.0.0/24 in 1");
+
+    /* A default route is only used where nothing longer matches, and
+     * routes added later need another build()
+     */
+    lookup.add(IP::Route4("0.0.0.0", 0, IP::PLEN, 9));
+    TEST_ASSERT(match(lookup, "1.2.3.4") == "none");
+
+    lookup.build();
+    TEST_ASSERT(match(lookup, "1.2.3.4") == "0.0.0.0/0 in 9");
+    TEST_ASSERT(match(lookup, "10.1.2.129") == "10.1.2.129/32 in 0");
+    TEST_ASSERT(lookup.size() == 7);
+
+    lookup.clear();
+    TEST_ASSERT(match(lookup, "1.2.3.4") == "none");
+}
+
+void RouteLookupTest::lookup6()
+{
+    IP::RouteLookup6 lookup;
+
+    TEST_ASSERT(match(lookup, "2001:db8::1") == "none");
+
+    lookup.add(IP::Route6("2001:db8::", 32, IP::PLEN, 2));
+    lookup.add(IP::Route6("2001:db8:1::", 48, IP::PLEN));
+    lookup.add(IP::Route6("2001:db8:1::", 49, IP::PLEN, 1));
+    lookup.add(IP::Route6("2001:db8:1::ff", 128, IP::PLEN));
+    lookup.add(IP::Route6("2001:db8:1::fe", 127, IP::PLEN, 3));
+    lookup.add(IP::Route6("fe80::", 10, IP::PLEN, 4));
+    lookup.add(IP::Route6("fe80::", 10, IP::PLEN, 3));
+    lookup.build();
+
+    TEST_ASSERT(match(lookup, "::1") == "none");
+    TEST_ASSERT(match(lookup, "2001:db8:ffff::1") == "2001:db8::/32 in 2");
+    TEST_ASSERT(match(lookup, "2001:db8:1:8000::1") ==
+                "2001:db8:1::/48 in 0");
+    TEST_ASSERT(match(lookup, "2001:db8:1::1") == "2001:db8:1::/49 in 1");
+    TEST_ASSERT(match(lookup, "2001:db8:1::fe") == "2001:db8:1::fe/127 in 3");
+    TEST_ASSERT(match(lookup, "2001:db8:1::ff") == "2001:db8:1::ff/128 in 0");
+    TEST_ASSERT(match(lookup, "2001:db8:1::100") == "2001:db8:1::/49 in 1");
+    TEST_ASSERT(match(lookup, "febf::1") == "fe80::/10 in 3");
+    TEST_ASSERT(match(lookup, "fec0::1") == "none");
+
+    lookup.add(IP::Route6("::", 0, IP::PLEN, 9));
+    lookup.build();
+
+    TEST_ASSERT(match(lookup, "::1") == "::/0 in 9");
+    TEST_ASSERT(match(lookup, "2001:db8:1::ff") == "2001:db8:1::ff/128 in 0");
+}
+
+void RouteLookupTest::batch4()
+{
+    IP::RouteLookup4 lookup;
+    std::vector<IP::Route4Packed> routes;
+    std::vector<in_addr_t> addrs;
+    uint32_t seed = 4;
+
+    /* Prefixes of 10.0/16 of every length from /12 to /32 */
+    for (int i = 0; i < 2000; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        IP::Route4Packed rt(htonl(0x0a000000 | (seed >> 12)),
+                            12 + (seed >> 4) % 21, (seed >> 2) % 3);
+        routes.push_back(rt);
+        lookup.add(rt);
+    }
+
+    for (int i = 0; i < 5000; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        addrs.push_back(htonl(0x0a000000 | (seed >> 10)));
+    }
+
+    lookup.build();
+
+    std::vector<uint32_t> found(addrs.size());
+    lookup.lookup(&addrs[0], addrs.size(), &found[0]);
+
+    /* Batches give the same answers as single lookups, and those are
+     * the longest match with the lowest metric
+     */
+    bool agree = true;
+
+    for (size_t i = 0; i < addrs.size() && agree; i++)
+    {
+        uint32_t addr = ntohl(addrs[i]);
+        uint32_t best = IP::RouteLookup4::NONE;
+
+        for (uint32_t r = 0; r < routes.size(); r++)
+        {
+            uint32_t plen = routes[r].getPlen();
+
+            if ((addr & (~(uint32_t) 0 << (32 - plen))) !=
+                routes[r].getNetworkH())
+            {
+                continue;
+            }
+
+            if (best == IP::RouteLookup4::NONE ||
+                plen > routes[best].getPlen() ||
+                (plen == routes[best].getPlen() &&
+                 routes[r].getMetric() < routes[best].getMetric()))
+            {
+                best = r;
+            }
+        }
+
+        agree = (found[i] == lookup.lookup(addrs[i]));
+        agree = agree && (best == IP::RouteLookup4::NONE ?
+                          found[i] == best :
+                          (found[i] != IP::RouteLookup4::NONE &&
+                           routes[found[i]].str() == routes[best].str()));
+    }
+
+    TEST_ASSERT(agree == true);
+}
+
+void RouteLookupTest::batch6()
+{
+    IP::RouteLookup6 lookup;
+    std::vector<IP::Route6Packed> routes;
+    std::vector<in6_addr> addrs;
+    uint32_t seed = 6;
+
+    /* Prefixes of 2001:db8::/32 near its start, of lengths 32 to 128 */
+    for (int i = 0; i < 2000; i++)
+    {
+        in6_addr addr;
+        inet_pton(AF_INET6, "2001:db8::", &addr);
+
+        seed = seed * 1103515245 + 12345;
+        addr.s6_addr[4] = seed >> 24;
+        addr.s6_addr[15] = seed >> 16;
+
+        seed = seed * 1103515245 + 12345;
+        IP::Route6Packed rt(addr, 32 + (seed >> 8) % 97, (seed >> 4) % 3);
+        routes.push_back(rt);
+        lookup.add(rt);
+
+        addr.s6_addr[15] ^= seed >> 28;
+        addrs.push_back(addr);
+    }
+
+    lookup.build();
+
+    std::vector<uint32_t> found(addrs.size());
+    lookup.lookup(&addrs[0], addrs.size(), &found[0]);
+
+    bool agree = true;
+
+    for (size_t i = 0; i < addrs.size() && agree; i++)
+    {
+        uint32_t best = IP::RouteLookup6::NONE;
+
+        for (uint32_t r = 0; r < routes.size(); r++)
+        {
+            IP::Route6Packed covering(addrs[i], routes[r].getPlen());
+
+            if (covering.getNetworkHi() != routes[r].getNetworkHi() ||
+                covering.getNetworkLo() != routes[r].getNetworkLo())
+            {
+                continue;
+            }
+
+            if (best == IP::RouteLookup6::NONE ||
+                routes[r].getPlen() > routes[best].getPlen() ||
+                (routes[r].getPlen() == routes[best].getPlen() &&
+                 routes[r].getMetric() < routes[best].getMetric()))
+            {
+                best = r;
+            }
+        }
+
+        agree = (found[i] == lookup.lookup(addrs[i]));
+        agree = agree && (best == IP::RouteLookup6::NONE ?
+                          found[i] == best :
+                          (found[i] != IP::RouteLookup6::NONE &&
+                           routes[found[i]].str() == routes[best].str()));
+    }
+
+    TEST_ASSERT(agree == true);
+}
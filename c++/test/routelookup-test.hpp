@@ -0,0 +1,39 @@
+/* routelookup-test.hpp */
+
+#ifndef ROUTELOOKUPTEST_H
+#define ROUTELOOKUPTEST_H
+
+#include <string>
+
+#include <cpptest.h>
+
+#include "../routelookup.hpp"
+
+class RouteLookupTest : public Test::Suite
+{
+private:
+    /* Tests */
+    void lookup4();
+    void lookup6();
+    void batch4();
+    void batch6();
+
+    /* Helper functions */
+
+    /* The route 'addr' matches in 'lookup', as text, or "none" */
+    static std::string match(const IP::RouteLookup4 & lookup,
+                             const char * addr);
+    static std::string match(const IP::RouteLookup6 & lookup,
+                             const char * addr);
+
+public:
+    RouteLookupTest()
+    {
+        TEST_ADD(RouteLookupTest::lookup4);
+        TEST_ADD(RouteLookupTest::lookup6);
+        TEST_ADD(RouteLookupTest::batch4);
+        TEST_ADD(RouteLookupTest::batch6);
+    }
+};
+
+#endif /* ROUTELOOKUPTEST_H */
@@ -0,0 +1,76 @@
+/* routepacked-test.cpp */
+
+#include <string>
+
+#include "../route4.hpp"
+#include "../route6.hpp"
+#include "../route4packed.hpp"
+#include "../route6packed.hpp"
+#include "routepacked-test.hpp"
+
+void RoutePackedTest::convert4()
+{
+    IP::Route4 rt("192.168.1.77", 24, IP::PLEN, 10);
+    IP::Route4Packed packed(rt);
+
+    TEST_ASSERT(packed.str() == rt.str());
+    TEST_ASSERT(packed.getAddrP() == "192.168.1.77");
+    TEST_ASSERT(packed.getNetworkP() == "192.168.1.0");
+
+    /* Round trip keeps the host bits */
+    IP::Route4 back = packed.toRoute();
+    TEST_ASSERT(back.isValid() == true);
+    TEST_ASSERT(back.getAddrP() == rt.getAddrP());
+    TEST_ASSERT(back.str() == rt.str());
+
+    TEST_ASSERT(packed.setPlen(33) == false);
+    TEST_ASSERT(packed.setMetric(IP::Route::MAX_METRIC + 1) == false);
+    TEST_ASSERT(packed.str() == rt.str());
+}
+
+void RoutePackedTest::convert6()
+{
+    IP::Route6 rt("2001:db8:ffff::1", 33, IP::PLEN, 65535);
+    IP::Route6Packed packed(rt);
+
+    TEST_ASSERT(packed.str() == rt.str());
+    TEST_ASSERT(packed.getAddrP() == "2001:db8:ffff::1");
+    TEST_ASSERT(packed.getNetworkP() == "2001:db8:8000::");
+
+    IP::Route6 back = packed.toRoute();
+    TEST_ASSERT(back.getAddrP() == rt.getAddrP());
+    TEST_ASSERT(back.str() == rt.str());
+}
+
+void RoutePackedTest::netForms4()
+{
+    const uint32_t plens[] = { 0, 1, 17, 31, 32 };
+
+    for (unsigned int i = 0; i < sizeof(plens) / sizeof(plens[0]); i++)
+    {
+        IP::Route4 rt("10.200.3.129", plens[i], IP::PLEN);
+        IP::Route4Packed packed(rt);
+
+        TEST_ASSERT(packed.getNetworkN() == rt.getNetworkN());
+        TEST_ASSERT(packed.getMaskN() == rt.getMaskN());
+        TEST_ASSERT(packed.getBroadcastN() == rt.getBroadcastN());
+        TEST_ASSERT(packed.getHostmaskN() == rt.getHostmaskN());
+    }
+}
+
+void RoutePackedTest::netForms6()
+{
+    const uint32_t plens[] = { 0, 1, 63, 64, 65, 127, 128 };
+
+    for (unsigned int i = 0; i < sizeof(plens) / sizeof(plens[0]); i++)
+    {
+        IP::Route6 rt("2001:db8:1234:5678:9abc:def0:1234:5678", plens[i],
+                      IP::PLEN);
+        IP::Route6Packed packed(rt);
+
+        TEST_ASSERT(packed.getNetworkN() == rt.getNetworkN());
+        TEST_ASSERT(packed.getMaskN() == rt.getMaskN());
+        TEST_ASSERT(packed.getBroadcastN() == rt.getBroadcastN());
+        TEST_ASSERT(packed.getHostmaskN() == rt.getHostmaskN());
+    }
+}
@@ -0,0 +1,30 @@
+/* routepacked-test.hpp */
+
+#ifndef ROUTEPACKEDTEST_H
+#define ROUTEPACKEDTEST_H
+
+#include <cpptest.h>
+
+#include "../route4packed.hpp"
+#include "../route6packed.hpp"
+
+class RoutePackedTest : public Test::Suite
+{
+private:
+    /* Tests */
+    void convert4();
+    void convert6();
+    void netForms4();
+    void netForms6();
+
+public:
+    RoutePackedTest()
+    {
+        TEST_ADD(RoutePackedTest::convert4);
+        TEST_ADD(RoutePackedTest::convert6);
+        TEST_ADD(RoutePackedTest::netForms4);
+        TEST_ADD(RoutePackedTest::netForms6);
+    }
+};
+
+#endif /* ROUTEPACKEDTEST_H */
@@ -0,0 +1,241 @@
+/* routetable-test.cpp */
+
+#include <string>
+#include <cstring>
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+
+#include "../route4packed.hpp"
+#include "../route6packed.hpp"
+#include "../routetable.hpp"
+#include "routetable-test.hpp"
+
+std::string RouteTableTest::save(IP::RouteTableWriter & writer)
+{
+    char path[] = "/tmp/routetable-test.XXXXXX";
+    int fd = mkstemp(path);
+
+    if (fd < 0)
+    {
+        return "";
+    }
+
+    bool ok = writer.write(fd);
+    close(fd);
+
+    if (ok == false)
+    {
+        unlink(path);
+        return "";
+    }
+
+    return path;
+}
+
+bool RouteTableTest::damage(const std::string & path, size_t offset,
+                            bool truncate)
+{
+    if (truncate == true)
+    {
+        return ::truncate(path.c_str(), offset) == 0;
+    }
+
+    int fd = open(path.c_str(), O_RDWR);
+    unsigned char byte;
+    bool ok = false;
+
+    if (fd >= 0 && pread(fd, &byte, 1, offset) == 1)
+    {
+        byte ^= 0x01;
+        ok = (pwrite(fd, &byte, 1, offset) == 1);
+    }
+
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+
+    return ok;
+}
+
+void RouteTableTest::roundTrip4()
+{
+    IP::RouteTableWriter writer;
+
+    /* Out of order on purpose, one with host bits */
+    writer.add(IP::Route4Packed(inet_addr("10.1.0.0"), 16, 3));
+    writer.add(IP::Route4Packed(inet_addr("10.0.0.0"), 8, 1));
+    writer.add(IP::Route4Packed(inet_addr("192.168.1.7"), 24, 2));
+    writer.add(IP::Route4Packed(inet_addr("10.0.0.0"), 8, 0));
+
+    std::string path = save(writer);
+    TEST_ASSERT(path.empty() == false);
+
+    IP::RouteTable table;
+    IP::Route4Packed * p_routes = NULL;
+    size_t count = 0;
+
+    TEST_ASSERT(table.load(path.c_str()) == true);
+    TEST_ASSERT(table.getFamily() == 4);
+    TEST_ASSERT(table.size() == 4);
+    TEST_ASSERT(table.getRoutes(p_routes, count) == true);
+    TEST_ASSERT(count == 4);
+
+    if (count == 4)
+    {
+        TEST_ASSERT(p_routes[0].str() == "10.0.0.0/8 in 0");
+        TEST_ASSERT(p_routes[1].str() == "10.0.0.0/8 in 1");
+        TEST_ASSERT(p_routes[2].str() == "10.1.0.0/16 in 3");
+        TEST_ASSERT(p_routes[3].getAddrP() == "192.168.1.7");
+        TEST_ASSERT(p_routes[3].getPlen() == 24);
+        TEST_ASSERT(p_routes[3].getMetric() == 2);
+
+        /* The mapping is private, so the file is left as it was */
+        p_routes[0].setMetric(9);
+        TEST_ASSERT(table.load(path.c_str()) == true);
+        TEST_ASSERT(table.getRoutes(p_routes, count) == true);
+        TEST_ASSERT(p_routes[0].getMetric() == 0);
+    }
+
+    unlink(path.c_str());
+
+    /* An empty table is valid */
+    IP::RouteTableWriter empty;
+    path = save(empty);
+
+    TEST_ASSERT(table.load(path.c_str()) == true);
+    TEST_ASSERT(table.size() == 0);
+
+    unlink(path.c_str());
+}
+
+void RouteTableTest::roundTrip6()
+{
+    const char * addrs[] =
+    {
+        "2001:db8:1::", "2001:db8::", "::", "2001:db8::1"
+    };
+    uint32_t plens[] = { 48, 32, 0, 128 };
+    const char * expect[] =
+    {
+        "::/0 in 0", "2001:db8::/32 in 0", "2001:db8::1/128 in 0",
+        "2001:db8:1::/48 in 0"
+    };
+
+    IP::RouteTableWriter writer;
+
+    for (int i = 0; i < 4; i++)
+    {
+        in6_addr addr;
+        inet_pton(AF_INET6, addrs[i], &addr);
+        writer.add(IP::Route6Packed(addr, plens[i]));
+    }
+
+    std::string path = save(writer);
+    TEST_ASSERT(path.empty() == false);
+
+    IP::RouteTable table;
+    IP::Route6Packed * p_routes = NULL;
+    size_t count = 0;
+
+    TEST_ASSERT(table.load(path.c_str()) == true);
+    TEST_ASSERT(table.getFamily() == 6);
+    TEST_ASSERT(table.getRoutes(p_routes, count) == true);
+    TEST_ASSERT(count == 4);
+
+    for (size_t i = 0; i < count && i < 4; i++)
+    {
+        TEST_ASSERT(p_routes[i].str() == expect[i]);
+    }
+
+    unlink(path.c_str());
+
+    /* An empty table keeps the family it was given */
+    IP::RouteTableWriter empty;
+    empty.setFamily(6);
+    path = save(empty);
+
+    TEST_ASSERT(table.load(path.c_str()) == true);
+    TEST_ASSERT(table.getFamily() == 6);
+    TEST_ASSERT(table.size() == 0);
+    TEST_ASSERT(table.getRoutes(p_routes, count) == true);
+    TEST_ASSERT(count == 0);
+
+    unlink(path.c_str());
+}
+
+void RouteTableTest::rejectsDamage()
+{
+    IP::RouteTableWriter writer;
+
+    for (int i = 0; i < 16; i++)
+    {
+        writer.add(IP::Route4Packed(htonl(0x0a000000 + (i << 8)), 24, i));
+    }
+
+    IP::RouteTable table;
+    std::string path = save(writer);
+
+    TEST_ASSERT(table.load(path.c_str()) == true);
+
+    /* A flipped bit in a record */
+    TEST_ASSERT(damage(path, IP::RouteTable::HEADER_SIZE + 20, false));
+    TEST_ASSERT(table.load(path.c_str()) == false);
+    TEST_ASSERT(strcmp(table.getError(), "checksum mismatch") == 0);
+    TEST_ASSERT(table.size() == 0);
+
+    /* The magic */
+    TEST_ASSERT(damage(path, IP::RouteTable::HEADER_SIZE + 20, false));
+    TEST_ASSERT(table.load(path.c_str()) == true);
+    TEST_ASSERT(damage(path, 0, false));
+    TEST_ASSERT(table.load(path.c_str()) == false);
+    TEST_ASSERT(damage(path, 0, false));
+
+    /* The version */
+    TEST_ASSERT(damage(path, 12, false));
+    TEST_ASSERT(table.load(path.c_str()) == false);
+    TEST_ASSERT(damage(path, 12, false));
+
+    /* A record cut short, and a header cut short */
+    TEST_ASSERT(damage(path, IP::RouteTable::HEADER_SIZE + 12, true));
+    TEST_ASSERT(table.load(path.c_str()) == false);
+    TEST_ASSERT(damage(path, 10, true));
+    TEST_ASSERT(table.load(path.c_str()) == false);
+
+    unlink(path.c_str());
+
+    TEST_ASSERT(table.load("/nonexistent/routes.tbl") == false);
+}
+
+void RouteTableTest::wrongFamily()
+{
+    IP::RouteTableWriter writer;
+    writer.add(IP::Route4Packed(inet_addr("10.0.0.0"), 8));
+
+    IP::RouteTable table;
+    IP::Route6Packed * p_routes = NULL;
+    size_t count = 0;
+    std::string path = save(writer);
+
+    TEST_ASSERT(table.load(path.c_str()) == true);
+    TEST_ASSERT(table.getRoutes(p_routes, count) == false);
+
+    unlink(path.c_str());
+
+    /* Both families can't go in one table */
+    in6_addr addr;
+    inet_pton(AF_INET6, "2001:db8::", &addr);
+    writer.add(IP::Route6Packed(addr, 32));
+
+    TEST_ASSERT(save(writer).empty() == true);
+
+    /* Nor routes of the other family to the one set */
+    IP::RouteTableWriter writer6;
+    writer6.setFamily(6);
+    writer6.add(IP::Route4Packed(inet_addr("10.0.0.0"), 8));
+
+    TEST_ASSERT(save(writer6).empty() == true);
+}
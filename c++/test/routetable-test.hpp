@@ -0,0 +1,44 @@
+/* routetable-test.hpp */
+
+#ifndef ROUTETABLETEST_H
+#define ROUTETABLETEST_H
+
+#include <string>
+
+#include <cpptest.h>
+
+#include "../routetable.hpp"
+
+class RouteTableTest : public Test::Suite
+{
+private:
+    /* Tests */
+    void roundTrip4();
+    void roundTrip6();
+    void rejectsDamage();
+    void wrongFamily();
+
+    /* Helper functions */
+
+    /* Write 'writer' to a new temporary file and return its path, or ""
+     * if that failed
+     */
+    static std::string save(IP::RouteTableWriter & writer);
+
+    /* Replace the byte at 'offset' in the file at 'path', or cut the file
+     * to 'offset' bytes if 'truncate' is true
+     */
+    static bool damage(const std::string & path, size_t offset,
+                       bool truncate);
+
+public:
+    RouteTableTest()
+    {
+        TEST_ADD(RouteTableTest::roundTrip4);
+        TEST_ADD(RouteTableTest::roundTrip6);
+        TEST_ADD(RouteTableTest::rejectsDamage);
+        TEST_ADD(RouteTableTest::wrongFamily);
+    }
+};
+
+#endif /* ROUTETABLETEST_H */
@@ -0,0 +1,145 @@
+/* routewriter-test.cpp */
+
+#include <string>
+#include <cstring>
+
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#include "../route4.hpp"
+#include "../route6.hpp"
+#include "../route4packed.hpp"
+#include "../route6packed.hpp"
+#include "../routewriter.hpp"
+#include "routewriter-test.hpp"
+
+template <class R> std::string RouteWriterTest::written(
+                                    const R & rt,
+                                    IP::RouteWriter::Style style)
+{
+    int fds[2];
+    char buf[128];
+
+    if (pipe(fds) != 0)
+    {
+        return "";
+    }
+
+    {
+        IP::RouteWriter writer(fds[1], style);
+        writer.write(rt);
+    }
+
+    close(fds[1]);
+    ssize_t got = read(fds[0], buf, sizeof(buf));
+    close(fds[0]);
+
+    return std::string(buf, (got > 0) ? got : 0);
+}
+
+void RouteWriterTest::formatAddr4()
+{
+    const char * addrs[] =
+    {
+        "0.0.0.0", "1.2.3.4", "10.200.3.129", "255.255.255.255"
+    };
+
+    for (unsigned int i = 0; i < sizeof(addrs) / sizeof(addrs[0]); i++)
+    {
+        char buf[16];
+        size_t len = IP::RouteWriter::formatAddr4(buf,
+                                                  ntohl(inet_addr(addrs[i])));
+
+        TEST_ASSERT(std::string(buf, len) == addrs[i]);
+    }
+}
+
+void RouteWriterTest::formatAddr6()
+{
+    /* Each in the form inet_ntop() gives */
+    const char * addrs[] =
+    {
+        "::", "::1", "1::", "2001:db8::", "2001:db8::1:0:0:1",
+        "2001:0:0:1::1", "1:2:3:4:5:6:7:8", "::ffff:10.1.2.3",
+        "::10.1.2.3", "::ffff:0:a01:203", "fe80::204:61ff:fe9d:f156"
+    };
+
+    for (unsigned int i = 0; i < sizeof(addrs) / sizeof(addrs[0]); i++)
+    {
+        in6_addr addr;
+        uint64_t hi = 0;
+        uint64_t lo = 0;
+        char buf[40];
+
+        inet_pton(AF_INET6, addrs[i], &addr);
+
+        for (int byte = 0; byte < 8; byte++)
+        {
+            hi = (hi << 8) | addr.s6_addr[byte];
+            lo = (lo << 8) | addr.s6_addr[byte + 8];
+        }
+
+        size_t len = IP::RouteWriter::formatAddr6(buf, hi, lo);
+
+        TEST_ASSERT(std::string(buf, len) == addrs[i]);
+    }
+}
+
+void RouteWriterTest::styles4()
+{
+    IP::Route4 rt("192.168.1.77", 24, IP::PLEN, 10);
+    IP::Route4Packed packed(rt);
+
+    TEST_ASSERT(written(rt, IP::RouteWriter::METRIC_NONE) ==
+                rt.IP::Addr::str() + "\n");
+    TEST_ASSERT(written(rt, IP::RouteWriter::METRIC_FULL) == rt.str() + "\n");
+    TEST_ASSERT(written(rt, IP::RouteWriter::METRIC_BRIEF) ==
+                "192.168.1.77/24m10\n");
+    TEST_ASSERT(written(packed, IP::RouteWriter::METRIC_FULL) ==
+                rt.str() + "\n");
+}
+
+void RouteWriterTest::styles6()
+{
+    IP::Route6 rt("2001:db8:ffff::1", 33, IP::PLEN, 65535);
+    IP::Route6Packed packed(rt);
+
+    TEST_ASSERT(written(rt, IP::RouteWriter::METRIC_NONE) ==
+                "2001:db8:8000::/33\n");
+    TEST_ASSERT(written(rt, IP::RouteWriter::METRIC_FULL) == rt.str() + "\n");
+    TEST_ASSERT(written(rt, IP::RouteWriter::METRIC_BRIEF) ==
+                "2001:db8:ffff::1/33m65535\n");
+    TEST_ASSERT(written(packed, IP::RouteWriter::METRIC_BRIEF) ==
+                "2001:db8:ffff::1/33m65535\n");
+}
+
+void RouteWriterTest::marks()
+{
+    IP::Route6Packed rt(IP::Route6("2001:db8::", 32, IP::PLEN, 2));
+    int fds[2];
+    char buf[128];
+
+    TEST_ASSERT(pipe(fds) == 0);
+
+    {
+        IP::RouteWriter writer(fds[1], IP::RouteWriter::METRIC_BRIEF);
+        writer.setMark('-');
+        writer.write(rt);
+        writer.setMark('+');
+        writer.write(rt);
+        writer.setMark('\0');
+        writer.write(rt);
+        writer.writeText("query ", 6);
+        writer.write(rt);
+    }
+
+    close(fds[1]);
+    ssize_t got = read(fds[0], buf, sizeof(buf));
+    close(fds[0]);
+
+    TEST_ASSERT(std::string(buf, (got > 0) ? got : 0) ==
+                "- 2001:db8::/32m2\n"
+                "+ 2001:db8::/32m2\n"
+                "2001:db8::/32m2\n"
+                "query 2001:db8::/32m2\n");
+}
@@ -0,0 +1,39 @@
+/* routewriter-test.hpp */
+
+#ifndef ROUTEWRITERTEST_H
+#define ROUTEWRITERTEST_H
+
+#include <string>
+
+#include <cpptest.h>
+
+#include "../routewriter.hpp"
+
+class RouteWriterTest : public Test::Suite
+{
+private:
+    /* Tests */
+    void formatAddr4();
+    void formatAddr6();
+    void styles4();
+    void styles6();
+    void marks();
+
+    /* Helper functions */
+
+    /* Everything 'rt' writes in 'style', read back through a pipe */
+    template <class R> static std::string written(const R & rt,
+                                                  IP::RouteWriter::Style style);
+
+public:
+    RouteWriterTest()
+    {
+        TEST_ADD(RouteWriterTest::formatAddr4);
+        TEST_ADD(RouteWriterTest::formatAddr6);
+        TEST_ADD(RouteWriterTest::styles4);
+        TEST_ADD(RouteWriterTest::styles6);
+        TEST_ADD(RouteWriterTest::marks);
+    }
+};
+
+#endif /* ROUTEWRITERTEST_H */
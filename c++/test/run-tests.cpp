@@ -4,16 +4,40 @@
 
 #include "addr6netform-test.hpp"
 #include "addr6-test.hpp"
+#include "acrs-test.hpp"
+#include "routepacked-test.hpp"
+#include "cidrparse-test.hpp"
+#include "routewriter-test.hpp"
+#include "routetable-test.hpp"
+#include "mrtreader-test.hpp"
+#include "routelookup-test.hpp"
+#include "routegen-test.hpp"
 
 int main()
 {
     Addr6NetFormTest addr6netform_test;
     Addr6Test addr6_test;
+    AcrsTest acrs_test;
+    RoutePackedTest routepacked_test;
+    CidrParseTest cidrparse_test;
+    RouteWriterTest routewriter_test;
+    RouteTableTest routetable_test;
+    MrtReaderTest mrtreader_test;
+    RouteLookupTest routelookup_test;
+    RouteGenTest routegen_test;
 
     Test::TextOutput output(Test::TextOutput::Verbose);
 
     addr6netform_test.run(output);
     addr6_test.run(output);
+    acrs_test.run(output);
+    routepacked_test.run(output);
+    cidrparse_test.run(output);
+    routewriter_test.run(output);
+    routetable_test.run(output);
+    mrtreader_test.run(output);
+    routelookup_test.run(output);
+    routegen_test.run(output);
 
     return 0;
 }